@@ -9,21 +9,38 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "shader.h"
-#include "cylinder.h"
+#include "staticMeshCache.h"
 #include "camera.h"
-
+#include "lights.h"
+#include "clusteredLights.h"
+#include "renderQueue.h"
+#include "instancedMesh.h"
+#include "common/boundingVolumeHierarchy.h"
+#include "common/glState.h"
+#include "textureCache.h"
+#include "benchmarks.h"
+
+#include <algorithm>
 #include <iostream>
+#include <random>
+#include <string>
+#include <vector>
 
 //callbacks
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char* path);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
+const size_t TEXTURE_UPLOAD_BUDGET = 8 * 1024 * 1024; // decoded texture bytes uploaded per frame at most
+const bool TEXTURE_COMPRESSION = true; // cook textures into BC1/BC3/BC4/BC5 blocks (4-8x less video memory)
+const char* const TEXTURE_CACHE_DIRECTORY = "texturecache"; // cooked textures are written here on first load ("" = always decode)
+const int PROP_GRID_SIZE = 16; // props per side of the instanced prop grid on the floor (16 = 256 props in one draw, 0 = no props)
+const int NUM_CLUSTERED_LIGHTS = 256; // small colored point lights scattered over the floor, shaded per cluster (0 = none)
 
 // camera
 Camera camera(glm::vec3(0.0f, -2.0f, 8.0f));
@@ -38,8 +55,34 @@ float lastFrame = 0.0f;
 // lighting
 glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
-int main()
+// debugging
+bool printStatistics = false; // P toggles printing of render queue, state and cluster statistics whenever they change, and of picked objects
+bool drawProps = true; // I toggles the instanced prop grid
+bool useClusteredLights = true; // L toggles the clustered floor lights (switches the lighting variant)
+
+// uniforms the render loop sets on a lighting variant, resolved whenever another variant gets selected
+struct LightingUniforms
+{
+	UniformHandle viewPos, shininess, projection, view, model, normalMatrix, clusterTileScale, clusterDepthParams;
+
+	void resolve(const Shader& shader)
+	{
+		viewPos = shader.getUniform("viewPos");
+		shininess = shader.getUniform("material.shininess");
+		projection = shader.getUniform("projection");
+		view = shader.getUniform("view");
+		model = shader.getUniform("model");
+		normalMatrix = shader.getUniform("normalMatrix");
+		clusterTileScale = shader.getUniform("clusterTileScale");
+		clusterDepthParams = shader.getUniform("clusterDepthParams");
+	}
+};
+
+int main(int argc, char* argv[])
 {
+	// "--bench [name [arguments...]]" runs benchmarks in a hidden window instead of the scene
+	const bool isBenchmark = argc > 1 && std::string(argv[1]) == BENCHMARK_ARGUMENT;
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -50,6 +93,8 @@ int main()
 #ifdef __APPLE__
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+	if (isBenchmark)
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
 	// glfw window creation
 	// --------------------
@@ -65,6 +110,7 @@ int main()
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
+	glfwSetKeyCallback(window, key_callback);
 
 	// tell GLFW to capture our mouse
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -77,13 +123,36 @@ int main()
 		return -1;
 	}
 
+	// linked shader programs are cached in "shadercache", so only the first launch compiles them
+	ProgramBinaryCache::initialize((ProgramBinaryCache::LoadProc)glfwGetProcAddress);
+
+	if (isBenchmark)
+	{
+		const int result = runBenchmarks(argc > 2 ? argv[2] : "", std::vector<std::string>(argv + std::min(argc, 3), argv + argc));
+		glfwTerminate();
+		return result;
+	}
+
 	// configure global opengl state
 	// -----------------------------
-	glEnable(GL_DEPTH_TEST);
+	GLState::enable(GL_DEPTH_TEST);
 
 	// build and compile our shader zprogram
 	// ------------------------------------
-	Shader lightingShader("shaderfiles/6.multiple_lights.vs", "shaderfiles/6.multiple_lights.fs");
+	// lighting program is compiled once per light permutation (see LightPermutation), every variant gets
+	// the light block and samplers connected right after it's built
+	ShaderVariants lightingShaders("shaderfiles/6.multiple_lights.vs", "shaderfiles/6.multiple_lights.fs", [](Shader& shader) {
+		LightBlockBuffer::bindToProgram(shader.ID);
+		ClusteredLights::bindToProgram(shader.ID);
+		shader.use();
+		shader.setInt("material.diffuseMap", 0);
+		shader.setInt("material.specularMap", 1);
+		shader.setInt("material.bowlMap", 2);
+		shader.setInt("material.innerMap", 3);
+		shader.setInt("material.anotherMap", 4);
+		shader.setInt("material.blackMap", 5);
+		shader.setInt("material.whiteMap", 6);
+	});
 	Shader lightCubeShader("shaderfiles/6.light_cube.vs", "shaderfiles/6.light_cube.fs");
 
 	// set up vertex data (and buffer(s)) and configure vertex attributes
@@ -299,10 +368,10 @@ int main()
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-	glBindVertexArray(VAO);
+	GLState::bindVertexArray(VAO);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
@@ -315,10 +384,10 @@ int main()
 	glGenVertexArrays(1, &mirrorVAO);
 	glGenBuffers(1, &mirrorVBO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, mirrorVBO);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, mirrorVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(mirrorVertices), mirrorVertices, GL_STATIC_DRAW);
 
-	glBindVertexArray(mirrorVAO);
+	GLState::bindVertexArray(mirrorVAO);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
@@ -330,18 +399,18 @@ int main()
 	unsigned int VBO2, VAO2;
 	glGenVertexArrays(1, &VAO2);
 	glGenBuffers(1, &VBO2);
-	glBindVertexArray(VAO2);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO2);
+	GLState::bindVertexArray(VAO2);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, VBO2);
 
 	//pyramind + cube
 	unsigned int topVBO, topVAO; //pyramid
 	glGenVertexArrays(1, &topVAO);
 	glGenBuffers(1, &topVBO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, topVBO);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, topVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(topVertices), topVertices, GL_STATIC_DRAW);
 
-	glBindVertexArray(topVAO);
+	GLState::bindVertexArray(topVAO);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
@@ -353,10 +422,10 @@ int main()
 	glGenVertexArrays(1, &bottomVAO);
 	glGenBuffers(1, &bottomVBO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, bottomVBO);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, bottomVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(bottomVertices), bottomVertices, GL_STATIC_DRAW);
 
-	glBindVertexArray(bottomVAO);
+	GLState::bindVertexArray(bottomVAO);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
@@ -365,27 +434,165 @@ int main()
 	glEnableVertexAttribArray(2);
 
 
-	// load textures (we now use a utility function to keep the code more organized)
-	// -----------------------------------------------------------------------------
-	unsigned int diffuseMap = loadTexture("images/blonde.jpg");
-	unsigned int specularMap = loadTexture("images/blondeBW.jpg");
-	unsigned int bowlMap = loadTexture("images/marble2.jpg");
-	unsigned int innerMap = loadTexture("images/bowlinner.jpg");
-	unsigned int anotherMap = loadTexture("images/newbrick.jpg");
-	unsigned int blackMap = loadTexture("images/blackflowers.jpg");
-	unsigned int whiteMap = loadTexture("images/whitebrick.jpg");
-
-	// shader configuration
-	// --------------------
-	lightingShader.use();
-	lightingShader.setInt("material.diffuseMap", 0);
-	lightingShader.setInt("material.specularMap", 1);
-	lightingShader.setInt("material.bowlMap", 2);
-	lightingShader.setInt("material.innerMap", 3);
-	lightingShader.setInt("material.anotherMap", 4);
-	lightingShader.setInt("material.blackMap", 5);
-	lightingShader.setInt("material.whiteMap", 6);
-
+	// load textures (decoded in the background, placeholders are shown until they are uploaded)
+	// images are cooked in the background on first load, later launches just map the cooked files and upload them
+	// -------------------------------------------------------------------------------------------------------------
+	AsyncTextureLoader textureLoader;
+	textureLoader.setCooking(TEXTURE_CACHE_DIRECTORY, TEXTURE_COMPRESSION);
+	TextureCache textureCache(textureLoader);
+	auto diffuseMap = textureCache.get("images/blonde.jpg");
+	auto specularMap = textureCache.get("images/blondeBW.jpeg", false); // specular intensities are linear
+	auto bowlMap = textureCache.get("images/marble2.jpg");
+	auto innerMap = textureCache.get("images/bowlinner.jpg");
+	auto anotherMap = textureCache.get("images/newbrick.jpg");
+	auto blackMap = textureCache.get("images/blackflowers.jpg");
+	auto whiteMap = textureCache.get("images/whitebrick.jpg");
+
+
+	// lights live in a uniform buffer, shared by all programs declaring LightBlock
+	LightBlockBuffer lightBlock;
+	lightBlock.createBuffer();
+
+	//colors for lights
+	glm::vec3 pointLightColors[] = {
+	glm::vec3(1.0f, 1.0f, 1.0f), //WHITE
+	glm::vec3(0.6f, 0.0f, 0.8f)  //PURPLE
+	};
+	//#1 is white point light, #2 is purple point pink, spot light is also white
+	// point light 1
+	PointLight pointLight;
+	pointLight.position = pointLightPositions[0];
+	pointLight.ambient = pointLightColors[0] * 0.8f;
+	pointLight.diffuse = pointLightColors[0] * 0.8f;
+	pointLight.specular = pointLightColors[0] * 0.8f;
+	pointLight.constant = 0.0f;
+	pointLight.linear = 0.09f;
+	pointLight.quadratic = 0.032f;
+	lightBlock.setPointLight(0, pointLight);
+	// point light 2
+	pointLight.position = pointLightPositions[1];
+	pointLight.ambient = pointLightColors[1] * 0.5f;
+	pointLight.diffuse = pointLightColors[1] * 0.5f;
+	pointLight.specular = pointLightColors[1] * 0.5f;
+	pointLight.constant = 1.0f;
+	pointLight.linear = 0.09f;
+	pointLight.quadratic = 0.032f;
+	lightBlock.setPointLight(1, pointLight);
+	// only two point lights are set, the lighting variant evaluates just those
+	// spotLight
+	SpotLight spotLight;
+	spotLight.ambient = pointLightColors[0] * 0.7f;
+	spotLight.diffuse = pointLightColors[0] * 0.7f;
+	spotLight.specular = pointLightColors[0] * 0.7f;
+	spotLight.constant = 1.0f;
+	spotLight.linear = 0.09f;
+	spotLight.quadratic = 0.032f;
+	spotLight.cutOff = glm::cos(glm::radians(12.5f));
+	spotLight.outerCutOff = glm::cos(glm::radians(20.0f));
+	// many small lights don't fit the light block, they're assigned to clusters of the view every frame
+	// and the lighting variant evaluates only the lights of the fragment's cluster
+	ClusteredLights clusteredLights;
+	clusteredLights.createBuffers();
+	if (NUM_CLUSTERED_LIGHTS > 0)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<PointLight> floorLights(NUM_CLUSTERED_LIGHTS);
+		for (auto& floorLight : floorLights)
+		{
+			const auto color = glm::vec3(unit(random), unit(random), unit(random));
+			floorLight.position = glm::vec3(-4.0f + 8.0f * unit(random), -3.8f, -4.0f + 8.0f * unit(random));
+			// steep falloff keeps the range of every light about 1 unit, so a cluster gets only the few lights near it
+			floorLight.ambient = color * 0.02f;
+			floorLight.diffuse = color * 0.5f;
+			floorLight.specular = color * 0.5f;
+			floorLight.constant = 1.0f;
+			floorLight.linear = 0.0f;
+			floorLight.quadratic = 200.0f;
+		}
+		clusteredLights.setPointLights(floorLights);
+	}
+	ClusteredLights::Statistics lastClusterStatistics;
+
+	// per-frame uniforms are resolved whenever another lighting variant gets selected, the render loop sets them by handle
+	Shader* lightingShader = nullptr;
+	Shader* instancedLightingShader = nullptr;
+	LightPermutation lightingPermutation;
+	LightingUniforms lightingUniforms, instancedLightingUniforms;
+
+	// cylinder meshes are built once and shared through the cache
+	static_meshes_3D::StaticMeshCache meshCache;
+	auto bowlOuter = meshCache.getCylinder(1.1f, 30, 0.4f, true, true, true);
+	auto bowlInner = meshCache.getCylinder(0.9f, 30, 0.41f, true, true, true);
+
+	// draw packets of the scene objects, program, model and normal matrix uniform locations are filled in every frame,
+	// because they depend on the selected lighting variant. specular map stays on unit 1 for all of them
+	std::vector<DrawPacket> scenePackets;
+	std::vector<std::string> sceneNames; // name of every packet, printed when it's picked
+	auto addScenePacket = [&](const std::string& name, GLuint texture, GLuint vao, const glm::mat4& model, const DrawRange& range, const MeshBounds& bounds) {
+		DrawPacket packet;
+		packet.textures[0] = texture;
+		packet.textures[1] = specularMap->getID();
+		packet.vao = vao;
+		packet.model = model;
+		packet.range = range;
+		packet.bounds = bounds;
+		scenePackets.push_back(packet);
+		sceneNames.push_back(name);
+	};
+	// bounds of the first vertices of an array with 8 floats per vertex, position first
+	auto arrayBounds = [](const float* vertexData, GLsizei numVertices) {
+		return MeshBounds::fromPositions(vertexData, 8 * sizeof(float), numVertices);
+	};
+	// floor
+	addScenePacket("floor", diffuseMap->getID(), VAO, glm::mat4(1.0f), DrawRange::arrays(GL_TRIANGLES, 0, 6), arrayBounds(vertices, 6));
+	// mirror
+	glm::mat4 mirrorModel = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, -1.99f, -1.0f));
+	mirrorModel = glm::rotate(mirrorModel, glm::radians(20.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+	addScenePacket("mirror", blackMap->getID(), mirrorVAO, mirrorModel, DrawRange::arrays(GL_TRIANGLES, 0, 72), arrayBounds(mirrorVertices, 72));
+	// pyramid top and cube bottom
+	const glm::mat4 pedestalModel = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, -2.84f, -1.0f));
+	addScenePacket("pedestal top", anotherMap->getID(), topVAO, pedestalModel, DrawRange::arrays(GL_TRIANGLES, 0, 18), arrayBounds(topVertices, 18));
+	addScenePacket("pedestal bottom", whiteMap->getID(), bottomVAO, pedestalModel, DrawRange::arrays(GL_TRIANGLES, 0, 36), arrayBounds(bottomVertices, 36));
+	// bowl cylinders
+	const glm::mat4 bowlModel = glm::translate(glm::mat4(1.0f), glm::vec3(-2.0f, -3.79f, 1.0f));
+	addScenePacket("bowl outside", bowlMap->getID(), bowlOuter->getVAO(), bowlModel, DrawRange::indexedMesh(*bowlOuter, GL_TRIANGLE_STRIP), bowlOuter->getBounds());
+	addScenePacket("bowl inside", innerMap->getID(), bowlInner->getVAO(), bowlModel, DrawRange::indexedMesh(*bowlInner, GL_TRIANGLE_STRIP), bowlInner->getBounds());
+	// repeated props, all of them are drawn with one instanced draw (model matrices live in the instance buffer)
+	auto propMesh = meshCache.getCylinder(0.1f, 12, 0.3f, true, true, true);
+	InstancedMesh props(*propMesh, GL_TRIANGLE_STRIP);
+	props.createBuffer();
+	for (int z = 0; z < PROP_GRID_SIZE; z++)
+	{
+		for (int x = 0; x < PROP_GRID_SIZE; x++)
+			props.addInstance(glm::translate(glm::mat4(1.0f), glm::vec3((x - PROP_GRID_SIZE / 2) * 0.5f, -3.85f, (z - PROP_GRID_SIZE / 2) * 0.5f)));
+	}
+	props.upload();
+	DrawPacket propPacket;
+	propPacket.textures[0] = bowlMap->getID();
+	propPacket.textures[1] = specularMap->getID();
+	props.fillPacket(propPacket);
+	// hierarchy over world space boxes of the scene objects, user data is the packet index (props are one object after
+	// the scene packets). it culls whole subtrees against the view and picks the object under the crosshair. objects
+	// without bounds would never pass its tests, they're kept aside and drawn every frame
+	BoundingVolumeHierarchy sceneBVH;
+	std::vector<uint32_t> unboundedObjects;
+	auto addSceneObject = [&](const DrawPacket& packet, uint32_t object) {
+		if (packet.bounds.box.isEmpty())
+			unboundedObjects.push_back(object);
+		else
+			sceneBVH.insert(packet.bounds.box.transformed(packet.model), object);
+	};
+	for (size_t i = 0; i < scenePackets.size(); i++)
+		addSceneObject(scenePackets[i], static_cast<uint32_t>(i));
+	if (props.getNumInstances() > 0)
+		addSceneObject(propPacket, static_cast<uint32_t>(scenePackets.size()));
+	sceneBVH.rebuild();
+	std::vector<uint32_t> visibleObjects;
+	bool wasPickPressed = false;
+	RenderQueue renderQueue;
+	RenderQueue::Statistics lastRenderStatistics;
+	GLState::Statistics lastStateStatistics;
 
 	// render loop
 	// -----------
@@ -401,143 +608,139 @@ int main()
 		// -----
 		processInput(window);
 
+		// left click prints the object in the middle of the screen (cursor is captured, so it's along the camera front)
+		const bool isPickPressed = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+		if (printStatistics && isPickPressed && !wasPickPressed)
+		{
+			BoundingVolumeHierarchy::RayHit hit;
+			if (!sceneBVH.raycast(camera.Position, camera.Front, 100.0f, hit))
+				std::cout << "Picked nothing" << std::endl;
+			else
+				std::cout << "Picked " << (hit.userData < sceneNames.size() ? sceneNames[hit.userData] : "props") << " at distance " << hit.distance << std::endl;
+		}
+		wasPickPressed = isPickPressed;
+
+		// upload textures decoded since the last frame (limited, so that one frame doesn't take all of them)
+		if (textureCache.update(TEXTURE_UPLOAD_BUDGET) > 0 && textureLoader.getNumPending() == 0)
+			textureCache.printMemoryUsage();
+
 		// render
 		// ------
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// only the spot light follows the camera, rest of the light block has been uploaded already
+		spotLight.position = camera.Position;
+		spotLight.direction = camera.Front;
+		lightBlock.setSpotLight(spotLight);
+		lightBlock.upload();
+
+		// clustered lights are part of the permutation while they're switched on
+		const bool hasClusteredLights = useClusteredLights && clusteredLights.getNumLights() > 0;
+		if (lightBlock.getPermutation().hasClusteredLights != hasClusteredLights)
+		{
+			auto permutation = lightBlock.getPermutation();
+			permutation.hasClusteredLights = hasClusteredLights;
+			lightBlock.setPermutation(permutation);
+		}
+
+		// select the lighting variant for the lights that are present (compiled on first use)
+		if (lightingShader == nullptr || lightBlock.getPermutation() != lightingPermutation)
+		{
+			lightingPermutation = lightBlock.getPermutation();
+			lightingShader = &lightingShaders.get(lightingPermutation.getDefines());
+			lightingUniforms.resolve(*lightingShader);
+			// props use the same variant compiled with INSTANCED
+			if (props.getNumInstances() > 0)
+			{
+				auto instancedDefines = lightingPermutation.getDefines();
+				instancedDefines.push_back("INSTANCED");
+				instancedLightingShader = &lightingShaders.get(instancedDefines);
+				instancedLightingUniforms.resolve(*instancedLightingShader);
+			}
+		}
+
 		// be sure to activate shader when setting uniforms/drawing objects
-		lightingShader.use();
-		lightingShader.setVec3("viewPos", camera.Position);
-		lightingShader.setFloat("material.shininess", 32.0f);
-
-		//colors for lights
-		glm::vec3 pointLightColors[] = {
-		glm::vec3(1.0f, 1.0f, 1.0f), //WHITE
-		glm::vec3(0.6f, 0.0f, 0.8f)  //PURPLE
-		};
-		//uniforms for lights, #1 is white point light, #2 is purple point pink, spot light is also white
-		// point light 1
-		lightingShader.setVec3("pointLights[0].position", pointLightPositions[0].x, pointLightPositions[0].y, pointLightPositions[0].z);
-		lightingShader.setVec3("pointLights[0].ambient", pointLightColors[0].x * 0.8, pointLightColors[0].y * 0.8, pointLightColors[0].z * 0.8);
-		lightingShader.setVec3("pointLights[0].diffuse", pointLightColors[0].x * 0.8, pointLightColors[0].y * 0.8, pointLightColors[0].z * 0.8);
-		lightingShader.setVec3("pointLights[0].specular", pointLightColors[0].x * 0.8, pointLightColors[0].y * 0.8, pointLightColors[0].z * 0.8);
-		lightingShader.setFloat("pointLights[0].constant", 0.0f);
-		lightingShader.setFloat("pointLights[0].linear", 0.09);
-		lightingShader.setFloat("pointLights[0].quadratic", 0.032);
-		// point light 2
-		lightingShader.setVec3("pointLights[1].position", pointLightPositions[1].x, pointLightPositions[1].y, pointLightPositions[1].z);
-		lightingShader.setVec3("pointLights[1].ambient", pointLightColors[1].x * 0.5, pointLightColors[1].y * 0.5, pointLightColors[1].z * 0.5);
-		lightingShader.setVec3("pointLights[1].diffuse", pointLightColors[1].x * 0.5, pointLightColors[1].y * 0.5, pointLightColors[1].z * 0.5);
-		lightingShader.setVec3("pointLights[1].specular", pointLightColors[1].x * 0.5, pointLightColors[1].y * 0.5, pointLightColors[1].z * 0.5);
-		lightingShader.setFloat("pointLights[1].constant", 1.0f);
-		lightingShader.setFloat("pointLights[1].linear", 0.09);
-		lightingShader.setFloat("pointLights[1].quadratic", 0.032);
-		// point light 3
-		lightingShader.setVec3("pointLights[2].position", pointLightPositions[2]);
-		lightingShader.setVec3("pointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-		lightingShader.setVec3("pointLights[2].diffuse", 0.8f, 0.8f, 0.8f);
-		lightingShader.setVec3("pointLights[2].specular", 1.0f, 1.0f, 1.0f);
-		lightingShader.setFloat("pointLights[2].constant", 1.0f);
-		lightingShader.setFloat("pointLights[2].linear", 0.09);
-		lightingShader.setFloat("pointLights[2].quadratic", 0.032);
-		// point light 4
-		lightingShader.setVec3("pointLights[3].position", pointLightPositions[3]);
-		lightingShader.setVec3("pointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-		lightingShader.setVec3("pointLights[3].diffuse", 0.8f, 0.8f, 0.8f);
-		lightingShader.setVec3("pointLights[3].specular", 1.0f, 1.0f, 1.0f);
-		lightingShader.setFloat("pointLights[3].constant", 1.0f);
-		lightingShader.setFloat("pointLights[3].linear", 0.09);
-		lightingShader.setFloat("pointLights[3].quadratic", 0.032);
-		// spotLight
-		lightingShader.setVec3("spotLight.position", camera.Position);
-		lightingShader.setVec3("spotLight.direction", camera.Front);
-		lightingShader.setVec3("spotLight.ambient", pointLightColors[0].x * 0.7, pointLightColors[0].y * 0.7, pointLightColors[0].z * 0.7);
-		lightingShader.setVec3("spotLight.diffuse", pointLightColors[0].x * 0.7, pointLightColors[0].y * 0.7, pointLightColors[0].z * 0.7);
-		lightingShader.setVec3("spotLight.specular", pointLightColors[0].x * 0.7, pointLightColors[0].y * 0.7, pointLightColors[0].z * 0.7);
-		lightingShader.setFloat("spotLight.constant", 1.0f);
-		lightingShader.setFloat("spotLight.linear", 0.09);
-		lightingShader.setFloat("spotLight.quadratic", 0.032);
-		lightingShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-		lightingShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(20.0f)));
+		lightingShader->use();
+		lightingShader->setVec3(lightingUniforms.viewPos, camera.Position);
+		lightingShader->setFloat(lightingUniforms.shininess, 32.0f);
 
 
 		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
 		glm::mat4 view = camera.GetViewMatrix();
-		lightingShader.setMat4("projection", projection);
-		lightingShader.setMat4("view", view);
-
-		// world transformation
-		glm::mat4 model = glm::mat4(1.0f);
-		lightingShader.setMat4("model", model);
-
-		// bind diffuse map
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
-		// bind specular map
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, specularMap);
-
-		// draw floor
-		glBindVertexArray(VAO);
-		lightingShader.setMat4("model", model);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		// bind specular map
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, blackMap);
-
-		// draw mirror
-		glBindVertexArray(mirrorVAO);
-		float angle = 20;
-		model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first		
-		model = glm::translate(model, glm::vec3(1.0f, -1.99f, -1.0f));
-		model = glm::rotate(model, glm::radians(angle), glm::vec3(0.0f, -1.0f, 0.0f));
-		lightingShader.setMat4("model", model);
-		glDrawArrays(GL_TRIANGLES, 0, 72);
-
-		//pyramid top
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, anotherMap);
-		glBindVertexArray(topVAO);
-		model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first		
-		model = glm::translate(model, glm::vec3(1.0f, -2.84f, -1.0f));
-		lightingShader.setMat4("model", model);
-		glDrawArrays(GL_TRIANGLES, 0, 18);
-
-		//cube bottom
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, whiteMap);
-		glBindVertexArray(bottomVAO);
-		model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first		
-		model = glm::translate(model, glm::vec3(1.0f, -2.84f, -1.0f));
-		lightingShader.setMat4("model", model);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-
-		//cylinders
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, bowlMap);
-		glBindVertexArray(VAO2);
-		model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first		
-		model = glm::translate(model, glm::vec3(-2.0f, -3.79f, 1.0f));
-		lightingShader.setMat4("model", model);
-
-		static_meshes_3D::Cylinder C(1.1, 30, 0.4, true, true, true);
-		C.render();
-
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, innerMap);
-		glBindVertexArray(VAO2);
-		model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first		
-		model = glm::translate(model, glm::vec3(-2.0f, -3.79f, 1.0f));
-		lightingShader.setMat4("model", model);
-
-		static_meshes_3D::Cylinder C2(0.9, 30, 0.41, true, true, true);
-		C2.render();
-
-
+		lightingShader->setMat4(lightingUniforms.projection, projection);
+		lightingShader->setMat4(lightingUniforms.view, view);
+		if (instancedLightingShader != nullptr)
+		{
+			instancedLightingShader->use();
+			instancedLightingShader->setVec3(instancedLightingUniforms.viewPos, camera.Position);
+			instancedLightingShader->setFloat(instancedLightingUniforms.shininess, 32.0f);
+			instancedLightingShader->setMat4(instancedLightingUniforms.projection, projection);
+			instancedLightingShader->setMat4(instancedLightingUniforms.view, view);
+		}
+
+		// clustered lights are assigned to the clusters of this view on all cores and uploaded for both variants
+		if (lightingPermutation.hasClusteredLights)
+		{
+			int framebufferWidth, framebufferHeight;
+			glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+			clusteredLights.setProjection(projection, framebufferWidth, framebufferHeight);
+			clusteredLights.assign(view);
+			clusteredLights.upload();
+			clusteredLights.bindTextures();
+			lightingShader->use();
+			lightingShader->setVec2(lightingUniforms.clusterTileScale, clusteredLights.getTileScale());
+			lightingShader->setVec4(lightingUniforms.clusterDepthParams, clusteredLights.getDepthParams());
+			if (instancedLightingShader != nullptr)
+			{
+				instancedLightingShader->use();
+				instancedLightingShader->setVec2(instancedLightingUniforms.clusterTileScale, clusteredLights.getTileScale());
+				instancedLightingShader->setVec4(instancedLightingUniforms.clusterDepthParams, clusteredLights.getDepthParams());
+			}
+			if (printStatistics && clusteredLights.getStatistics() != lastClusterStatistics)
+			{
+				lastClusterStatistics = clusteredLights.getStatistics();
+				clusteredLights.printStatistics();
+			}
+		}
+
+		// the hierarchy drops whole subtrees outside the view, packets of the rest go to the queue, which culls them
+		// one by one (4 at a time with SSE2, tighter than the hierarchy's boxes), orders them by state and binds
+		// only what changes
+		renderQueue.clear();
+		renderQueue.setViewMatrix(view);
+		renderQueue.setProjectionMatrix(projection);
+		sceneBVH.cull(Frustum(projection * view), visibleObjects);
+		visibleObjects.insert(visibleObjects.end(), unboundedObjects.begin(), unboundedObjects.end());
+		for (auto object : visibleObjects)
+		{
+			if (object < scenePackets.size())
+			{
+				auto& packet = scenePackets[object];
+				packet.program = lightingShader->ID;
+				packet.modelLocation = lightingUniforms.model.location;
+				packet.normalMatrixLocation = lightingUniforms.normalMatrix.location;
+				renderQueue.submit(packet);
+			}
+			else if (instancedLightingShader != nullptr && drawProps)
+			{
+				propPacket.program = instancedLightingShader->ID;
+				renderQueue.submit(propPacket);
+			}
+		}
+		renderQueue.execute();
+		if (printStatistics && renderQueue.getStatistics() != lastRenderStatistics)
+		{
+			lastRenderStatistics = renderQueue.getStatistics();
+			renderQueue.printStatistics();
+		}
+		// state calls of the whole frame, printed whenever they differ from the last printed ones
+		if (printStatistics && GLState::getStatistics() != lastStateStatistics)
+		{
+			lastStateStatistics = GLState::getStatistics();
+			GLState::printStatistics();
+		}
+		GLState::resetStatistics();
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
@@ -547,16 +750,32 @@ int main()
 
 	// optional: de-allocate all resources once they've outlived their purpose:
 	// ------------------------------------------------------------------------
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteVertexArrays(1, &VAO2);
-	glDeleteVertexArrays(1, &topVAO);
-	glDeleteVertexArrays(1, &bottomVAO);
-	glDeleteVertexArrays(1, &mirrorVAO);
-	glDeleteBuffers(1, &VBO);
-	glDeleteBuffers(1, &VBO2);
-	glDeleteBuffers(1, &topVBO);
-	glDeleteBuffers(1, &bottomVBO);
-	glDeleteBuffers(1, &mirrorVBO);
+	GLState::deleteVertexArrays(1, &VAO);
+	GLState::deleteVertexArrays(1, &VAO2);
+	GLState::deleteVertexArrays(1, &topVAO);
+	GLState::deleteVertexArrays(1, &bottomVAO);
+	GLState::deleteVertexArrays(1, &mirrorVAO);
+	GLState::deleteBuffers(1, &VBO);
+	GLState::deleteBuffers(1, &VBO2);
+	GLState::deleteBuffers(1, &topVBO);
+	GLState::deleteBuffers(1, &bottomVBO);
+	GLState::deleteBuffers(1, &mirrorVBO);
+	lightBlock.deleteBuffer();
+	clusteredLights.deleteBuffers();
+	textureLoader.deleteBuffers();
+	diffuseMap.reset();
+	specularMap.reset();
+	bowlMap.reset();
+	innerMap.reset();
+	anotherMap.reset();
+	blackMap.reset();
+	whiteMap.reset();
+	textureCache.clear();
+	bowlOuter.reset();
+	bowlInner.reset();
+	props.deleteBuffer();
+	propMesh.reset();
+	meshCache.clear();
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
@@ -623,41 +842,26 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 	camera.ProcessMouseScroll(yoffset);
 }
 
-// utility function for loading a 2D texture from file
-// ---------------------------------------------------
-unsigned int loadTexture(char const* path)
+// glfw: whenever a key is pressed or released, this callback is called (for toggles, held keys are handled in processInput)
+// -------------------------------------------------------------------------------------------------------------------------
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
+	if (action != GLFW_PRESS)
+		return;
 
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-	if (data)
+	if (key == GLFW_KEY_P)
 	{
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
+		printStatistics = !printStatistics;
+		std::cout << "Printing of statistics " << (printStatistics ? "on" : "off") << std::endl;
 	}
-	else
+	else if (key == GLFW_KEY_I)
 	{
-		std::cout << "Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(data);
+		drawProps = !drawProps;
+		std::cout << "Instanced props " << (drawProps ? "on" : "off") << std::endl;
 	}
-
-	return textureID;
-}
\ No newline at end of file
+	else if (key == GLFW_KEY_L)
+	{
+		useClusteredLights = !useClusteredLights;
+		std::cout << "Clustered lights " << (useClusteredLights ? "on" : "off") << std::endl;
+	}
+}
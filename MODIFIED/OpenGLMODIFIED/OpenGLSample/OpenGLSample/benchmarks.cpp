@@ -0,0 +1,1239 @@
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <thread>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// STB
+#include "stb_image.h"
+
+// Project
+#include "benchmarks.h"
+#include "clusteredLights.h"
+#include "cylinder.h"
+#include "instancedMesh.h"
+#include "normalMatrix.h"
+#include "renderQueue.h"
+#include "shader.h"
+#include "common/boundingVolumeHierarchy.h"
+#include "common/fileUtils.h"
+#include "common/frustum.h"
+#include "common/meshFile.h"
+#include "common/objloader.hpp"
+#include "common/tangentspace.hpp"
+#include "common/textureCompressor.hpp"
+#include "common/vboindexer.hpp"
+
+namespace {
+
+	/**
+	 * Benchmark, that can be run from the command line.
+	 */
+	struct Benchmark
+	{
+		const char* name; // Name given after --bench
+		const char* description; // Arguments (with their defaults) and what is measured
+		void (*run)(const std::vector<std::string>& arguments); // Runs the benchmark and prints its results
+	};
+
+	/**
+	 * Runs function given number of times and returns the median duration of one run (in milliseconds).
+	 */
+	template <typename Function>
+	double measureMedian(int numRuns, const Function& function)
+	{
+		std::vector<double> durations;
+		for (int i = 0; i < numRuns; i++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			function();
+			durations.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		std::sort(durations.begin(), durations.end());
+		return durations[durations.size() / 2];
+	}
+
+	/**
+	 * Gets integer argument with given index, or the default value if it's missing.
+	 */
+	int getIntArgument(const std::vector<std::string>& arguments, size_t index, int defaultValue)
+	{
+		return index < arguments.size() ? std::atoi(arguments[index].c_str()) : defaultValue;
+	}
+
+	/**
+	 * Vertex fetch throughput of planar and interleaved vertex layouts (StaticMesh3D::VertexLayout). One cylinder
+	 * with many slices is drawn repeatedly into a 1x1 viewport, so that fetching and transforming vertices is
+	 * all the work there is. Shader reads all three attributes.
+	 */
+	void benchmarkVertexLayout(const std::vector<std::string>& arguments)
+	{
+		const auto numSlices = getIntArgument(arguments, 0, 100000);
+		const int NUM_DRAWS = 20;
+
+		Shader shader("shaderfiles/bench_vertex_fetch.vs", "shaderfiles/bench_vertex_fetch.fs");
+		shader.use();
+		glViewport(0, 0, 1, 1);
+
+		const std::pair<const char*, static_meshes_3D::VertexLayout::Packing> packings[] = {
+			{ "planar", static_meshes_3D::VertexLayout::Packing::Planar },
+			{ "interleaved", static_meshes_3D::VertexLayout::Packing::Interleaved }
+		};
+		for (const auto& packing : packings)
+		{
+			static_meshes_3D::Cylinder cylinder(1.0f, numSlices, 1.0f, true, true, true, packing.second);
+
+			// First draw pays for uploads and shader compilation inside the driver
+			cylinder.render();
+			glFinish();
+			const auto milliseconds = measureMedian(5, [&] {
+				for (int i = 0; i < NUM_DRAWS; i++) {
+					cylinder.render();
+				}
+				glFinish();
+			});
+
+			const auto numIndices = double(cylinder.getNumIndices()) * NUM_DRAWS;
+			std::cout << std::setw(12) << packing.first << ": " << cylinder.getVertexLayout().numVertices << " vertices, "
+				<< std::fixed << std::setprecision(3) << milliseconds / NUM_DRAWS << " ms per draw, "
+				<< std::setprecision(1) << numIndices / (milliseconds * 1000.0) << " M indices/s" << std::endl;
+			std::cout.unsetf(std::ios_base::floatfield);
+		}
+
+		GLState::deleteProgram(shader.ID);
+	}
+
+	/**
+	 * Path of the OBJ file generated by benchmarks, that are not given a file of their own.
+	 */
+	const char* const GENERATED_OBJ_PATH = "bench_generated.obj";
+
+	/**
+	 * Writes OBJ file with a wavy grid of about given size. Every vertex has position, texture coordinate and normal
+	 * with 6 decimal places (typical for exporters), faces are v/vt/vn triangles, so that every loader can read it.
+	 */
+	bool writeGridOBJ(const char* path, size_t megabytes)
+	{
+		// Roughly 160 bytes of lines per grid vertex (its attributes and two triangles)
+		const auto size = std::max(int(std::sqrt(double(megabytes) * 1024.0 * 1024.0 / 160.0)), 2);
+		const auto file = fopen(path, "w");
+		if (file == nullptr)
+		{
+			std::cerr << "Could not write " << path << "!" << std::endl;
+			return false;
+		}
+
+		fprintf(file, "# %dx%d grid generated for benchmarking\n", size, size);
+		for (int z = 0; z < size; z++)
+		{
+			for (int x = 0; x < size; x++)
+			{
+				const auto u = float(x) / (size - 1), v = float(z) / (size - 1);
+				const auto height = 0.25f * std::sin(u * 40.0f) * std::cos(v * 40.0f);
+				const auto normal = glm::normalize(glm::vec3(-10.0f * std::cos(u * 40.0f) * std::cos(v * 40.0f), 1.0f, 10.0f * std::sin(u * 40.0f) * std::sin(v * 40.0f)));
+				fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n", u * 100.0f - 50.0f, height, v * 100.0f - 50.0f, u, v, normal.x, normal.y, normal.z);
+			}
+		}
+		for (int z = 0; z + 1 < size; z++)
+		{
+			for (int x = 0; x + 1 < size; x++)
+			{
+				const auto a = z * size + x + 1, b = a + 1, c = a + size, d = c + 1;
+				fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\nf %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, b, b, b, b, b, b, c, c, c, d, d, d);
+			}
+		}
+
+		return fclose(file) == 0;
+	}
+
+	/**
+	 * The fscanf based loadOBJ the mapped parser replaced (v/vt/vn triangles only), kept as the baseline.
+	 */
+	bool loadOBJWithFscanf(const char* path, std::vector<glm::vec3>& out_vertices, std::vector<glm::vec2>& out_uvs, std::vector<glm::vec3>& out_normals)
+	{
+		std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
+		std::vector<glm::vec3> temp_vertices;
+		std::vector<glm::vec2> temp_uvs;
+		std::vector<glm::vec3> temp_normals;
+
+		FILE* file = fopen(path, "r");
+		if (file == NULL) {
+			return false;
+		}
+
+		while (1)
+		{
+			char lineHeader[128];
+			int res = fscanf(file, "%127s", lineHeader);
+			if (res == EOF)
+				break;
+
+			if (strcmp(lineHeader, "v") == 0) {
+				glm::vec3 vertex;
+				fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
+				temp_vertices.push_back(vertex);
+			}
+			else if (strcmp(lineHeader, "vt") == 0) {
+				glm::vec2 uv;
+				fscanf(file, "%f %f\n", &uv.x, &uv.y);
+				uv.y = -uv.y;
+				temp_uvs.push_back(uv);
+			}
+			else if (strcmp(lineHeader, "vn") == 0) {
+				glm::vec3 normal;
+				fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
+				temp_normals.push_back(normal);
+			}
+			else if (strcmp(lineHeader, "f") == 0) {
+				unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
+				int matches = fscanf(file, "%u/%u/%u %u/%u/%u %u/%u/%u\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
+				if (matches != 9) {
+					fclose(file);
+					return false;
+				}
+				for (int i = 0; i < 3; i++)
+				{
+					vertexIndices.push_back(vertexIndex[i]);
+					uvIndices.push_back(uvIndex[i]);
+					normalIndices.push_back(normalIndex[i]);
+				}
+			}
+			else {
+				char stupidBuffer[1000];
+				fgets(stupidBuffer, 1000, file);
+			}
+		}
+
+		for (unsigned int i = 0; i < vertexIndices.size(); i++)
+		{
+			out_vertices.push_back(temp_vertices[vertexIndices[i] - 1]);
+			out_uvs.push_back(temp_uvs[uvIndices[i] - 1]);
+			out_normals.push_back(temp_normals[normalIndices[i] - 1]);
+		}
+		fclose(file);
+		return true;
+	}
+
+	/**
+	 * Time of loading OBJ file into a triangle soup with the fscanf baseline and the mapped parser (loadOBJ).
+	 * Without a path, a grid OBJ of given size is generated (and deleted afterwards). Loads run from a warm file cache.
+	 */
+	void benchmarkOBJLoader(const std::vector<std::string>& arguments)
+	{
+		const auto isGenerated = arguments.empty() || arguments[0].empty();
+		const auto path = isGenerated ? std::string(GENERATED_OBJ_PATH) : arguments[0];
+		if (isGenerated && !writeGridOBJ(path.c_str(), size_t(getIntArgument(arguments, 1, 100)))) {
+			return;
+		}
+
+		std::vector<glm::vec3> vertices, normals, baselineVertices, baselineNormals;
+		std::vector<glm::vec2> uvs, baselineUVs;
+		const auto load = [&](bool isBaseline) {
+			auto& outVertices = isBaseline ? baselineVertices : vertices;
+			auto& outUVs = isBaseline ? baselineUVs : uvs;
+			auto& outNormals = isBaseline ? baselineNormals : normals;
+			outVertices.clear();
+			outUVs.clear();
+			outNormals.clear();
+			return isBaseline ? loadOBJWithFscanf(path.c_str(), outVertices, outUVs, outNormals) : loadOBJ(path.c_str(), outVertices, outUVs, outNormals);
+		};
+
+		// First load of each only warms up the file cache
+		auto isLoaded = load(false);
+		const auto milliseconds = measureMedian(3, [&] { isLoaded = load(false) && isLoaded; });
+		auto isBaselineLoaded = load(true);
+		const auto baselineMilliseconds = measureMedian(3, [&] { isBaselineLoaded = load(true) && isBaselineLoaded; });
+		if (isGenerated) {
+			remove(path.c_str());
+		}
+
+		if (!isLoaded)
+		{
+			std::cerr << "loadOBJ could not load " << path << "!" << std::endl;
+			return;
+		}
+		std::cout << std::fixed << std::setprecision(1) << path << ": " << vertices.size() / 3 << " triangles" << std::endl
+			<< "  loadOBJ (mapped):  " << milliseconds << " ms" << std::endl;
+		if (isBaselineLoaded)
+		{
+			const auto isSame = baselineVertices.size() == vertices.size()
+				&& memcmp(baselineVertices.data(), vertices.data(), vertices.size() * sizeof(glm::vec3)) == 0
+				&& memcmp(baselineUVs.data(), uvs.data(), uvs.size() * sizeof(glm::vec2)) == 0
+				&& memcmp(baselineNormals.data(), normals.data(), normals.size() * sizeof(glm::vec3)) == 0;
+			std::cout << "  fscanf baseline:   " << baselineMilliseconds << " ms (" << baselineMilliseconds / milliseconds << "x slower, "
+				<< (isSame ? "same" : "DIFFERENT") << " triangles)" << std::endl;
+		}
+		else {
+			std::cout << "  fscanf baseline:   can't read this file (it reads only v/vt/vn triangles)" << std::endl;
+		}
+		std::cout.unsetf(std::ios_base::floatfield);
+	}
+
+	/**
+	 * Scaling of the chunked OBJ parser with the number of threads (1, 2, 4, ... up to maxThreads). Arguments
+	 * and the generated file are the same as of the objloader benchmark.
+	 */
+	void benchmarkOBJLoaderThreads(const std::vector<std::string>& arguments)
+	{
+		const auto isGenerated = arguments.empty() || arguments[0].empty();
+		const auto path = isGenerated ? std::string(GENERATED_OBJ_PATH) : arguments[0];
+		const auto maxThreads = getIntArgument(arguments, 2, int(std::max(std::thread::hardware_concurrency(), 1u)));
+		if (isGenerated && !writeGridOBJ(path.c_str(), size_t(getIntArgument(arguments, 1, 100)))) {
+			return;
+		}
+
+		std::vector<glm::vec3> vertices, normals;
+		std::vector<glm::vec2> uvs;
+		double serialMilliseconds = 0.0;
+		for (int numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+		{
+			auto isLoaded = true;
+			const auto load = [&] {
+				vertices.clear();
+				uvs.clear();
+				normals.clear();
+				isLoaded = loadOBJ(path.c_str(), vertices, uvs, normals, unsigned(numThreads)) && isLoaded;
+			};
+			load();
+			const auto milliseconds = measureMedian(3, load);
+			if (!isLoaded)
+			{
+				std::cerr << "loadOBJ could not load " << path << "!" << std::endl;
+				break;
+			}
+
+			serialMilliseconds = numThreads == 1 ? milliseconds : serialMilliseconds;
+			std::cout << std::fixed << std::setprecision(1) << std::setw(4) << numThreads << " threads: " << milliseconds << " ms ("
+				<< std::setprecision(2) << serialMilliseconds / milliseconds << "x)" << std::endl;
+			std::cout.unsetf(std::ios_base::floatfield);
+			if (numThreads >= maxThreads) {
+				break;
+			}
+		}
+		std::cout << vertices.size() / 3 << " triangles" << std::endl;
+
+		if (isGenerated) {
+			remove(path.c_str());
+		}
+	}
+
+	/**
+	 * Time of getting indexed mesh data ready for upload from a binary mesh file (checking it's up to date,
+	 * mapping it and copying out the data, as glBufferData would) against parsing and indexing the OBJ file.
+	 * Arguments and the generated file are the same as of the objloader benchmark.
+	 */
+	void benchmarkMeshFile(const std::vector<std::string>& arguments)
+	{
+		const auto isGenerated = arguments.empty() || arguments[0].empty();
+		const auto objPath = isGenerated ? std::string(GENERATED_OBJ_PATH) : arguments[0];
+		const auto meshPath = objPath + ".bench.mesh";
+		if (isGenerated && !writeGridOBJ(objPath.c_str(), size_t(getIntArgument(arguments, 1, 100)))) {
+			return;
+		}
+
+		const auto convertStart = std::chrono::steady_clock::now();
+		const auto isConverted = convertOBJToMeshFile(objPath.c_str(), meshPath.c_str());
+		const auto convertMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - convertStart).count();
+		if (!isConverted)
+		{
+			std::cerr << "Could not convert " << objPath << "!" << std::endl;
+			if (isGenerated) {
+				remove(objPath.c_str());
+			}
+			return;
+		}
+
+		std::vector<char> vertexData, indexData;
+		auto isLoaded = true;
+		const auto loadMeshFile = [&] {
+			MeshFile meshFile;
+			isLoaded = MeshFile::isUpToDate(meshPath.c_str(), objPath.c_str()) && meshFile.open(meshPath.c_str()) && isLoaded;
+			if (isLoaded)
+			{
+				const auto& header = meshFile.getHeader();
+				const auto vertices = static_cast<const char*>(meshFile.getVertexData());
+				const auto indices = static_cast<const char*>(meshFile.getIndexData());
+				vertexData.assign(vertices, vertices + header.vertexDataSize);
+				indexData.assign(indices, indices + header.indexDataSize);
+			}
+		};
+		loadMeshFile();
+		const auto meshFileMilliseconds = measureMedian(5, loadMeshFile);
+
+		std::vector<glm::vec3> vertices, normals, indexedVertices, indexedNormals;
+		std::vector<glm::vec2> uvs, indexedUVs;
+		std::vector<GLuint> indices;
+		const auto loadOBJFile = [&] {
+			vertices.clear();
+			uvs.clear();
+			normals.clear();
+			indices.clear();
+			indexedVertices.clear();
+			indexedUVs.clear();
+			indexedNormals.clear();
+			isLoaded = loadOBJ(objPath.c_str(), vertices, uvs, normals) && indexVBO(vertices, uvs, normals, indices, indexedVertices, indexedUVs, indexedNormals) && isLoaded;
+		};
+		const auto objMilliseconds = measureMedian(3, loadOBJFile);
+
+		remove(meshPath.c_str());
+		if (isGenerated) {
+			remove(objPath.c_str());
+		}
+		if (!isLoaded)
+		{
+			std::cerr << "Could not load " << objPath << "!" << std::endl;
+			return;
+		}
+
+		std::cout << std::fixed << std::setprecision(1) << objPath << ": " << indexedVertices.size() << " vertices, " << indices.size() / 3 << " triangles" << std::endl
+			<< "  conversion (once):     " << convertMilliseconds << " ms" << std::endl
+			<< "  mesh file:             " << meshFileMilliseconds << " ms (" << (vertexData.size() + indexData.size()) / (1024 * 1024) << " MB)" << std::endl
+			<< "  loadOBJ and indexVBO:  " << objMilliseconds << " ms (" << objMilliseconds / meshFileMilliseconds << "x slower)" << std::endl;
+		std::cout.unsetf(std::ios_base::floatfield);
+	}
+
+	/**
+	 * Vertex of the std::map based indexVBO from the tutorials, that hashed indexVBO is compared against.
+	 */
+	struct MapVertex
+	{
+		glm::vec3 position;
+		glm::vec2 uv;
+		glm::vec3 normal;
+
+		bool operator<(const MapVertex& other) const
+		{
+			return memcmp(this, &other, sizeof(MapVertex)) > 0;
+		}
+	};
+
+	/**
+	 * Merges identical vertices with std::map (the tutorial's indexVBO with bitwise comparison).
+	 */
+	void indexVBOWithMap(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec2>& uvs, const std::vector<glm::vec3>& normals,
+		std::vector<unsigned int>& indices, std::vector<glm::vec3>& outVertices, std::vector<glm::vec2>& outUVs, std::vector<glm::vec3>& outNormals)
+	{
+		std::map<MapVertex, unsigned int> vertexToIndex;
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			const MapVertex vertex = { vertices[i], uvs[i], normals[i] };
+			const auto found = vertexToIndex.find(vertex);
+			if (found != vertexToIndex.end())
+			{
+				indices.push_back(found->second);
+				continue;
+			}
+
+			outVertices.push_back(vertices[i]);
+			outUVs.push_back(uvs[i]);
+			outNormals.push_back(normals[i]);
+			indices.push_back(unsigned(outVertices.size() - 1));
+			vertexToIndex[vertex] = indices.back();
+		}
+	}
+
+	/**
+	 * Time of merging identical vertices of a triangle soup (grid of size x size quads, 6 corners each) with the
+	 * hash table of indexVBO against the tutorial's std::map.
+	 */
+	void benchmarkIndexVBO(const std::vector<std::string>& arguments)
+	{
+		const auto size = std::max(getIntArgument(arguments, 0, 500), 1);
+		std::vector<glm::vec3> vertices, normals;
+		std::vector<glm::vec2> uvs;
+		for (int z = 0; z < size; z++)
+		{
+			for (int x = 0; x < size; x++)
+			{
+				const int corners[6][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+				for (const auto& corner : corners)
+				{
+					const auto u = float(x + corner[0]) / size, v = float(z + corner[1]) / size;
+					vertices.push_back(glm::vec3(u * 100.0f - 50.0f, 0.25f * std::sin(u * 40.0f) * std::cos(v * 40.0f), v * 100.0f - 50.0f));
+					uvs.push_back(glm::vec2(u, v));
+					normals.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+				}
+			}
+		}
+
+		std::vector<unsigned int> indices, mapIndices;
+		std::vector<glm::vec3> indexedVertices, indexedNormals, mapVertices, mapNormals;
+		std::vector<glm::vec2> indexedUVs, mapUVs;
+		const auto milliseconds = measureMedian(5, [&] {
+			indexVBO(vertices, uvs, normals, indices, indexedVertices, indexedUVs, indexedNormals);
+		});
+		const auto mapMilliseconds = measureMedian(3, [&] {
+			mapIndices.clear();
+			mapVertices.clear();
+			mapUVs.clear();
+			mapNormals.clear();
+			indexVBOWithMap(vertices, uvs, normals, mapIndices, mapVertices, mapUVs, mapNormals);
+		});
+
+		const auto isSame = indices == mapIndices && indexedVertices.size() == mapVertices.size()
+			&& memcmp(indexedVertices.data(), mapVertices.data(), mapVertices.size() * sizeof(glm::vec3)) == 0;
+		std::cout << std::fixed << std::setprecision(1) << vertices.size() << " corners -> " << indexedVertices.size() << " vertices" << std::endl
+			<< "  indexVBO (hash table):  " << milliseconds << " ms" << std::endl
+			<< "  std::map:               " << mapMilliseconds << " ms (" << mapMilliseconds / milliseconds << "x slower, "
+			<< (isSame ? "same" : "DIFFERENT") << " result)" << std::endl;
+		std::cout.unsetf(std::ios_base::floatfield);
+	}
+
+	/**
+	 * Time of computing tangents and bitangents of an indexed wavy grid of size x size quads: per triangle soup
+	 * (computeTangentBasis, run on the de-indexed grid) against computeTangentBasisIndexed with 1, 2, 4, ...
+	 * up to maxThreads threads. All thread counts have to give bitwise identical results.
+	 */
+	void benchmarkTangents(const std::vector<std::string>& arguments)
+	{
+		const auto size = std::max(getIntArgument(arguments, 0, 1000), 1);
+		const auto maxThreads = getIntArgument(arguments, 1, int(std::max(std::thread::hardware_concurrency(), 1u)));
+
+		std::vector<unsigned int> indices;
+		std::vector<glm::vec3> vertices, normals;
+		std::vector<glm::vec2> uvs;
+		for (int z = 0; z <= size; z++)
+		{
+			for (int x = 0; x <= size; x++)
+			{
+				const auto u = float(x) / size, v = float(z) / size;
+				vertices.push_back(glm::vec3(u * 100.0f - 50.0f, 0.25f * std::sin(u * 40.0f) * std::cos(v * 40.0f), v * 100.0f - 50.0f));
+				uvs.push_back(glm::vec2(u, v));
+				normals.push_back(glm::normalize(glm::vec3(-10.0f * std::cos(u * 40.0f) * std::cos(v * 40.0f), 1.0f, 10.0f * std::sin(u * 40.0f) * std::sin(v * 40.0f))));
+				if (x < size && z < size)
+				{
+					const auto a = unsigned(z * (size + 1) + x), b = a + 1, c = a + size + 1, d = c + 1;
+					indices.insert(indices.end(), { a, c, b, b, c, d });
+				}
+			}
+		}
+
+		std::vector<glm::vec3> soupVertices, soupNormals, soupTangents, soupBitangents;
+		std::vector<glm::vec2> soupUVs;
+		for (const auto index : indices)
+		{
+			soupVertices.push_back(vertices[index]);
+			soupUVs.push_back(uvs[index]);
+			soupNormals.push_back(normals[index]);
+		}
+		const auto soupMilliseconds = measureMedian(3, [&] {
+			soupTangents.clear();
+			soupBitangents.clear();
+			computeTangentBasis(soupVertices, soupUVs, soupNormals, soupTangents, soupBitangents);
+		});
+
+		std::cout << std::fixed << std::setprecision(1) << vertices.size() << " vertices, " << indices.size() / 3 << " triangles" << std::endl
+			<< "  computeTangentBasis (soup):  " << soupMilliseconds << " ms" << std::endl;
+		std::vector<glm::vec3> serialTangents, serialBitangents;
+		for (int numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+		{
+			std::vector<glm::vec3> tangents, bitangents;
+			const auto milliseconds = measureMedian(5, [&] {
+				computeTangentBasisIndexed(indices, vertices, uvs, normals, tangents, bitangents, unsigned(numThreads));
+			});
+			if (numThreads == 1)
+			{
+				serialTangents = tangents;
+				serialBitangents = bitangents;
+			}
+
+			const auto isSame = memcmp(tangents.data(), serialTangents.data(), tangents.size() * sizeof(glm::vec3)) == 0
+				&& memcmp(bitangents.data(), serialBitangents.data(), bitangents.size() * sizeof(glm::vec3)) == 0;
+			std::cout << "  indexed, " << std::setw(3) << numThreads << " threads:      " << milliseconds << " ms ("
+				<< soupMilliseconds / milliseconds << "x speedup over soup" << (isSame ? "" : ", DIFFERENT from 1 thread") << ")" << std::endl;
+			if (numThreads >= maxThreads) {
+				break;
+			}
+		}
+		std::cout.unsetf(std::ios_base::floatfield);
+	}
+
+	/**
+	 * Decodes 565 color of BC1 block.
+	 */
+	void unpackColor(const unsigned char* data, int color[3])
+	{
+		const auto packed = data[0] | (data[1] << 8);
+		const auto r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	/**
+	 * Decodes BC1 color block (as in BC1 and BC3) into 16 RGB pixels.
+	 */
+	void decodeColorBlock(const unsigned char* block, bool allowThreeColors, unsigned char pixels[16][3])
+	{
+		int palette[4][3];
+		unpackColor(block, palette[0]);
+		unpackColor(block + 2, palette[1]);
+		const auto isFourColors = !allowThreeColors || (block[0] | (block[1] << 8)) > (block[2] | (block[3] << 8));
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = isFourColors ? (2 * palette[0][c] + palette[1][c]) / 3 : (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = isFourColors ? (palette[0][c] + 2 * palette[1][c]) / 3 : 0;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			const auto index = (block[4 + i / 4] >> ((i % 4) * 2)) & 3;
+			for (int c = 0; c < 3; c++) {
+				pixels[i][c] = static_cast<unsigned char>(palette[index][c]);
+			}
+		}
+	}
+
+	/**
+	 * Decodes BC4 channel block (as in BC3, BC4 and BC5) into 16 values.
+	 */
+	void decodeChannelBlock(const unsigned char* block, unsigned char values[16])
+	{
+		const int high = block[0], low = block[1];
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; i++) {
+			indices |= uint64_t(block[2 + i]) << (i * 8);
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			const auto index = int((indices >> (i * 3)) & 7);
+			if (index < 2) {
+				values[i] = static_cast<unsigned char>(index == 0 ? high : low);
+			}
+			else if (high > low) {
+				values[i] = static_cast<unsigned char>(((8 - index) * high + (index - 1) * low) / 7);
+			}
+			else {
+				values[i] = static_cast<unsigned char>(index == 6 ? 0 : index == 7 ? 255 : ((6 - index) * high + (index - 1) * low) / 5);
+			}
+		}
+	}
+
+	/**
+	 * Decodes compressed image back into pixels with the components it was compressed from (as the GPU samples it).
+	 */
+	void decodeImage(const unsigned char* blocks, int width, int height, int numComponents, BlockFormat format, std::vector<unsigned char>& pixels)
+	{
+		const auto blockSize = format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+		pixels.resize(size_t(width) * height * numComponents);
+		for (int blockY = 0; blockY < (height + 3) / 4; blockY++)
+		{
+			for (int blockX = 0; blockX < (width + 3) / 4; blockX++, blocks += blockSize)
+			{
+				unsigned char colors[16][3] = {}, channels[2][16] = {};
+				switch (format) {
+				case BlockFormat::BC1:
+					decodeColorBlock(blocks, true, colors);
+					break;
+				case BlockFormat::BC3:
+					decodeChannelBlock(blocks, channels[0]);
+					decodeColorBlock(blocks + 8, false, colors);
+					break;
+				case BlockFormat::BC4:
+					decodeChannelBlock(blocks, channels[0]);
+					break;
+				case BlockFormat::BC5:
+					decodeChannelBlock(blocks, channels[0]);
+					decodeChannelBlock(blocks + 8, channels[1]);
+					break;
+				}
+
+				for (int i = 0; i < 16; i++)
+				{
+					const auto x = blockX * 4 + i % 4, y = blockY * 4 + i / 4;
+					if (x >= width || y >= height) {
+						continue;
+					}
+
+					auto pixel = &pixels[(size_t(y) * width + x) * numComponents];
+					if (format == BlockFormat::BC1 || format == BlockFormat::BC3) {
+						std::copy(colors[i], colors[i] + 3, pixel);
+					}
+					if (format == BlockFormat::BC3) {
+						pixel[3] = channels[0][i];
+					}
+					else if (format == BlockFormat::BC4 || format == BlockFormat::BC5) {
+						for (int c = 0; c < numComponents; c++) {
+							pixel[c] = channels[c][i];
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	 * Throughput (on one thread, as images are cooked) and quality (PSNR over all components) of the block
+	 * compressor for every quality level on all images in a directory.
+	 */
+	void benchmarkCompression(const std::vector<std::string>& arguments)
+	{
+		const auto directory = arguments.empty() ? std::string("images") : arguments[0];
+		const std::pair<const char*, CompressionQuality> qualities[] = {
+			{ "fast", CompressionQuality::Fast },
+			{ "normal", CompressionQuality::Normal },
+			{ "high", CompressionQuality::High }
+		};
+		const char* const FORMAT_NAMES[] = { "BC1", "BC3", "BC4", "BC5" };
+		const int NUM_QUALITIES = 3;
+
+		double totalMilliseconds[NUM_QUALITIES] = {}, totalSquaredErrors[NUM_QUALITIES] = {};
+		double totalPixels = 0.0, totalSamples = 0.0;
+		std::cout << std::setw(28) << std::left << "image" << std::right << std::setw(16) << "size" << "  format";
+		for (const auto& quality : qualities) {
+			std::cout << std::setw(22) << quality.first;
+		}
+		std::cout << std::endl << std::fixed;
+
+		for (const auto& path : listFiles(directory))
+		{
+			int width, height, numComponents;
+			const auto pixels = stbi_load(path.c_str(), &width, &height, &numComponents, 0);
+			if (pixels == nullptr) {
+				continue;
+			}
+
+			const auto format = getBlockFormatForComponents(numComponents);
+			const auto numSamples = size_t(width) * height * numComponents;
+			std::vector<unsigned char> blocks(getCompressedImageSize(width, height, format)), decoded;
+			std::cout << std::setw(28) << std::left << path.substr(path.find_last_of('/') + 1) << std::right
+				<< std::setw(16) << (std::to_string(width) + "x" + std::to_string(height) + "x" + std::to_string(numComponents))
+				<< "  " << std::setw(6) << FORMAT_NAMES[int(format)];
+			for (int q = 0; q < NUM_QUALITIES; q++)
+			{
+				const auto milliseconds = measureMedian(3, [&] {
+					compressImage(pixels, width, height, numComponents, format, qualities[q].second, blocks.data());
+				});
+				decodeImage(blocks.data(), width, height, numComponents, format, decoded);
+
+				double squaredErrors = 0.0;
+				for (size_t i = 0; i < numSamples; i++)
+				{
+					const auto error = double(pixels[i]) - decoded[i];
+					squaredErrors += error * error;
+				}
+				totalMilliseconds[q] += milliseconds;
+				totalSquaredErrors[q] += squaredErrors;
+
+				const auto psnr = squaredErrors > 0.0 ? 10.0 * std::log10(255.0 * 255.0 * numSamples / squaredErrors) : 99.0;
+				std::cout << std::setprecision(1) << std::setw(8) << width * double(height) / (milliseconds * 1000.0) << " MP/s "
+					<< std::setprecision(2) << std::setw(6) << psnr << " dB";
+			}
+			std::cout << std::endl;
+
+			totalPixels += double(width) * height;
+			totalSamples += double(numSamples);
+			stbi_image_free(pixels);
+		}
+
+		std::cout << std::setw(52) << std::left << "all images" << std::right;
+		for (int q = 0; q < NUM_QUALITIES; q++)
+		{
+			const auto psnr = totalSquaredErrors[q] > 0.0 ? 10.0 * std::log10(255.0 * 255.0 * totalSamples / totalSquaredErrors[q]) : 99.0;
+			std::cout << std::setprecision(1) << std::setw(8) << totalPixels / (totalMilliseconds[q] * 1000.0) << " MP/s "
+				<< std::setprecision(2) << std::setw(6) << psnr << " dB";
+		}
+		std::cout << std::endl;
+		std::cout.unsetf(std::ios_base::floatfield);
+	}
+
+	/**
+	 * CPU time and issued state calls of drawing packets with random programs, textures and meshes (in random
+	 * order) binding all their state for every draw, binding through GLState (redundant calls filtered out),
+	 * and through RenderQueue (sorted by state, then filtered). Draws go to a 1x1 viewport.
+	 */
+	void benchmarkStateFiltering(const std::vector<std::string>& arguments)
+	{
+		const auto numPackets = getIntArgument(arguments, 0, 2000);
+		const auto numFrames = getIntArgument(arguments, 1, 50);
+		const int NUM_PROGRAMS = 4, NUM_TEXTURES = 16, NUM_MESHES = 8, TEXTURES_PER_PACKET = 2;
+		glViewport(0, 0, 1, 1);
+
+		std::vector<std::unique_ptr<Shader>> shaders;
+		std::vector<GLuint> textures(NUM_TEXTURES);
+		std::vector<std::unique_ptr<static_meshes_3D::Cylinder>> meshes;
+		for (int i = 0; i < NUM_PROGRAMS; i++) {
+			shaders.emplace_back(new Shader("shaderfiles/bench_vertex_fetch.vs", "shaderfiles/bench_vertex_fetch.fs"));
+		}
+		glGenTextures(NUM_TEXTURES, textures.data());
+		for (const auto texture : textures)
+		{
+			const unsigned char pixel[4] = { 255, 255, 255, 255 };
+			GLState::bindTexture(GL_TEXTURE_2D, texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+		}
+		for (int i = 0; i < NUM_MESHES; i++) {
+			meshes.emplace_back(new static_meshes_3D::Cylinder(1.0f, 8 + i, 1.0f, true, true, true));
+		}
+
+		std::mt19937 random(1);
+		std::vector<DrawPacket> packets(numPackets);
+		for (auto& packet : packets)
+		{
+			const auto& mesh = *meshes[random() % NUM_MESHES];
+			packet.program = shaders[random() % NUM_PROGRAMS]->ID;
+			for (int t = 0; t < TEXTURES_PER_PACKET; t++) {
+				packet.textures[t] = textures[random() % NUM_TEXTURES];
+			}
+			packet.vao = mesh.getVAO();
+			packet.range = DrawRange::indexedMesh(mesh, GL_TRIANGLE_STRIP);
+			packet.model = glm::mat4(1.0f);
+			packet.model[3] = glm::vec4(0.0f, 0.0f, -float(random() % 1000) * 0.01f, 1.0f);
+		}
+
+		RenderQueue renderQueue;
+		const auto drawAll = [&](int mode) {
+			if (mode == 2)
+			{
+				renderQueue.clear();
+				for (const auto& packet : packets) {
+					renderQueue.submit(packet);
+				}
+				renderQueue.execute();
+				return;
+			}
+
+			for (const auto& packet : packets)
+			{
+				if (mode == 0)
+				{
+					glUseProgram(packet.program);
+					glBindVertexArray(packet.vao);
+					for (int t = 0; t < TEXTURES_PER_PACKET; t++)
+					{
+						glActiveTexture(GL_TEXTURE0 + t);
+						glBindTexture(GL_TEXTURE_2D, packet.textures[t]);
+					}
+				}
+				else
+				{
+					GLState::useProgram(packet.program);
+					GLState::bindVertexArray(packet.vao);
+					for (int t = 0; t < TEXTURES_PER_PACKET; t++) {
+						GLState::bindTexture(GLuint(t), GL_TEXTURE_2D, packet.textures[t]);
+					}
+				}
+				packet.range.draw();
+			}
+			if (mode == 0) {
+				GLState::invalidate();
+			}
+		};
+
+		const char* const MODE_NAMES[] = { "all state per draw", "GLState", "RenderQueue" };
+		std::cout << numPackets << " packets, " << NUM_PROGRAMS << " programs, " << NUM_TEXTURES << " textures (" << TEXTURES_PER_PACKET
+			<< " per packet), " << NUM_MESHES << " meshes" << std::endl;
+		for (int mode = 0; mode < 3; mode++)
+		{
+			drawAll(mode);
+			glFinish();
+			GLState::resetStatistics();
+			drawAll(mode);
+			const auto stateStatistics = GLState::getStatistics();
+			const auto bindCalls = mode == 0 ? size_t(numPackets) * (2 + 2 * TEXTURES_PER_PACKET) : stateStatistics.getTotalIssued();
+			const auto milliseconds = measureMedian(numFrames, [&] {
+				drawAll(mode);
+				glFinish();
+			});
+
+			std::cout << std::fixed << std::setprecision(3) << std::setw(20) << MODE_NAMES[mode] << ": " << milliseconds << " ms per frame, "
+				<< bindCalls << " state calls per frame";
+			if (mode != 0) {
+				std::cout << " (" << stateStatistics.getTotalSkipped() << " skipped)";
+			}
+			std::cout << std::endl;
+			std::cout.unsetf(std::ios_base::floatfield);
+		}
+
+		GLState::deleteTextures(NUM_TEXTURES, textures.data());
+		for (const auto& shader : shaders) {
+			GLState::deleteProgram(shader->ID);
+		}
+	}
+
+	/**
+	 * CPU time and draw calls of drawing a grid of props (same cylinder as the scene) with the scene's lighting program,
+	 * as one render queue packet per prop (model and normal matrix uploaded per draw) and as one instanced packet.
+	 */
+	void benchmarkInstancing(const std::vector<std::string>& arguments)
+	{
+		const auto gridSize = std::max(getIntArgument(arguments, 0, 100), 1);
+		const auto numFrames = getIntArgument(arguments, 1, 50);
+		glViewport(0, 0, 1, 1);
+
+		Shader shader("shaderfiles/6.multiple_lights.vs", "shaderfiles/6.multiple_lights.fs");
+		Shader instancedShader("shaderfiles/6.multiple_lights.vs", "shaderfiles/6.multiple_lights.fs", nullptr, { "INSTANCED" });
+		const auto view = glm::lookAt(glm::vec3(0.0f, 5.0f, 30.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		for (const auto program : { &shader, &instancedShader })
+		{
+			program->use();
+			program->setMat4("projection", glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f));
+			program->setMat4("view", view);
+		}
+
+		static_meshes_3D::Cylinder cylinder(0.1f, 12, 0.3f, true, true, true);
+		InstancedMesh props(cylinder, GL_TRIANGLE_STRIP);
+		props.createBuffer();
+		std::vector<DrawPacket> packets;
+		for (int z = 0; z < gridSize; z++)
+		{
+			for (int x = 0; x < gridSize; x++)
+			{
+				const auto model = glm::translate(glm::mat4(1.0f), glm::vec3((x - gridSize / 2) * 0.5f, 0.0f, (z - gridSize / 2) * 0.5f));
+				props.addInstance(model);
+
+				DrawPacket packet;
+				packet.program = shader.ID;
+				packet.modelLocation = shader.getUniform("model").location;
+				packet.normalMatrixLocation = shader.getUniform("normalMatrix").location;
+				packet.vao = cylinder.getVAO();
+				packet.range = DrawRange::indexedMesh(cylinder, GL_TRIANGLE_STRIP);
+				packet.model = model;
+				packets.push_back(packet);
+			}
+		}
+		props.upload();
+		DrawPacket instancedPacket;
+		instancedPacket.program = instancedShader.ID;
+		props.fillPacket(instancedPacket);
+
+		RenderQueue renderQueue;
+		renderQueue.setViewMatrix(view);
+		const auto drawAll = [&](bool isInstanced) {
+			renderQueue.clear();
+			if (isInstanced) {
+				renderQueue.submit(instancedPacket);
+			}
+			else
+			{
+				for (const auto& packet : packets) {
+					renderQueue.submit(packet);
+				}
+			}
+			renderQueue.execute();
+			glFinish();
+		};
+
+		std::cout << gridSize * gridSize << " props, " << cylinder.getNumIndices() << " indices each" << std::endl;
+		for (const auto isInstanced : { false, true })
+		{
+			drawAll(isInstanced);
+			const auto milliseconds = measureMedian(numFrames, [&] { drawAll(isInstanced); });
+			const auto& statistics = renderQueue.getStatistics();
+			std::cout << std::fixed << std::setprecision(3) << std::setw(20) << (isInstanced ? "instanced" : "packet per prop") << ": "
+				<< milliseconds << " ms per frame, " << statistics.numPackets << " draw calls, " << statistics.modelUploads << " model uploads" << std::endl;
+			std::cout.unsetf(std::ios_base::floatfield);
+		}
+
+		props.deleteBuffer();
+		GLState::deleteProgram(shader.ID);
+		GLState::deleteProgram(instancedShader.ID);
+	}
+
+	/**
+	 * Time of computing normal matrices of random model matrices with computeNormalMatrix and with the full
+	 * transposed inverse, for rotations with uniform scale (fast path) and with non-uniform scale (inverse),
+	 * and the largest difference of the results.
+	 */
+	void benchmarkNormalMatrix(const std::vector<std::string>& arguments)
+	{
+		const auto numMatrices = std::max(getIntArgument(arguments, 0, 1000000), 1);
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<glm::mat3> normalMatrices(numMatrices);
+
+		for (const auto isUniform : { true, false })
+		{
+			std::vector<glm::mat4> models(numMatrices);
+			for (auto& model : models)
+			{
+				const auto axis = glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.0f, 0.0f, 2.0f);
+				const auto scale = isUniform ? glm::vec3(2.0f + unit(random)) : glm::vec3(2.0f + unit(random), 2.0f + unit(random), 2.0f + unit(random));
+				model = glm::translate(glm::mat4(1.0f), glm::vec3(unit(random), unit(random), unit(random)) * 10.0f);
+				model = glm::rotate(model, unit(random) * 3.14159265f, glm::normalize(axis));
+				model = glm::scale(model, scale);
+			}
+
+			const auto inverseMilliseconds = measureMedian(5, [&] {
+				for (int i = 0; i < numMatrices; i++) {
+					normalMatrices[i] = glm::transpose(glm::inverse(glm::mat3(models[i])));
+				}
+			});
+			const auto inverseMatrices = normalMatrices;
+			const auto milliseconds = measureMedian(5, [&] {
+				for (int i = 0; i < numMatrices; i++) {
+					normalMatrices[i] = computeNormalMatrix(models[i]);
+				}
+			});
+
+			float maxError = 0.0f;
+			for (int i = 0; i < numMatrices; i++)
+			{
+				for (int column = 0; column < 3; column++)
+				{
+					for (int row = 0; row < 3; row++) {
+						maxError = std::max(maxError, std::abs(normalMatrices[i][column][row] - inverseMatrices[i][column][row]));
+					}
+				}
+			}
+
+			std::cout << std::fixed << std::setprecision(3) << std::setw(12) << (isUniform ? "uniform" : "non-uniform") << " scale: "
+				<< milliseconds << " ms computeNormalMatrix, " << inverseMilliseconds << " ms transposed inverse ("
+				<< inverseMilliseconds / milliseconds << "x), " << std::scientific << std::setprecision(2) << maxError << " max difference" << std::endl;
+			std::cout.unsetf(std::ios_base::floatfield);
+		}
+	}
+
+	/**
+	 * Random world space volumes of objects scattered around the camera, every object has a box and a sphere around it.
+	 */
+	void generateVolumes(int numObjects, std::vector<BoundingBox>& boxes, std::vector<BoundingSphere>& spheres)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> size(0.1f, 2.0f);
+		boxes.resize(numObjects);
+		spheres.resize(numObjects);
+		for (int i = 0; i < numObjects; i++)
+		{
+			const auto center = glm::vec3(position(random), position(random), position(random));
+			const auto extents = glm::vec3(size(random), size(random), size(random));
+			boxes[i].min = center - extents;
+			boxes[i].max = center + extents;
+			spheres[i].center = center;
+			spheres[i].radius = glm::length(extents);
+		}
+	}
+
+	/**
+	 * Frustum of a camera in the middle of the generated volumes.
+	 */
+	Frustum getBenchmarkFrustum()
+	{
+		return Frustum(glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f)
+			* glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.2f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+	}
+
+	/**
+	 * Time of culling volumes with Frustum::cull (4 objects per SSE2 test) and with the scalar box and sphere tests
+	 * one object at a time, which both have to agree on.
+	 */
+	void benchmarkFrustumCulling(const std::vector<std::string>& arguments)
+	{
+		const auto numObjects = std::max(getIntArgument(arguments, 0, 100000), 1);
+		std::vector<BoundingBox> boxes;
+		std::vector<BoundingSphere> spheres;
+		generateVolumes(numObjects, boxes, spheres);
+		BoundingVolumeArray volumes;
+		for (int i = 0; i < numObjects; i++) {
+			volumes.add(boxes[i], spheres[i]);
+		}
+		const auto frustum = getBenchmarkFrustum();
+
+		std::vector<uint8_t> isVisible, isVisibleScalar(numObjects);
+		size_t numVisible = 0;
+		const auto milliseconds = measureMedian(21, [&] { numVisible = frustum.cull(volumes, isVisible); });
+		const auto scalarMilliseconds = measureMedian(21, [&] {
+			for (int i = 0; i < numObjects; i++) {
+				isVisibleScalar[i] = frustum.intersects(boxes[i]) && frustum.intersects(spheres[i]) ? 1 : 0;
+			}
+		});
+
+		std::cout << numObjects << " objects, " << numVisible << " visible" << (isVisible == isVisibleScalar ? "" : " (scalar test differs)") << std::endl;
+		std::cout << std::fixed << std::setprecision(3) << "SSE2: " << milliseconds << " ms, scalar: " << scalarMilliseconds << " ms ("
+			<< scalarMilliseconds / milliseconds << "x)" << std::endl;
+		std::cout.unsetf(std::ios_base::floatfield);
+	}
+
+	/**
+	 * Time of building the hierarchy over generated volumes, culling it against a frustum compared to culling all
+	 * volumes with Frustum::cull, and casting random rays from the camera compared to testing every box.
+	 */
+	void benchmarkBVH(const std::vector<std::string>& arguments)
+	{
+		const auto numObjects = std::max(getIntArgument(arguments, 0, 100000), 1);
+		const auto numRays = std::max(getIntArgument(arguments, 1, 1000), 1);
+		const auto MAX_RAY_DISTANCE = 200.0f;
+		std::vector<BoundingBox> boxes;
+		std::vector<BoundingSphere> spheres;
+		generateVolumes(numObjects, boxes, spheres);
+		BoundingVolumeArray volumes;
+		for (int i = 0; i < numObjects; i++) {
+			volumes.add(boxes[i], spheres[i]);
+		}
+		const auto frustum = getBenchmarkFrustum();
+
+		BoundingVolumeHierarchy hierarchy;
+		const auto buildMilliseconds = measureMedian(3, [&] {
+			hierarchy.clear();
+			for (int i = 0; i < numObjects; i++) {
+				hierarchy.insert(boxes[i], uint32_t(i));
+			}
+			hierarchy.rebuild();
+		});
+
+		std::vector<uint32_t> visibleObjects;
+		std::vector<uint8_t> isVisible;
+		size_t numVisible = 0, numVisibleFlat = 0;
+		const auto cullMilliseconds = measureMedian(21, [&] { numVisible = hierarchy.cull(frustum, visibleObjects); });
+		const auto flatMilliseconds = measureMedian(21, [&] { numVisibleFlat = frustum.cull(volumes, isVisible); });
+
+		std::mt19937 random(2);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<glm::vec3> directions(numRays);
+		for (auto& direction : directions) {
+			direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.0f, 0.0f, 0.01f));
+		}
+		const auto origin = glm::vec3(0.0f);
+		std::vector<int> hits(numRays), bruteForceHits(numRays);
+		const auto raycastMilliseconds = measureMedian(5, [&] {
+			for (int r = 0; r < numRays; r++)
+			{
+				BoundingVolumeHierarchy::RayHit hit;
+				hits[r] = hierarchy.raycast(origin, directions[r], MAX_RAY_DISTANCE, hit) ? int(hit.userData) : -1;
+			}
+		});
+		const auto bruteForceMilliseconds = measureMedian(3, [&] {
+			for (int r = 0; r < numRays; r++)
+			{
+				// Same slab test as the hierarchy uses, the nearest entry wins
+				const glm::vec3 inverseDirection(1.0f / directions[r].x, 1.0f / directions[r].y, 1.0f / directions[r].z);
+				auto nearestDistance = MAX_RAY_DISTANCE;
+				bruteForceHits[r] = -1;
+				for (int i = 0; i < numObjects; i++)
+				{
+					auto tMin = 0.0f, tMax = nearestDistance;
+					for (int axis = 0; axis < 3; axis++)
+					{
+						auto t1 = (boxes[i].min[axis] - origin[axis]) * inverseDirection[axis];
+						auto t2 = (boxes[i].max[axis] - origin[axis]) * inverseDirection[axis];
+						tMin = std::max(tMin, std::min(t1, t2));
+						tMax = std::min(tMax, std::max(t1, t2));
+					}
+					if (tMin <= tMax && (bruteForceHits[r] == -1 || tMin < nearestDistance))
+					{
+						nearestDistance = tMin;
+						bruteForceHits[r] = i;
+					}
+				}
+			}
+		});
+		const auto numHits = std::count_if(hits.begin(), hits.end(), [](int hit) { return hit != -1; });
+
+		std::cout << numObjects << " objects, built in " << std::fixed << std::setprecision(3) << buildMilliseconds << " ms" << std::endl;
+		std::cout << "cull: hierarchy " << cullMilliseconds << " ms (" << numVisible << " visible boxes), SSE2 over all volumes "
+			<< flatMilliseconds << " ms (" << numVisibleFlat << " visible boxes and spheres)" << std::endl;
+		std::cout << numRays << " rays (" << numHits << " hits" << (hits == bruteForceHits ? "" : ", brute force differs") << "): hierarchy "
+			<< raycastMilliseconds << " ms, every box " << bruteForceMilliseconds << " ms (" << bruteForceMilliseconds / raycastMilliseconds << "x)" << std::endl;
+		std::cout.unsetf(std::ios_base::floatfield);
+	}
+
+	/**
+	 * Time of assigning 4 to 4096 point lights scattered over the floor of the scene (same falloff) to the clusters
+	 * of the scene's view on one thread and on all threads.
+	 */
+	void benchmarkClusteredLights(const std::vector<std::string>& arguments)
+	{
+		const auto maxThreads = getIntArgument(arguments, 0, int(std::max(std::thread::hardware_concurrency(), 1u)));
+		const auto projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+		const auto view = glm::lookAt(glm::vec3(0.0f, -2.0f, 8.0f), glm::vec3(0.0f, -2.0f, 7.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		ClusteredLights singleThreaded(1), multiThreaded(unsigned(std::max(maxThreads, 1)));
+
+		std::cout << "lights  1 thread [ms]  " << std::setw(3) << std::max(maxThreads, 1) << " threads [ms]  indices  max per cluster" << std::endl;
+		for (int numLights = 4; numLights <= 4096; numLights *= 4)
+		{
+			std::mt19937 random(1);
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+			std::vector<PointLight> pointLights(numLights);
+			for (auto& pointLight : pointLights)
+			{
+				const auto color = glm::vec3(unit(random), unit(random), unit(random));
+				pointLight.position = glm::vec3(-4.0f + 8.0f * unit(random), -3.8f, -4.0f + 8.0f * unit(random));
+				pointLight.ambient = color * 0.02f;
+				pointLight.diffuse = color * 0.5f;
+				pointLight.specular = color * 0.5f;
+				pointLight.constant = 1.0f;
+				pointLight.linear = 0.0f;
+				pointLight.quadratic = 200.0f;
+			}
+
+			double milliseconds[2];
+			ClusteredLights* clusteredLights[] = { &singleThreaded, &multiThreaded };
+			for (int i = 0; i < 2; i++)
+			{
+				clusteredLights[i]->setProjection(projection, 800, 600);
+				clusteredLights[i]->setPointLights(pointLights);
+				clusteredLights[i]->assign(view);
+				milliseconds[i] = measureMedian(21, [&] { clusteredLights[i]->assign(view); });
+			}
+
+			const auto& statistics = multiThreaded.getStatistics();
+			std::cout << std::fixed << std::setprecision(3) << std::setw(6) << numLights << std::setw(15) << milliseconds[0]
+				<< std::setw(18) << milliseconds[1] << std::setw(9) << statistics.numIndices << std::setw(17) << statistics.maxClusterLights
+				<< (statistics == singleThreaded.getStatistics() ? "" : " (1 thread differs)") << std::endl;
+			std::cout.unsetf(std::ios_base::floatfield);
+		}
+	}
+
+	const Benchmark BENCHMARKS[] = {
+		{ "vertexlayout", "[slices=100000] vertex fetch throughput of planar and interleaved vertex layouts", benchmarkVertexLayout },
+		{ "objloader", "[file.obj | \"\" megabytes=100] OBJ loading time of the mapped parser against the old fscanf parser", benchmarkOBJLoader },
+		{ "objthreads", "[file.obj | \"\" megabytes=100 maxThreads=hardware] OBJ loading time with 1, 2, 4, ... threads", benchmarkOBJLoaderThreads },
+		{ "meshfile", "[file.obj | \"\" megabytes=100] loading time of a binary mesh file against parsing and indexing the OBJ file", benchmarkMeshFile },
+		{ "indexvbo", "[size=500] merging identical vertices of a size x size grid soup, hash table against std::map", benchmarkIndexVBO },
+		{ "tangents", "[size=1000 maxThreads=hardware] tangent generation of a size x size grid, per triangle against indexed with 1, 2, 4, ... threads", benchmarkTangents },
+		{ "compression", "[directory=images] block compression throughput and PSNR of every quality on all images of the directory", benchmarkCompression },
+		{ "statefilter", "[packets=2000 frames=50] draw submission time and state calls unfiltered, filtered by GLState and sorted by RenderQueue", benchmarkStateFiltering },
+		{ "instancing", "[size=100 frames=50] draw time of a size x size prop grid as packet per prop and as one instanced packet", benchmarkInstancing },
+		{ "normalmatrix", "[matrices=1000000] normal matrix computation with the uniform scale fast path and with the full inverse", benchmarkNormalMatrix },
+		{ "frustumcull", "[volumes=100000] frustum culling with SSE2 and with scalar tests", benchmarkFrustumCulling },
+		{ "bvh", "[objects=100000 rays=1000] bounding volume hierarchy build, culling and ray casts against testing every object", benchmarkBVH },
+		{ "clusteredlights", "[maxThreads] assignment of 4 to 4096 clustered lights to the clusters of the scene's view", benchmarkClusteredLights },
+	};
+
+} // namespace
+
+int runBenchmarks(const std::string& name, const std::vector<std::string>& arguments)
+{
+	std::cout << "GL_RENDERER: " << glGetString(GL_RENDERER) << ", GL_VERSION: " << glGetString(GL_VERSION) << std::endl;
+
+	auto isFound = false;
+	for (const auto& benchmark : BENCHMARKS)
+	{
+		if (!name.empty() && name != benchmark.name) {
+			continue;
+		}
+
+		// Arguments belong to the named benchmark only, running all of them uses the defaults
+		std::cout << "Benchmark " << benchmark.name << std::endl;
+		benchmark.run(name.empty() ? std::vector<std::string>() : arguments);
+		isFound = true;
+	}
+
+	if (!isFound)
+	{
+		std::cerr << "Unknown benchmark " << name << ", available benchmarks:" << std::endl;
+		for (const auto& benchmark : BENCHMARKS) {
+			std::cerr << "  " << BENCHMARK_ARGUMENT << " " << benchmark.name << " " << benchmark.description << std::endl;
+		}
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+// STL
+#include <string>
+#include <vector>
+
+/**
+ * Command line argument, that runs benchmarks instead of the scene: OpenGLSample --bench [name [arguments...]].
+ */
+const char* const BENCHMARK_ARGUMENT = "--bench";
+
+/**
+ * Runs benchmark with given name (all of them with their default arguments, if name is empty) and prints its
+ * results. OpenGL context of a hidden window must be current, benchmarks that draw measure whatever driver
+ * created it (GL_RENDERER is printed first, on Mesa LIBGL_ALWAYS_SOFTWARE=1 selects llvmpipe).
+ * Unknown names print the list of benchmarks.
+ *
+ * @param name       Name of the benchmark
+ * @param arguments  Arguments of the benchmark (see the list)
+ *
+ * @return Exit code of the program (0 if the benchmark ran).
+ */
+int runBenchmarks(const std::string& name, const std::vector<std::string>& arguments);
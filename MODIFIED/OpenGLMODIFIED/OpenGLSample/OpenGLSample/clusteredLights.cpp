@@ -0,0 +1,454 @@
+// STL
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CLUSTERED_LIGHTS_SSE2
+#include <emmintrin.h>
+#endif
+
+// Project
+#include "clusteredLights.h"
+#include "common/boundingVolume.h"
+#include "common/glState.h"
+
+const int ClusteredLights::GRID_SIZE_X;
+const int ClusteredLights::GRID_SIZE_Y;
+const int ClusteredLights::GRID_SIZE_Z;
+const int ClusteredLights::NUM_CLUSTERS;
+const GLuint ClusteredLights::LIGHTS_TEXTURE_UNIT = 7;
+const GLuint ClusteredLights::GRID_TEXTURE_UNIT = 8;
+const GLuint ClusteredLights::INDICES_TEXTURE_UNIT = 9;
+const float ClusteredLights::LIGHT_CUTOFF = 1.0f / 256.0f;
+const size_t ClusteredLights::MIN_THREADED_LIGHTS = 256;
+
+namespace
+{
+	const char* SAMPLER_NAMES[] = { "clusterLights", "clusterGrid", "clusterIndices" };
+	const GLenum TEXTURE_FORMATS[] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+
+	enum BufferIndex
+	{
+		LIGHTS_BUFFER,
+		GRID_BUFFER,
+		INDICES_BUFFER
+	};
+
+	// Distance, at which attenuation drops the brightest color channel of the light to the cutoff
+	float computeRange(const PointLight& light, float cutoff)
+	{
+		const auto color = light.ambient + light.diffuse + light.specular;
+		const auto maxIntensity = std::max(std::max(color.x, color.y), color.z);
+
+		// Solves constant + linear * d + quadratic * d^2 = maxIntensity / cutoff
+		const auto c = light.constant - maxIntensity / cutoff;
+		if (c >= 0.0f) {
+			return 0.0f;
+		}
+		if (light.quadratic > 0.0f) {
+			return (-light.linear + std::sqrt(light.linear * light.linear - 4.0f * light.quadratic * c)) / (2.0f * light.quadratic);
+		}
+		if (light.linear > 0.0f) {
+			return -c / light.linear;
+		}
+
+		// Light, that doesn't fade, reaches everything
+		return std::numeric_limits<float>::max();
+	}
+}
+
+bool ClusteredLights::Statistics::operator==(const Statistics& other) const
+{
+	return numLights == other.numLights
+		&& numVisibleLights == other.numVisibleLights
+		&& numIndices == other.numIndices
+		&& maxClusterLights == other.maxClusterLights;
+}
+
+bool ClusteredLights::Statistics::operator!=(const Statistics& other) const
+{
+	return !(*this == other);
+}
+
+void ClusteredLights::Candidates::clear()
+{
+	x.clear();
+	y.clear();
+	z.clear();
+	radiusSquared.clear();
+	indices.clear();
+}
+
+void ClusteredLights::Candidates::add(const glm::vec3& center, float radius, uint16_t index)
+{
+	x.push_back(center.x);
+	y.push_back(center.y);
+	z.push_back(center.z);
+	radiusSquared.push_back(radius * radius);
+	indices.push_back(index);
+}
+
+void ClusteredLights::Candidates::pad()
+{
+	// Negative radius reaches no box
+	while (indices.size() % 4 != 0) {
+		add(glm::vec3(0.0f), 0.0f, 0);
+		radiusSquared.back() = -1.0f;
+	}
+}
+
+ClusteredLights::ClusteredLights(unsigned int numThreads)
+	: _slices(GRID_SIZE_Z)
+	, _workers(numThreads)
+{
+}
+
+void ClusteredLights::createBuffers()
+{
+	if (_bufferIDs[0] != 0)
+	{
+		std::cerr << "Clustered light buffers are already created!" << std::endl;
+		return;
+	}
+
+	glGenBuffers(3, _bufferIDs);
+	glGenTextures(3, _textureIDs);
+
+	// Froxel grid has always the same size, until the first assign() no froxel has any light
+	_grid.assign(NUM_CLUSTERS, glm::uvec2(0));
+
+	const GLuint units[] = { LIGHTS_TEXTURE_UNIT, GRID_TEXTURE_UNIT, INDICES_TEXTURE_UNIT };
+	for (int i = 0; i < 3; i++)
+	{
+		// Buffer must be bound once to exist, before a texture can be attached to it
+		GLState::bindBuffer(GL_TEXTURE_BUFFER, _bufferIDs[i]);
+		if (i == GRID_BUFFER) {
+			glBufferData(GL_TEXTURE_BUFFER, _grid.size() * sizeof(glm::uvec2), _grid.data(), GL_STREAM_DRAW);
+		}
+		GLState::bindTexture(units[i], GL_TEXTURE_BUFFER, _textureIDs[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, TEXTURE_FORMATS[i], _bufferIDs[i]);
+	}
+
+	// Lights set before the buffers existed get uploaded with the next upload()
+	_lightCapacity = _indexCapacity = 0;
+	_areLightsDirty = true;
+}
+
+void ClusteredLights::bindToProgram(GLuint programID)
+{
+	const GLuint units[] = { LIGHTS_TEXTURE_UNIT, GRID_TEXTURE_UNIT, INDICES_TEXTURE_UNIT };
+	for (int i = 0; i < 3; i++)
+	{
+		const auto location = glGetUniformLocation(programID, SAMPLER_NAMES[i]);
+		if (location == -1) {
+			continue;
+		}
+
+		GLState::useProgram(programID);
+		glUniform1i(location, static_cast<GLint>(units[i]));
+	}
+}
+
+void ClusteredLights::setPointLights(const std::vector<PointLight>& pointLights)
+{
+	if (pointLights.size() > size_t(MAX_CLUSTERED_POINT_LIGHTS))
+	{
+		std::cerr << "Too many clustered point lights (" << pointLights.size() << "), there is room for only " << MAX_CLUSTERED_POINT_LIGHTS << " point lights!" << std::endl;
+		return;
+	}
+
+	_pointLights = pointLights;
+	_worldSpheres.resize(_pointLights.size());
+	for (size_t i = 0; i < _pointLights.size(); i++)
+	{
+		auto& pointLight = _pointLights[i];
+		pointLight.padding = computeRange(pointLight, LIGHT_CUTOFF);
+		_worldSpheres[i] = glm::vec4(pointLight.position, pointLight.padding);
+	}
+	_areLightsDirty = true;
+}
+
+void ClusteredLights::setProjection(const glm::mat4& projection, int viewportWidth, int viewportHeight)
+{
+	if (projection == _projection && viewportWidth == _viewportWidth && viewportHeight == _viewportHeight) {
+		return;
+	}
+
+	_projection = projection;
+	_viewportWidth = viewportWidth;
+	_viewportHeight = viewportHeight;
+
+	// Depth range from the depth row of a perspective matrix, m22 = -(far + near) / (far - near) and m32 = -2 * far * near / (far - near)
+	_near = projection[3][2] / (projection[2][2] - 1.0f);
+	_far = projection[3][2] / (projection[2][2] + 1.0f);
+	computeFroxelBoxes();
+}
+
+void ClusteredLights::assign(const glm::mat4& view)
+{
+	if (_rowBoxes.empty())
+	{
+		std::cerr << "Projection of clustered lights is not set!" << std::endl;
+		return;
+	}
+
+	// View space spheres of the lights and range of depth slices they reach
+	const auto numLights = _pointLights.size();
+	_viewSpheres.resize(numLights);
+	_firstSlices.resize(numLights);
+	_lastSlices.resize(numLights);
+	size_t numVisibleLights = 0;
+	for (size_t i = 0; i < numLights; i++)
+	{
+		const auto radius = _worldSpheres[i].w;
+		const auto center = glm::vec3(view * glm::vec4(glm::vec3(_worldSpheres[i]), 1.0f));
+		const auto depth = -center.z;
+		_viewSpheres[i] = glm::vec4(center, radius);
+		if (radius <= 0.0f || depth + radius < _near || depth - radius > _far)
+		{
+			_firstSlices[i] = 1;
+			_lastSlices[i] = 0;
+			continue;
+		}
+
+		_firstSlices[i] = depth - radius <= _near ? 0 : std::min(getSlice(depth - radius), GRID_SIZE_Z - 1);
+		_lastSlices[i] = depth + radius >= _far ? GRID_SIZE_Z - 1 : std::min(getSlice(depth + radius), GRID_SIZE_Z - 1);
+		numVisibleLights++;
+	}
+
+	// Every slice gets its own index list (a slice is filled by one thread only), the lists are concatenated
+	// afterwards. Waking the workers doesn't pay off for few lights
+	_grid.resize(NUM_CLUSTERS);
+	if (numLights < MIN_THREADED_LIGHTS)
+	{
+		for (int slice = 0; slice < GRID_SIZE_Z; slice++) {
+			assignSlice(slice);
+		}
+	}
+	else {
+		_workers.run(GRID_SIZE_Z, [this](size_t slice) { assignSlice(static_cast<int>(slice)); });
+	}
+
+	_indices.clear();
+	_statistics = Statistics();
+	for (int slice = 0; slice < GRID_SIZE_Z; slice++)
+	{
+		const auto sliceOffset = static_cast<GLuint>(_indices.size());
+		const auto firstCluster = GRID_SIZE_X * GRID_SIZE_Y * slice;
+		for (auto cluster = firstCluster; cluster < firstCluster + GRID_SIZE_X * GRID_SIZE_Y; cluster++)
+		{
+			_grid[cluster].x += sliceOffset;
+			_statistics.maxClusterLights = std::max(_statistics.maxClusterLights, size_t(_grid[cluster].y));
+		}
+		_indices.insert(_indices.end(), _slices[slice].indices.begin(), _slices[slice].indices.end());
+	}
+	_statistics.numLights = numLights;
+	_statistics.numVisibleLights = numVisibleLights;
+	_statistics.numIndices = _indices.size();
+}
+
+void ClusteredLights::upload()
+{
+	if (_bufferIDs[0] == 0) {
+		return;
+	}
+
+	if (_areLightsDirty)
+	{
+		GLState::bindBuffer(GL_TEXTURE_BUFFER, _bufferIDs[LIGHTS_BUFFER]);
+		if (_pointLights.size() > _lightCapacity)
+		{
+			_lightCapacity = _pointLights.size();
+			glBufferData(GL_TEXTURE_BUFFER, _lightCapacity * sizeof(PointLight), nullptr, GL_STATIC_DRAW);
+		}
+		if (!_pointLights.empty()) {
+			glBufferSubData(GL_TEXTURE_BUFFER, 0, _pointLights.size() * sizeof(PointLight), _pointLights.data());
+		}
+		_areLightsDirty = false;
+	}
+
+	// Grid and indices change every frame, their storage is orphaned, so that the upload doesn't wait for the previous frame
+	GLState::bindBuffer(GL_TEXTURE_BUFFER, _bufferIDs[GRID_BUFFER]);
+	glBufferData(GL_TEXTURE_BUFFER, _grid.size() * sizeof(glm::uvec2), _grid.data(), GL_STREAM_DRAW);
+
+	GLState::bindBuffer(GL_TEXTURE_BUFFER, _bufferIDs[INDICES_BUFFER]);
+	_indexCapacity = std::max(_indexCapacity, _indices.size() + _indices.size() / 2);
+	glBufferData(GL_TEXTURE_BUFFER, _indexCapacity * sizeof(uint16_t), nullptr, GL_STREAM_DRAW);
+	if (!_indices.empty()) {
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, _indices.size() * sizeof(uint16_t), _indices.data());
+	}
+}
+
+void ClusteredLights::bindTextures() const
+{
+	GLState::bindTexture(LIGHTS_TEXTURE_UNIT, GL_TEXTURE_BUFFER, _textureIDs[LIGHTS_BUFFER]);
+	GLState::bindTexture(GRID_TEXTURE_UNIT, GL_TEXTURE_BUFFER, _textureIDs[GRID_BUFFER]);
+	GLState::bindTexture(INDICES_TEXTURE_UNIT, GL_TEXTURE_BUFFER, _textureIDs[INDICES_BUFFER]);
+}
+
+glm::vec2 ClusteredLights::getTileScale() const
+{
+	return glm::vec2(float(GRID_SIZE_X) / float(std::max(_viewportWidth, 1)), float(GRID_SIZE_Y) / float(std::max(_viewportHeight, 1)));
+}
+
+glm::vec4 ClusteredLights::getDepthParams() const
+{
+	// 1 / view depth is linear in window depth, slices are exponential (log of depth is linear in slice)
+	const auto sliceScale = float(GRID_SIZE_Z) / std::log(_far / _near);
+	return glm::vec4(1.0f / _near, -(_far - _near) / (_near * _far), sliceScale, -std::log(_near) * sliceScale);
+}
+
+size_t ClusteredLights::getNumLights() const
+{
+	return _pointLights.size();
+}
+
+const ClusteredLights::Statistics& ClusteredLights::getStatistics() const
+{
+	return _statistics;
+}
+
+void ClusteredLights::printStatistics() const
+{
+	std::cout << "Clustered lights: " << _statistics.numLights << " lights, " << _statistics.numVisibleLights << " in view depth range, "
+		<< _statistics.numIndices << " light indices in " << NUM_CLUSTERS << " clusters, at most "
+		<< _statistics.maxClusterLights << " lights per cluster" << std::endl;
+}
+
+void ClusteredLights::deleteBuffers()
+{
+	if (_bufferIDs[0] == 0) {
+		return;
+	}
+
+	GLState::deleteTextures(3, _textureIDs);
+	GLState::deleteBuffers(3, _bufferIDs);
+	std::fill(std::begin(_textureIDs), std::end(_textureIDs), 0);
+	std::fill(std::begin(_bufferIDs), std::end(_bufferIDs), 0);
+	_lightCapacity = _indexCapacity = 0;
+}
+
+int ClusteredLights::getSlice(float depth) const
+{
+	const auto depthParams = getDepthParams();
+	return static_cast<int>(std::floor(std::log(depth) * depthParams.z + depthParams.w));
+}
+
+void ClusteredLights::computeFroxelBoxes()
+{
+	// View space point of a froxel corner at given NDC x, y and view depth (inverse of the perspective projection)
+	const auto getCorner = [this](float ndcX, float ndcY, float depth) {
+		return glm::vec3((ndcX + _projection[2][0]) * depth / _projection[0][0], (ndcY + _projection[2][1]) * depth / _projection[1][1], -depth);
+	};
+
+	_rowBoxes.resize(GRID_SIZE_Y * GRID_SIZE_Z);
+	for (int z = 0; z < GRID_SIZE_Z; z++)
+	{
+		const float depths[] = {
+			_near * std::pow(_far / _near, float(z) / GRID_SIZE_Z),
+			_near * std::pow(_far / _near, float(z + 1) / GRID_SIZE_Z)
+		};
+		for (int y = 0; y < GRID_SIZE_Y; y++)
+		{
+			auto& row = _rowBoxes[y + GRID_SIZE_Y * z];
+			BoundingBox rowBox;
+			for (int x = 0; x < GRID_SIZE_X; x++)
+			{
+				BoundingBox box;
+				for (auto depth : depths)
+				{
+					for (int corner = 0; corner < 4; corner++)
+					{
+						const auto ndcX = -1.0f + 2.0f * float(x + corner % 2) / GRID_SIZE_X;
+						const auto ndcY = -1.0f + 2.0f * float(y + corner / 2) / GRID_SIZE_Y;
+						box.include(getCorner(ndcX, ndcY, depth));
+					}
+				}
+				row.minX[x] = box.min.x;
+				row.minY[x] = box.min.y;
+				row.minZ[x] = box.min.z;
+				row.maxX[x] = box.max.x;
+				row.maxY[x] = box.max.y;
+				row.maxZ[x] = box.max.z;
+				rowBox.include(box);
+			}
+			row.rowMin = rowBox.min;
+			row.rowMax = rowBox.max;
+		}
+	}
+}
+
+void ClusteredLights::assignSlice(int slice)
+{
+	auto& indices = _slices[slice].indices;
+	auto& sliceLights = _slices[slice].lights;
+	auto& candidates = _slices[slice].candidates;
+	indices.clear();
+
+	// Lights reaching the slice, narrowed down to the lights touching every row, which are then tested 4 at a time against every froxel
+	sliceLights.clear();
+	for (size_t i = 0; i < _viewSpheres.size(); i++)
+	{
+		if (_firstSlices[i] <= slice && slice <= _lastSlices[i]) {
+			sliceLights.push_back(static_cast<uint16_t>(i));
+		}
+	}
+
+	for (int y = 0; y < GRID_SIZE_Y; y++)
+	{
+		const auto& row = _rowBoxes[y + GRID_SIZE_Y * slice];
+		candidates.clear();
+		for (auto light : sliceLights)
+		{
+			const auto center = glm::vec3(_viewSpheres[light]);
+			const auto radius = _viewSpheres[light].w;
+			const auto offset = glm::max(glm::max(row.rowMin - center, center - row.rowMax), glm::vec3(0.0f));
+			if (glm::dot(offset, offset) <= radius * radius) {
+				candidates.add(center, radius, light);
+			}
+		}
+		candidates.pad();
+
+		for (int x = 0; x < GRID_SIZE_X; x++)
+		{
+			const auto firstIndex = indices.size();
+#ifdef CLUSTERED_LIGHTS_SSE2
+			// Squared distance of the sphere center to the froxel box against squared radius, 4 lights at once
+			const auto minX = _mm_set1_ps(row.minX[x]), minY = _mm_set1_ps(row.minY[x]), minZ = _mm_set1_ps(row.minZ[x]);
+			const auto maxX = _mm_set1_ps(row.maxX[x]), maxY = _mm_set1_ps(row.maxY[x]), maxZ = _mm_set1_ps(row.maxZ[x]);
+			const auto zero = _mm_setzero_ps();
+			for (size_t i = 0; i < candidates.indices.size(); i += 4)
+			{
+				const auto centerX = _mm_loadu_ps(&candidates.x[i]);
+				const auto centerY = _mm_loadu_ps(&candidates.y[i]);
+				const auto centerZ = _mm_loadu_ps(&candidates.z[i]);
+				const auto offsetX = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, centerX), _mm_sub_ps(centerX, maxX)), zero);
+				const auto offsetY = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, centerY), _mm_sub_ps(centerY, maxY)), zero);
+				const auto offsetZ = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, centerZ), _mm_sub_ps(centerZ, maxZ)), zero);
+				const auto distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(offsetX, offsetX), _mm_mul_ps(offsetY, offsetY)), _mm_mul_ps(offsetZ, offsetZ));
+				auto mask = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_loadu_ps(&candidates.radiusSquared[i])));
+				for (size_t lane = i; mask != 0; lane++, mask >>= 1)
+				{
+					if (mask & 1) {
+						indices.push_back(candidates.indices[lane]);
+					}
+				}
+			}
+#else
+			const auto boxMin = glm::vec3(row.minX[x], row.minY[x], row.minZ[x]);
+			const auto boxMax = glm::vec3(row.maxX[x], row.maxY[x], row.maxZ[x]);
+			for (size_t i = 0; i < candidates.indices.size(); i++)
+			{
+				const auto center = glm::vec3(candidates.x[i], candidates.y[i], candidates.z[i]);
+				const auto offset = glm::max(glm::max(boxMin - center, center - boxMax), glm::vec3(0.0f));
+				if (glm::dot(offset, offset) <= candidates.radiusSquared[i]) {
+					indices.push_back(candidates.indices[i]);
+				}
+			}
+#endif
+			_grid[x + GRID_SIZE_X * (y + GRID_SIZE_Y * slice)] = glm::uvec2(GLuint(firstIndex), GLuint(indices.size() - firstIndex));
+		}
+	}
+}
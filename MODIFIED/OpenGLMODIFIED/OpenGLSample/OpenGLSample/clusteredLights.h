@@ -0,0 +1,210 @@
+#pragma once
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "lights.h"
+#include "common/workerPool.h"
+
+/**
+ * Number of point lights clustered lights have room for (light indices are 16 bit).
+ */
+const int MAX_CLUSTERED_POINT_LIGHTS = 65536;
+
+/**
+ * Point lights for clustered forward shading. View frustum is split into a grid of froxels (GRID_SIZE_X x GRID_SIZE_Y
+ * screen tiles, GRID_SIZE_Z exponential depth slices), every frame assign() finds on the CPU which lights reach which
+ * froxel and fragments then evaluate only the lights of their froxel, so that hundreds of lights cost about as much
+ * as the few lights near every fragment. Data live in texture buffers (OpenGL 3.3 has no storage buffers):
+ * - lights: 4 RGBA32F texels per light, same layout as PointLight, padding holds range of the light
+ * - grid: one RG32UI texel per froxel, offset and count of its lights in the index list
+ * - indices: R16UI light indices of all froxels
+ * Meant for the lighting shader compiled with CLUSTERED_LIGHTS (see 6.multiple_lights.fs and LightPermutation).
+ */
+class ClusteredLights
+{
+public:
+	static const int GRID_SIZE_X = 16; // Number of screen tiles along X
+	static const int GRID_SIZE_Y = 9; // Number of screen tiles along Y
+	static const int GRID_SIZE_Z = 24; // Number of depth slices
+	static const int NUM_CLUSTERS = GRID_SIZE_X * GRID_SIZE_Y * GRID_SIZE_Z; // Number of froxels
+	static const GLuint LIGHTS_TEXTURE_UNIT; // Texture unit of the light buffer (7, right after the material textures 0-6)
+	static const GLuint GRID_TEXTURE_UNIT; // Texture unit of the froxel grid buffer (8)
+	static const GLuint INDICES_TEXTURE_UNIT; // Texture unit of the light index buffer (9)
+
+	struct Statistics
+	{
+		size_t numLights = 0; // Lights set
+		size_t numVisibleLights = 0; // Lights within the depth range of the view
+		size_t numIndices = 0; // Light indices of all froxels
+		size_t maxClusterLights = 0; // Most lights assigned to one froxel
+
+		bool operator==(const Statistics& other) const;
+		bool operator!=(const Statistics& other) const;
+	};
+
+	/**
+	 * Starts the threads assign() uses.
+	 *
+	 * @param numThreads  Number of threads including the calling one (ALL_HARDWARE_THREADS to use all)
+	 */
+	explicit ClusteredLights(unsigned int numThreads = ALL_HARDWARE_THREADS);
+
+	/**
+	 * Creates the buffers and their buffer textures.
+	 */
+	void createBuffers();
+
+	/**
+	 * Connects samplers of given program to the texture units of the buffers. Programs without them are ignored.
+	 * Changes the current program.
+	 *
+	 * @param programID  OpenGL ID of the linked program
+	 */
+	static void bindToProgram(GLuint programID);
+
+	/**
+	 * Replaces all lights. Range of every light is computed here from its attenuation and color, lights are
+	 * assigned only to the froxels within their range.
+	 */
+	void setPointLights(const std::vector<PointLight>& pointLights);
+
+	/**
+	 * Sets projection matrix (perspective) and size of the viewport in pixels. Froxel boxes are recomputed
+	 * only when they change.
+	 */
+	void setProjection(const glm::mat4& projection, int viewportWidth, int viewportHeight);
+
+	/**
+	 * Assigns lights to the froxels of the view. Depth slices are handed out to the threads, few lights are
+	 * always assigned on the calling thread.
+	 *
+	 * @param view  View matrix of the frame
+	 */
+	void assign(const glm::mat4& view);
+
+	/**
+	 * Uploads lights (if they changed), froxel grid and light indices of the last assign().
+	 */
+	void upload();
+
+	/**
+	 * Binds the buffer textures to their texture units.
+	 */
+	void bindTextures() const;
+
+	/**
+	 * Gets froxel tiles per pixel (clusterTileScale uniform).
+	 */
+	glm::vec2 getTileScale() const;
+
+	/**
+	 * Gets parameters turning window depth of a fragment to its depth slice (clusterDepthParams uniform):
+	 * view depth = 1 / (x + y * depth), slice = log(view depth) * z + w.
+	 */
+	glm::vec4 getDepthParams() const;
+
+	/**
+	 * Gets number of lights.
+	 */
+	size_t getNumLights() const;
+
+	/**
+	 * Gets statistics of the last assign().
+	 */
+	const Statistics& getStatistics() const;
+
+	/**
+	 * Prints statistics of the last assign().
+	 */
+	void printStatistics() const;
+
+	/**
+	 * Deletes the buffers and their textures.
+	 */
+	void deleteBuffers();
+
+private:
+	static const float LIGHT_CUTOFF; // Light contribution (0 .. 1) at the range of the light
+	static const size_t MIN_THREADED_LIGHTS; // Fewer lights are assigned on the calling thread
+
+	/**
+	 * View space box of every froxel of one row (tiles along X), SoA so that 4 lights are tested against one box at once.
+	 */
+	struct RowBoxes
+	{
+		float minX[GRID_SIZE_X], minY[GRID_SIZE_X], minZ[GRID_SIZE_X];
+		float maxX[GRID_SIZE_X], maxY[GRID_SIZE_X], maxZ[GRID_SIZE_X];
+		glm::vec3 rowMin, rowMax; // Box around the whole row
+	};
+
+	/**
+	 * View space spheres of lights tested against a row, SoA padded to multiple of 4 with lights that reach nothing.
+	 */
+	struct Candidates
+	{
+		std::vector<float> x, y, z, radiusSquared;
+		std::vector<uint16_t> indices;
+
+		void clear();
+		void add(const glm::vec3& center, float radius, uint16_t index);
+		void pad();
+	};
+
+	/**
+	 * Buffers of one depth slice, kept between frames, so that assign() doesn't allocate once they are large enough.
+	 */
+	struct Slice
+	{
+		std::vector<uint16_t> lights; // Lights reaching the slice
+		Candidates candidates; // Lights touching the current row
+		std::vector<uint16_t> indices; // Light indices of the froxels of the slice, before they are concatenated
+	};
+
+	std::vector<PointLight> _pointLights; // Lights with their range in the padding
+	std::vector<glm::vec4> _worldSpheres; // World space position and range of every light
+	std::vector<glm::vec4> _viewSpheres; // View space position and range of every light in the last assign()
+	std::vector<int> _firstSlices, _lastSlices; // Depth slices every light reaches (first > last = none)
+
+	glm::mat4 _projection = glm::mat4(0.0f); // Projection the froxel boxes were computed for
+	int _viewportWidth = 0, _viewportHeight = 0; // Viewport the froxel boxes were computed for
+	float _near = 0.1f, _far = 100.0f; // Depth range of the projection
+	std::vector<RowBoxes> _rowBoxes; // Froxel boxes, row y of slice z at y + GRID_SIZE_Y * z
+
+	std::vector<glm::uvec2> _grid; // Offset and count of every froxel, froxel x, y, z at x + GRID_SIZE_X * (y + GRID_SIZE_Y * z)
+	std::vector<uint16_t> _indices; // Light indices of all froxels
+	std::vector<Slice> _slices; // Buffers of every depth slice, filled by one thread each
+	WorkerPool _workers; // Threads assigning depth slices
+
+	GLuint _bufferIDs[3] = {}; // OpenGL assigned buffer IDs (lights, grid, indices)
+	GLuint _textureIDs[3] = {}; // OpenGL assigned buffer texture IDs (lights, grid, indices)
+	size_t _indexCapacity = 0; // Number of indices the index buffer has room for
+	size_t _lightCapacity = 0; // Number of lights the light buffer has room for
+	bool _areLightsDirty = false; // True, if lights changed since the last upload
+
+	Statistics _statistics; // Statistics of the last assign()
+
+	/**
+	 * Gets depth slice of given view depth (may be out of the grid).
+	 */
+	int getSlice(float depth) const;
+
+	/**
+	 * Computes view space boxes of all froxels.
+	 */
+	void computeFroxelBoxes();
+
+	/**
+	 * Assigns lights to the froxels of given depth slice, grid offsets are relative to the start of its indices.
+	 */
+	void assignSlice(int slice);
+};
@@ -0,0 +1,101 @@
+// STL
+#include <cstring>
+#include <iostream>
+
+// Project
+#include "binaryMesh.h"
+#include "meshFile.h"
+#include "glState.h"
+
+namespace static_meshes_3D {
+
+BinaryMesh::BinaryMesh(const std::string& objPath, const std::string& meshPath, unsigned int numThreads)
+    : StaticMeshIndexed3D(true, true, true, VertexLayout::Packing::Interleaved)
+    , _objPath(objPath)
+    , _meshPath(meshPath.empty() ? objPath + ".mesh" : meshPath)
+    , _numThreads(numThreads)
+{
+    initializeData();
+}
+
+void BinaryMesh::render() const
+{
+    if (!_isInitialized) {
+        return;
+    }
+
+    renderIndexed(GL_TRIANGLES);
+}
+
+bool BinaryMesh::isLoaded() const
+{
+    return _isInitialized;
+}
+
+const glm::vec3& BinaryMesh::getBoundingBoxMin() const
+{
+    return _bounds.box.min;
+}
+
+const glm::vec3& BinaryMesh::getBoundingBoxMax() const
+{
+    return _bounds.box.max;
+}
+
+void BinaryMesh::initializeData()
+{
+    if (_isInitialized) {
+        return;
+    }
+
+    // Text parsing happens only when the binary mesh is missing or stale
+    if (!MeshFile::isUpToDate(_meshPath.c_str(), _objPath.c_str()))
+    {
+        std::cout << "Converting " << _objPath << " to binary mesh " << _meshPath << std::endl;
+        if (!convertOBJToMeshFile(_objPath.c_str(), _meshPath.c_str(), _numThreads)) {
+            return;
+        }
+    }
+
+    MeshFile meshFile;
+    if (!meshFile.open(_meshPath.c_str()))
+    {
+        std::cerr << "Could not load binary mesh " << _meshPath << "!" << std::endl;
+        return;
+    }
+
+    // Layout stored in the file must be the one this mesh sets attribute pointers for
+    const auto& header = meshFile.getHeader();
+    _hasPositions = (header.attributeMask & MeshFileHeader::POSITIONS) != 0;
+    _hasTextureCoordinates = (header.attributeMask & MeshFileHeader::TEXTURE_COORDINATES) != 0;
+    _hasNormals = (header.attributeMask & MeshFileHeader::NORMALS) != 0;
+    _numVertices = static_cast<int>(header.numVertices);
+    const auto& layout = createVertexLayout(_numVertices);
+    if (header.vertexByteSize != static_cast<uint32_t>(getVertexByteSize())
+        || (hasPositions() && header.positionOffset != layout.positionOffset)
+        || (hasTextureCoordinates() && header.textureCoordinateOffset != layout.textureCoordinateOffset)
+        || (hasNormals() && header.normalOffset != layout.normalOffset))
+    {
+        std::cerr << "Binary mesh " << _meshPath << " has unsupported vertex layout!" << std::endl;
+        return;
+    }
+
+    // Box was computed by the conversion, vertices are not read here again just for a tighter sphere
+    BoundingBox boundingBox;
+    memcpy(&boundingBox.min, header.boundingBoxMin, sizeof(header.boundingBoxMin));
+    memcpy(&boundingBox.max, header.boundingBoxMax, sizeof(header.boundingBoxMax));
+    _bounds = MeshBounds::fromBox(boundingBox);
+
+    // Mapped data go straight to the GPU, mapping is released once they are uploaded
+    glGenVertexArrays(1, &_vao);
+    GLState::bindVertexArray(_vao);
+    _vbo.createVBO();
+    _vbo.bindVBO();
+    _vbo.uploadDataToGPU(meshFile.getVertexData(), size_t(header.vertexDataSize), GL_STATIC_DRAW);
+    setVertexAttributesPointers(_numVertices);
+    uploadIndices(meshFile.getIndexData(), static_cast<int>(header.numIndices), header.indexType);
+
+    _isInitialized = true;
+}
+
+} // namespace static_meshes_3D
@@ -0,0 +1,56 @@
+#pragma once
+
+// STL
+#include <string>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "staticMeshIndexed3D.h"
+
+namespace static_meshes_3D {
+
+/**
+ * Static mesh loaded from binary mesh file (see MeshFile), which is converted from an OBJ file.
+ * Conversion runs only when the mesh file is missing or the OBJ file has changed since, otherwise
+ * the mesh file is memory mapped and its data are uploaded to the GPU without any processing.
+ */
+class BinaryMesh : public StaticMeshIndexed3D
+{
+public:
+    /**
+     * Loads mesh converted from given OBJ file.
+     *
+     * @param objPath     Path to the source OBJ file
+     * @param meshPath    Path to the binary mesh file (if empty, objPath with ".mesh" appended is used)
+     * @param numThreads  Number of threads used for parsing the OBJ file, if it has to be converted
+     */
+    BinaryMesh(const std::string& objPath, const std::string& meshPath = "", unsigned int numThreads = 1);
+
+    void render() const override;
+
+    /**
+     * Checks, if the mesh has been loaded successfully.
+     */
+    bool isLoaded() const;
+
+    /**
+     * Gets minimal corner of the axis aligned bounding box of the mesh.
+     */
+    const glm::vec3& getBoundingBoxMin() const;
+
+    /**
+     * Gets maximal corner of the axis aligned bounding box of the mesh.
+     */
+    const glm::vec3& getBoundingBoxMax() const;
+
+private:
+    std::string _objPath; // Path to the source OBJ file
+    std::string _meshPath; // Path to the binary mesh file
+    unsigned int _numThreads; // Number of threads used for parsing the OBJ file
+
+    void initializeData() override;
+};
+
+} // namespace static_meshes_3D
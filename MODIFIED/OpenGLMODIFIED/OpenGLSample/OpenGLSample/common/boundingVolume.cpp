@@ -0,0 +1,124 @@
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Project
+#include "boundingVolume.h"
+
+bool BoundingBox::isEmpty() const
+{
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+void BoundingBox::include(const glm::vec3& point)
+{
+    min = glm::vec3(std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z));
+    max = glm::vec3(std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z));
+}
+
+void BoundingBox::include(const BoundingBox& box)
+{
+    if (box.isEmpty()) {
+        return;
+    }
+
+    include(box.min);
+    include(box.max);
+}
+
+glm::vec3 BoundingBox::getCenter() const
+{
+    return (min + max) * 0.5f;
+}
+
+glm::vec3 BoundingBox::getExtents() const
+{
+    return (max - min) * 0.5f;
+}
+
+BoundingBox BoundingBox::transformed(const glm::mat4& matrix) const
+{
+    if (isEmpty()) {
+        return *this;
+    }
+
+    // Extents of the transformed box are the extents projected to the axes by absolute values of the matrix (Arvo)
+    const auto center = glm::vec3(matrix * glm::vec4(getCenter(), 1.0f));
+    const auto extents = getExtents();
+    glm::vec3 transformedExtents(0.0f);
+    for (int axis = 0; axis < 3; axis++)
+    {
+        transformedExtents += glm::vec3(std::abs(matrix[axis].x), std::abs(matrix[axis].y), std::abs(matrix[axis].z)) * extents[axis];
+    }
+
+    BoundingBox result;
+    result.min = center - transformedExtents;
+    result.max = center + transformedExtents;
+    return result;
+}
+
+bool BoundingSphere::isEmpty() const
+{
+    return radius < 0.0f;
+}
+
+BoundingSphere BoundingSphere::transformed(const glm::mat4& matrix) const
+{
+    if (isEmpty()) {
+        return *this;
+    }
+
+    const auto maxScaleSquared = std::max(std::max(glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+        glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1]))), glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2])));
+
+    BoundingSphere result;
+    result.center = glm::vec3(matrix * glm::vec4(center, 1.0f));
+    result.radius = radius * std::sqrt(maxScaleSquared);
+    return result;
+}
+
+MeshBounds MeshBounds::fromPositions(const void* positions, size_t stride, size_t numPositions)
+{
+    const auto readPosition = [positions, stride](size_t index) {
+        glm::vec3 position;
+        memcpy(&position, static_cast<const unsigned char*>(positions) + stride*index, sizeof(glm::vec3));
+        return position;
+    };
+
+    MeshBounds bounds;
+    for (size_t i = 0; i < numPositions; i++) {
+        bounds.box.include(readPosition(i));
+    }
+    if (bounds.box.isEmpty()) {
+        return bounds;
+    }
+
+    // Sphere around the box center, reaching the farthest vertex (never larger than the box corners)
+    auto maxDistanceSquared = 0.0f;
+    bounds.sphere.center = bounds.box.getCenter();
+    for (size_t i = 0; i < numPositions; i++)
+    {
+        const auto offset = readPosition(i) - bounds.sphere.center;
+        maxDistanceSquared = std::max(maxDistanceSquared, glm::dot(offset, offset));
+    }
+    bounds.sphere.radius = std::sqrt(maxDistanceSquared);
+    return bounds;
+}
+
+MeshBounds MeshBounds::fromBox(const BoundingBox& box)
+{
+    MeshBounds bounds;
+    bounds.box = box;
+    if (!box.isEmpty())
+    {
+        bounds.sphere.center = box.getCenter();
+        bounds.sphere.radius = glm::length(box.getExtents());
+    }
+    return bounds;
+}
+
+bool MeshBounds::isEmpty() const
+{
+    return box.isEmpty();
+}
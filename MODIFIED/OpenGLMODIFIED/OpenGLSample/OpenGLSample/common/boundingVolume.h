@@ -0,0 +1,84 @@
+#pragma once
+
+// STL
+#include <cstddef>
+
+// GLM
+#include <glm/glm.hpp>
+
+/**
+ * Axis aligned bounding box. Default constructed box is empty (contains nothing).
+ */
+struct BoundingBox
+{
+    glm::vec3 min = glm::vec3(1e30f); // Minimal corner
+    glm::vec3 max = glm::vec3(-1e30f); // Maximal corner
+
+    /**
+     * Checks, if the box contains nothing.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Grows the box, so that it contains given point.
+     */
+    void include(const glm::vec3& point);
+
+    /**
+     * Grows the box, so that it contains given box.
+     */
+    void include(const BoundingBox& box);
+
+    glm::vec3 getCenter() const;
+
+    /**
+     * Gets half sizes of the box.
+     */
+    glm::vec3 getExtents() const;
+
+    /**
+     * Gets axis aligned box containing this box transformed by given matrix.
+     */
+    BoundingBox transformed(const glm::mat4& matrix) const;
+};
+
+/**
+ * Bounding sphere. Default constructed sphere is empty (negative radius).
+ */
+struct BoundingSphere
+{
+    glm::vec3 center = glm::vec3(0.0f); // Center of the sphere
+    float radius = -1.0f; // Radius of the sphere
+
+    bool isEmpty() const;
+
+    /**
+     * Gets sphere containing this sphere transformed by given matrix (radius is scaled by the largest axis scale).
+     */
+    BoundingSphere transformed(const glm::mat4& matrix) const;
+};
+
+/**
+ * Bounding box and sphere of a mesh, both in its model space. Box is tighter for boxy meshes,
+ * sphere stays tight when the mesh is rotated, culling uses both.
+ */
+struct MeshBounds
+{
+    BoundingBox box; // Axis aligned bounding box
+    BoundingSphere sphere; // Bounding sphere centered in the box
+
+    /**
+     * Computes bounds of given vertex positions (3 floats every stride bytes).
+     */
+    static MeshBounds fromPositions(const void* positions, size_t stride, size_t numPositions);
+
+    /**
+     * Creates bounds from a box only, sphere encloses the box.
+     */
+    static MeshBounds fromBox(const BoundingBox& box);
+
+    /**
+     * Checks, if the bounds are empty (mesh without positions), such meshes are never culled.
+     */
+    bool isEmpty() const;
+};
@@ -0,0 +1,486 @@
+// STL
+#include <algorithm>
+
+// Project
+#include "boundingVolumeHierarchy.h"
+
+namespace {
+
+    float surfaceArea(const BoundingBox& box)
+    {
+        if (box.isEmpty()) {
+            return 0.0f;
+        }
+
+        const auto size = box.max - box.min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    BoundingBox unite(const BoundingBox& first, const BoundingBox& second)
+    {
+        auto result = first;
+        result.include(second);
+        return result;
+    }
+
+    bool contains(const BoundingBox& outer, const BoundingBox& inner)
+    {
+        return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z
+            && outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+    }
+
+    // Slab test, gives distance where the ray enters the box (0 when it starts inside)
+    bool intersectRay(const BoundingBox& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& entryDistance)
+    {
+        auto tMin = 0.0f;
+        auto tMax = maxDistance;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            auto t1 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+            auto t2 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+            if (t1 > t2) {
+                std::swap(t1, t2);
+            }
+            tMin = std::max(tMin, t1);
+            tMax = std::min(tMax, t2);
+        }
+
+        entryDistance = tMin;
+        return tMin <= tMax;
+    }
+
+} // namespace
+
+const int BoundingVolumeHierarchy::INVALID_ID;
+
+bool BoundingVolumeHierarchy::Node::isLeaf() const
+{
+    return children[0] == INVALID_ID;
+}
+
+int BoundingVolumeHierarchy::insert(const BoundingBox& box, uint32_t userData)
+{
+    int proxyId;
+    if (!_freeProxies.empty())
+    {
+        proxyId = _freeProxies.back();
+        _freeProxies.pop_back();
+    }
+    else
+    {
+        proxyId = static_cast<int>(_proxyLeaves.size());
+        _proxyLeaves.push_back(INVALID_ID);
+        _proxyUserData.push_back(0);
+    }
+
+    const auto leaf = allocateNode();
+    _nodes[leaf].box = box;
+    _nodes[leaf].proxyId = proxyId;
+    _proxyLeaves[proxyId] = leaf;
+    _proxyUserData[proxyId] = userData;
+    _numProxies++;
+
+    insertLeaf(leaf);
+    return proxyId;
+}
+
+void BoundingVolumeHierarchy::remove(int proxyId)
+{
+    const auto leaf = _proxyLeaves[proxyId];
+    removeLeaf(leaf);
+    freeNode(leaf);
+
+    _proxyLeaves[proxyId] = INVALID_ID;
+    _freeProxies.push_back(proxyId);
+    _numProxies--;
+}
+
+void BoundingVolumeHierarchy::update(int proxyId, const BoundingBox& box)
+{
+    const auto leaf = _proxyLeaves[proxyId];
+    const auto parent = _nodes[leaf].parent;
+    _nodes[leaf].box = box;
+
+    // Small moves only refit the path to the root. Object leaving its parent's box would blow up boxes of the
+    // whole path (and every later query would pay for it), it's moved next to a better sibling instead
+    if (parent == INVALID_ID || contains(_nodes[parent].box, box)) {
+        refitAncestors(parent);
+    }
+    else
+    {
+        removeLeaf(leaf);
+        insertLeaf(leaf);
+    }
+}
+
+void BoundingVolumeHierarchy::rebuild()
+{
+    // Leaves are moved to the start of a new pool, internal nodes are then created after them
+    std::vector<Node> leafNodes;
+    std::vector<int> leaves;
+    leafNodes.reserve(_numProxies);
+    leaves.reserve(_numProxies);
+    for (size_t proxyId = 0; proxyId < _proxyLeaves.size(); proxyId++)
+    {
+        if (_proxyLeaves[proxyId] == INVALID_ID) {
+            continue;
+        }
+
+        auto leafNode = _nodes[_proxyLeaves[proxyId]];
+        leafNode.parent = INVALID_ID;
+        _proxyLeaves[proxyId] = static_cast<int>(leafNodes.size());
+        leaves.push_back(static_cast<int>(leafNodes.size()));
+        leafNodes.push_back(leafNode);
+    }
+
+    _nodes.swap(leafNodes);
+    _nodes.reserve(leaves.size() * 2);
+    _freeNodes.clear();
+    _root = leaves.empty() ? INVALID_ID : buildSubtree(leaves.data(), static_cast<int>(leaves.size()));
+    if (_root != INVALID_ID) {
+        _nodes[_root].parent = INVALID_ID;
+    }
+}
+
+void BoundingVolumeHierarchy::clear()
+{
+    _nodes.clear();
+    _freeNodes.clear();
+    _root = INVALID_ID;
+    _proxyLeaves.clear();
+    _proxyUserData.clear();
+    _freeProxies.clear();
+    _numProxies = 0;
+}
+
+size_t BoundingVolumeHierarchy::cull(const Frustum& frustum, std::vector<uint32_t>& userData) const
+{
+    userData.clear();
+    if (_root == INVALID_ID) {
+        return 0;
+    }
+
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(_root);
+    while (!stack.empty())
+    {
+        const auto& node = _nodes[stack.back()];
+        const auto nodeIndex = stack.back();
+        stack.pop_back();
+
+        if (!frustum.intersects(node.box)) {
+            continue;
+        }
+
+        if (node.isLeaf()) {
+            userData.push_back(_proxyUserData[node.proxyId]);
+        }
+        else if (frustum.contains(node.box)) {
+            collectLeaves(nodeIndex, userData);
+        }
+        else
+        {
+            stack.push_back(node.children[0]);
+            stack.push_back(node.children[1]);
+        }
+    }
+
+    return userData.size();
+}
+
+bool BoundingVolumeHierarchy::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const
+{
+    if (_root == INVALID_ID) {
+        return false;
+    }
+
+    // Zero direction components give infinities, which the slab test handles
+    const glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    auto nearestDistance = maxDistance;
+    auto isHit = false;
+
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(_root);
+    while (!stack.empty())
+    {
+        const auto& node = _nodes[stack.back()];
+        stack.pop_back();
+
+        // Subtrees entered farther than the nearest hit so far can't contain a nearer one
+        float entryDistance;
+        if (!intersectRay(node.box, origin, inverseDirection, nearestDistance, entryDistance)) {
+            continue;
+        }
+
+        if (node.isLeaf())
+        {
+            if (!isHit || entryDistance < nearestDistance)
+            {
+                nearestDistance = entryDistance;
+                hit.proxyId = node.proxyId;
+                hit.userData = _proxyUserData[node.proxyId];
+                hit.distance = entryDistance;
+                isHit = true;
+            }
+            continue;
+        }
+
+        // Nearer child is visited first (pushed last), so that farther subtrees get pruned more often
+        float firstDistance, secondDistance;
+        const auto isFirstHit = intersectRay(_nodes[node.children[0]].box, origin, inverseDirection, nearestDistance, firstDistance);
+        const auto isSecondHit = intersectRay(_nodes[node.children[1]].box, origin, inverseDirection, nearestDistance, secondDistance);
+        if (isFirstHit && isSecondHit)
+        {
+            const auto isFirstNearer = firstDistance <= secondDistance;
+            stack.push_back(node.children[isFirstNearer ? 1 : 0]);
+            stack.push_back(node.children[isFirstNearer ? 0 : 1]);
+        }
+        else if (isFirstHit) {
+            stack.push_back(node.children[0]);
+        }
+        else if (isSecondHit) {
+            stack.push_back(node.children[1]);
+        }
+    }
+
+    return isHit;
+}
+
+const BoundingBox& BoundingVolumeHierarchy::getBox(int proxyId) const
+{
+    return _nodes[_proxyLeaves[proxyId]].box;
+}
+
+uint32_t BoundingVolumeHierarchy::getUserData(int proxyId) const
+{
+    return _proxyUserData[proxyId];
+}
+
+size_t BoundingVolumeHierarchy::getSize() const
+{
+    return _numProxies;
+}
+
+int BoundingVolumeHierarchy::getHeight() const
+{
+    return _root == INVALID_ID ? 0 : _nodes[_root].height;
+}
+
+int BoundingVolumeHierarchy::allocateNode()
+{
+    if (_freeNodes.empty())
+    {
+        _nodes.push_back(Node());
+        return static_cast<int>(_nodes.size()) - 1;
+    }
+
+    const auto node = _freeNodes.back();
+    _freeNodes.pop_back();
+    _nodes[node] = Node();
+    return node;
+}
+
+void BoundingVolumeHierarchy::freeNode(int node)
+{
+    _freeNodes.push_back(node);
+}
+
+void BoundingVolumeHierarchy::insertLeaf(int leaf)
+{
+    if (_root == INVALID_ID)
+    {
+        _root = leaf;
+        _nodes[leaf].parent = INVALID_ID;
+        return;
+    }
+
+    // Descend towards the sibling, whose pairing with the leaf adds the least surface area (Box2D dynamic tree).
+    // Every node above the sibling grows by the same amount, which is the inherited cost of going deeper
+    const auto leafBox = _nodes[leaf].box;
+    auto sibling = _root;
+    while (!_nodes[sibling].isLeaf())
+    {
+        const auto& node = _nodes[sibling];
+        const auto area = surfaceArea(node.box);
+        const auto combinedArea = surfaceArea(unite(node.box, leafBox));
+        const auto cost = 2.0f * combinedArea;
+        const auto inheritedCost = 2.0f * (combinedArea - area);
+
+        float childCosts[2];
+        for (int i = 0; i < 2; i++)
+        {
+            const auto& child = _nodes[node.children[i]];
+            const auto childCombinedArea = surfaceArea(unite(child.box, leafBox));
+            childCosts[i] = (child.isLeaf() ? childCombinedArea : childCombinedArea - surfaceArea(child.box)) + inheritedCost;
+        }
+
+        if (cost < childCosts[0] && cost < childCosts[1]) {
+            break;
+        }
+        sibling = node.children[childCosts[0] <= childCosts[1] ? 0 : 1];
+    }
+
+    // New parent takes place of the sibling
+    const auto oldParent = _nodes[sibling].parent;
+    const auto newParent = allocateNode();
+    _nodes[newParent].parent = oldParent;
+    _nodes[newParent].children[0] = sibling;
+    _nodes[newParent].children[1] = leaf;
+    _nodes[sibling].parent = newParent;
+    _nodes[leaf].parent = newParent;
+    if (oldParent == INVALID_ID) {
+        _root = newParent;
+    }
+    else
+    {
+        auto& oldParentNode = _nodes[oldParent];
+        oldParentNode.children[oldParentNode.children[0] == sibling ? 0 : 1] = newParent;
+    }
+
+    refitAncestors(newParent);
+}
+
+void BoundingVolumeHierarchy::removeLeaf(int leaf)
+{
+    if (leaf == _root)
+    {
+        _root = INVALID_ID;
+        return;
+    }
+
+    // Sibling takes place of the parent
+    const auto parent = _nodes[leaf].parent;
+    const auto grandParent = _nodes[parent].parent;
+    const auto sibling = _nodes[parent].children[_nodes[parent].children[0] == leaf ? 1 : 0];
+    _nodes[sibling].parent = grandParent;
+    _nodes[leaf].parent = INVALID_ID;
+    freeNode(parent);
+
+    if (grandParent == INVALID_ID)
+    {
+        _root = sibling;
+        return;
+    }
+
+    auto& grandParentNode = _nodes[grandParent];
+    grandParentNode.children[grandParentNode.children[0] == parent ? 0 : 1] = sibling;
+    refitAncestors(grandParent);
+}
+
+void BoundingVolumeHierarchy::refitAncestors(int node)
+{
+    while (node != INVALID_ID)
+    {
+        auto& current = _nodes[node];
+        const auto& first = _nodes[current.children[0]];
+        const auto& second = _nodes[current.children[1]];
+        current.box = unite(first.box, second.box);
+        current.height = 1 + std::max(first.height, second.height);
+        node = current.parent;
+    }
+}
+
+int BoundingVolumeHierarchy::buildSubtree(int* leaves, int numLeaves)
+{
+    if (numLeaves == 1) {
+        return leaves[0];
+    }
+
+    // Splits are searched along the axis, where box centers are spread the most
+    BoundingBox centerBounds;
+    for (int i = 0; i < numLeaves; i++) {
+        centerBounds.include(_nodes[leaves[i]].box.getCenter());
+    }
+    const auto centerSize = centerBounds.max - centerBounds.min;
+    const auto axis = centerSize.x >= centerSize.y && centerSize.x >= centerSize.z ? 0 : (centerSize.y >= centerSize.z ? 1 : 2);
+    const auto axisMin = centerBounds.min[axis];
+    const auto axisSize = centerSize[axis];
+
+    auto numLeft = numLeaves / 2;
+    if (axisSize > 0.0f)
+    {
+        const auto getBin = [&](int leaf) {
+            const auto bin = static_cast<int>((_nodes[leaf].box.getCenter()[axis] - axisMin) / axisSize * NUM_SAH_BINS);
+            return std::min(bin, NUM_SAH_BINS - 1);
+        };
+
+        int binCounts[NUM_SAH_BINS] = {};
+        BoundingBox binBoxes[NUM_SAH_BINS];
+        for (int i = 0; i < numLeaves; i++)
+        {
+            const auto bin = getBin(leaves[i]);
+            binCounts[bin]++;
+            binBoxes[bin].include(_nodes[leaves[i]].box);
+        }
+
+        // Cost of split before bin s is area * count of both sides, right sides are accumulated from the end first
+        float rightCosts[NUM_SAH_BINS] = {};
+        BoundingBox rightBox;
+        auto rightCount = 0;
+        for (int bin = NUM_SAH_BINS - 1; bin > 0; bin--)
+        {
+            rightBox.include(binBoxes[bin]);
+            rightCount += binCounts[bin];
+            rightCosts[bin] = surfaceArea(rightBox) * rightCount;
+        }
+
+        BoundingBox leftBox;
+        auto leftCount = 0;
+        auto bestCost = -1.0f;
+        auto bestSplit = 0;
+        for (int split = 1; split < NUM_SAH_BINS; split++)
+        {
+            leftBox.include(binBoxes[split - 1]);
+            leftCount += binCounts[split - 1];
+            const auto cost = surfaceArea(leftBox) * leftCount + rightCosts[split];
+            if (leftCount > 0 && leftCount < numLeaves && (bestCost < 0.0f || cost < bestCost))
+            {
+                bestCost = cost;
+                bestSplit = split;
+            }
+        }
+
+        if (bestSplit > 0) {
+            numLeft = static_cast<int>(std::partition(leaves, leaves + numLeaves, [&](int leaf) { return getBin(leaf) < bestSplit; }) - leaves);
+        }
+    }
+
+    // All centers in one place (or in one bin), leaves are just halved
+    if (numLeft == 0 || numLeft == numLeaves) {
+        numLeft = numLeaves / 2;
+    }
+
+    const auto node = allocateNode();
+    const auto left = buildSubtree(leaves, numLeft);
+    const auto right = buildSubtree(leaves + numLeft, numLeaves - numLeft);
+    auto& current = _nodes[node];
+    current.children[0] = left;
+    current.children[1] = right;
+    current.box = unite(_nodes[left].box, _nodes[right].box);
+    current.height = 1 + std::max(_nodes[left].height, _nodes[right].height);
+    _nodes[left].parent = node;
+    _nodes[right].parent = node;
+    return node;
+}
+
+void BoundingVolumeHierarchy::collectLeaves(int node, std::vector<uint32_t>& userData) const
+{
+    std::vector<int> stack;
+    stack.push_back(node);
+    while (!stack.empty())
+    {
+        const auto& current = _nodes[stack.back()];
+        stack.pop_back();
+
+        if (current.isLeaf()) {
+            userData.push_back(_proxyUserData[current.proxyId]);
+        }
+        else
+        {
+            stack.push_back(current.children[0]);
+            stack.push_back(current.children[1]);
+        }
+    }
+}
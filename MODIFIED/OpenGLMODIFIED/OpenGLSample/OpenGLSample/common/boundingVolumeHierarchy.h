@@ -0,0 +1,159 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "boundingVolume.h"
+#include "frustum.h"
+
+/**
+ * Dynamic bounding volume hierarchy (binary tree of axis aligned boxes) over world space boxes of scene objects.
+ * Objects are inserted and removed one by one (new leaf goes next to the sibling, that grows the tree surface
+ * area the least), moved objects refit the boxes on the path to the root (or get reinserted, if they moved far).
+ * rebuild() builds the whole tree again with the binned surface area heuristic (SAH), which is worth calling
+ * after bulk inserts.
+ * Frustum culling and ray picking visit only the subtrees their frustum or ray touches.
+ */
+class BoundingVolumeHierarchy
+{
+public:
+    static const int INVALID_ID = -1; // Proxy ID of no object
+
+    /**
+     * Object hit by a ray.
+     */
+    struct RayHit
+    {
+        int proxyId = INVALID_ID; // Proxy of the hit object
+        uint32_t userData = 0; // User data of the hit object
+        float distance = 0.0f; // Distance along the ray, where the ray enters the object's box
+    };
+
+    /**
+     * Inserts object with given world space box.
+     *
+     * @param box       World space bounding box of the object
+     * @param userData  Value returned for the object by queries (e.g. index of the object in the scene)
+     *
+     * @return Proxy ID of the object, valid until the object is removed.
+     */
+    int insert(const BoundingBox& box, uint32_t userData);
+
+    /**
+     * Removes object with given proxy ID.
+     */
+    void remove(int proxyId);
+
+    /**
+     * Changes box of the object (after its transform changed) and refits boxes of all its ancestors. Object,
+     * that left the box of its parent, is reinserted instead, so that far moves don't degrade the tree.
+     */
+    void update(int proxyId, const BoundingBox& box);
+
+    /**
+     * Builds the tree again from all objects using the binned SAH. Proxy IDs stay valid.
+     */
+    void rebuild();
+
+    /**
+     * Removes all objects.
+     */
+    void clear();
+
+    /**
+     * Finds objects, whose boxes intersect the frustum. Subtrees completely inside are taken without testing.
+     *
+     * @param frustum   Tested frustum
+     * @param userData  Receives user data of the visible objects (cleared first)
+     *
+     * @return Number of visible objects.
+     */
+    size_t cull(const Frustum& frustum, std::vector<uint32_t>& userData) const;
+
+    /**
+     * Finds the nearest object, whose box is hit by the ray (e.g. from camera position along its front vector).
+     *
+     * @param origin       Origin of the ray
+     * @param direction    Direction of the ray (doesn't have to be normalized, distances are in its lengths then)
+     * @param maxDistance  Objects farther than this are ignored
+     * @param hit          Receives the hit object
+     *
+     * @return True, if an object was hit.
+     */
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const;
+
+    /**
+     * Gets box of the object.
+     */
+    const BoundingBox& getBox(int proxyId) const;
+
+    /**
+     * Gets user data of the object.
+     */
+    uint32_t getUserData(int proxyId) const;
+
+    /**
+     * Gets number of objects.
+     */
+    size_t getSize() const;
+
+    /**
+     * Gets height of the tree (0 for empty tree or a single object).
+     */
+    int getHeight() const;
+
+private:
+    static const int NUM_SAH_BINS = 16; // Number of bins candidate splits are evaluated for during rebuild()
+
+    struct Node
+    {
+        BoundingBox box; // Box containing the whole subtree
+        int parent = INVALID_ID; // Parent node index
+        int children[2] = { INVALID_ID, INVALID_ID }; // Child node indices, leaves have none
+        int proxyId = INVALID_ID; // Object of the leaf
+        int height = 0; // Height of the subtree (0 for leaves)
+
+        bool isLeaf() const;
+    };
+
+    std::vector<Node> _nodes; // Node pool
+    std::vector<int> _freeNodes; // Indices of unused nodes in the pool
+    int _root = INVALID_ID; // Root node index
+    std::vector<int> _proxyLeaves; // Leaf node of every proxy (INVALID_ID for unused proxies)
+    std::vector<uint32_t> _proxyUserData; // User data of every proxy
+    std::vector<int> _freeProxies; // Unused proxy IDs
+    size_t _numProxies = 0; // Number of used proxies
+
+    int allocateNode();
+    void freeNode(int node);
+
+    /**
+     * Links leaf into the tree next to the sibling with the lowest SAH cost.
+     */
+    void insertLeaf(int leaf);
+
+    /**
+     * Unlinks leaf from the tree (leaf node itself is kept).
+     */
+    void removeLeaf(int leaf);
+
+    /**
+     * Recomputes boxes and heights from given node up to the root.
+     */
+    void refitAncestors(int node);
+
+    /**
+     * Builds subtree over given leaves with the binned SAH and returns its root.
+     */
+    int buildSubtree(int* leaves, int numLeaves);
+
+    /**
+     * Appends user data of all leaves of the subtree.
+     */
+    void collectLeaves(int node, std::vector<uint32_t>& userData) const;
+};
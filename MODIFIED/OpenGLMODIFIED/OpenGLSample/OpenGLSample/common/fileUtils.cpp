@@ -0,0 +1,126 @@
+// STL
+#include <algorithm>
+#include <cstdio>
+
+// Platform
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#else
+#include <dirent.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+
+// Project
+#include "fileUtils.h"
+#include "hash.h"
+#include "mappedFile.h"
+
+bool getFileInfo(const char* path, bool computeHash, FileInfo& info)
+{
+#ifdef _WIN32
+    struct _stat64 fileStat;
+    if (_stat64(path, &fileStat) != 0) {
+        return false;
+    }
+#else
+    struct stat fileStat;
+    if (stat(path, &fileStat) != 0) {
+        return false;
+    }
+#endif
+
+    info.modificationTime = static_cast<int64_t>(fileStat.st_mtime);
+    info.size = static_cast<uint64_t>(fileStat.st_size);
+    info.hash = 0;
+    if (computeHash)
+    {
+        MappedFile file;
+        if (!file.open(path)) {
+            return false;
+        }
+        info.hash = hashData(file.getData(), file.getSize());
+    }
+
+    return true;
+}
+
+bool isBuiltFromCurrentSource(const char* builtPath, uint64_t modificationTimeOffset, const FileInfo& recordedInfo, const char* sourcePath)
+{
+    FileInfo sourceInfo;
+    if (!getFileInfo(sourcePath, false, sourceInfo) || sourceInfo.size != recordedInfo.size) {
+        return false;
+    }
+    if (sourceInfo.modificationTime == recordedInfo.modificationTime) {
+        return true;
+    }
+
+    // Source file has been touched, it's still fine if its contents are the same
+    if (!getFileInfo(sourcePath, true, sourceInfo) || sourceInfo.hash != recordedInfo.hash) {
+        return false;
+    }
+
+    // Remember the new modification time, so that the source isn't hashed again next time
+    overwriteFile(builtPath, modificationTimeOffset, &sourceInfo.modificationTime, sizeof(sourceInfo.modificationTime));
+    return true;
+}
+
+bool overwriteFile(const char* path, uint64_t offset, const void* data, size_t size)
+{
+    const auto file = fopen(path, "r+b");
+    if (file == nullptr) {
+        return false;
+    }
+
+    const auto isWritten = fseek(file, long(offset), SEEK_SET) == 0 && fwrite(data, 1, size, file) == size;
+    return fclose(file) == 0 && isWritten;
+}
+
+void createDirectory(const std::string& path)
+{
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+std::vector<std::string> listFiles(const std::string& directory)
+{
+    std::vector<std::string> paths;
+#ifdef _WIN32
+    WIN32_FIND_DATAA findData;
+    const auto findHandle = FindFirstFileA((directory + "\\*").c_str(), &findData);
+    if (findHandle == INVALID_HANDLE_VALUE) {
+        return paths;
+    }
+    do
+    {
+        if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            paths.push_back(directory + "/" + findData.cFileName);
+        }
+    } while (FindNextFileA(findHandle, &findData));
+    FindClose(findHandle);
+#else
+    const auto dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return paths;
+    }
+    while (const auto entry = readdir(dir))
+    {
+        struct stat fileStat;
+        const auto path = directory + "/" + entry->d_name;
+        if (stat(path.c_str(), &fileStat) == 0 && S_ISREG(fileStat.st_mode)) {
+            paths.push_back(path);
+        }
+    }
+    closedir(dir);
+#endif
+
+    // Listing order differs between platforms
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Identification of a source file, that other files (mesh files, cooked textures) are built from.
+ */
+struct FileInfo
+{
+    uint64_t hash = 0; // Hash of the file contents (only if requested)
+    int64_t modificationTime = 0; // Modification time (seconds since epoch)
+    uint64_t size = 0; // Size of the file (in bytes)
+};
+
+/**
+ * Gets identification of given file.
+ *
+ * @param path         Path to the file
+ * @param computeHash  Whether to hash contents of the file too (reads the whole file)
+ * @param info         Output identification
+ *
+ * @return True, if the file exists and could be read.
+ */
+bool getFileInfo(const char* path, bool computeHash, FileInfo& info);
+
+/**
+ * Checks, if file was built from the current version of its source file. Modification time and size
+ * are compared first, source file is hashed only if they differ (so that just touched source files
+ * don't trigger rebuilding). If the hash matches, the new modification time is written into the built
+ * file, so that the touched source is hashed only once.
+ *
+ * @param builtPath               Path to the built file (must not be mapped)
+ * @param modificationTimeOffset  Byte offset of the recorded source modification time (int64_t) in the built file
+ * @param recordedInfo            Identification of the source file recorded in the built file
+ * @param sourcePath              Path to the source file
+ */
+bool isBuiltFromCurrentSource(const char* builtPath, uint64_t modificationTimeOffset, const FileInfo& recordedInfo, const char* sourcePath);
+
+/**
+ * Overwrites bytes of an existing file at given offset (the file must not be mapped).
+ *
+ * @return True, if all bytes have been written.
+ */
+bool overwriteFile(const char* path, uint64_t offset, const void* data, size_t size);
+
+/**
+ * Creates directory, if it doesn't exist yet (its parent must exist).
+ */
+void createDirectory(const std::string& path);
+
+/**
+ * Lists files in given directory (not searched recursively, subdirectories are left out).
+ *
+ * @return Paths of the files including the directory, sorted.
+ */
+std::vector<std::string> listFiles(const std::string& directory);
@@ -0,0 +1,185 @@
+// STL
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Project
+#include "frustum.h"
+
+void BoundingVolumeArray::clear()
+{
+    for (auto array : { &boxCenterX, &boxCenterY, &boxCenterZ, &boxExtentX, &boxExtentY, &boxExtentZ,
+        &sphereCenterX, &sphereCenterY, &sphereCenterZ, &sphereRadius }) {
+        array->clear();
+    }
+}
+
+void BoundingVolumeArray::add(const BoundingBox& box, const BoundingSphere& sphere)
+{
+    const auto center = box.getCenter();
+    const auto extents = box.getExtents();
+    boxCenterX.push_back(center.x);
+    boxCenterY.push_back(center.y);
+    boxCenterZ.push_back(center.z);
+    boxExtentX.push_back(extents.x);
+    boxExtentY.push_back(extents.y);
+    boxExtentZ.push_back(extents.z);
+    sphereCenterX.push_back(sphere.center.x);
+    sphereCenterY.push_back(sphere.center.y);
+    sphereCenterZ.push_back(sphere.center.z);
+    sphereRadius.push_back(sphere.radius);
+}
+
+void BoundingVolumeArray::addUnbounded()
+{
+    // Huge, but finite extents, so that they don't produce NaN when multiplied by zero plane components
+    BoundingBox box;
+    box.min = glm::vec3(-FLT_MAX / 4.0f);
+    box.max = glm::vec3(FLT_MAX / 4.0f);
+    BoundingSphere sphere;
+    sphere.radius = FLT_MAX / 4.0f;
+    add(box, sphere);
+}
+
+size_t BoundingVolumeArray::size() const
+{
+    return boxCenterX.size();
+}
+
+Frustum::Frustum()
+{
+    // Planes, that every point is in front of
+    for (auto& plane : _planes) {
+        plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+    // Gribb & Hartmann: clip space -w <= x, y, z <= w expressed with rows of the matrix (GLM matrices are column major)
+    const auto row = [&viewProjection](int index) {
+        return glm::vec4(viewProjection[0][index], viewProjection[1][index], viewProjection[2][index], viewProjection[3][index]);
+    };
+    _planes[0] = row(3) + row(0);
+    _planes[1] = row(3) - row(0);
+    _planes[2] = row(3) + row(1);
+    _planes[3] = row(3) - row(1);
+    _planes[4] = row(3) + row(2);
+    _planes[5] = row(3) - row(2);
+
+    for (auto& plane : _planes) {
+        plane = plane * (1.0f / glm::length(glm::vec3(plane)));
+    }
+}
+
+bool Frustum::intersects(const BoundingBox& box) const
+{
+    const auto center = box.getCenter();
+    const auto extents = box.getExtents();
+    for (const auto& plane : _planes)
+    {
+        // Box is outside, if even its corner farthest along the plane normal is behind the plane
+        const auto distance = glm::dot(glm::vec3(plane), center) + plane.w;
+        const auto radius = std::abs(plane.x) * extents.x + std::abs(plane.y) * extents.y + std::abs(plane.z) * extents.z;
+        if (distance + radius < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::intersects(const BoundingSphere& sphere) const
+{
+    for (const auto& plane : _planes)
+    {
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w + sphere.radius < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::contains(const BoundingBox& box) const
+{
+    const auto center = box.getCenter();
+    const auto extents = box.getExtents();
+    for (const auto& plane : _planes)
+    {
+        // Even the corner farthest against the plane normal must be in front of the plane
+        const auto distance = glm::dot(glm::vec3(plane), center) + plane.w;
+        const auto radius = std::abs(plane.x) * extents.x + std::abs(plane.y) * extents.y + std::abs(plane.z) * extents.z;
+        if (distance - radius < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t Frustum::cull(const BoundingVolumeArray& volumes, std::vector<uint8_t>& isVisible) const
+{
+    const auto numVolumes = volumes.size();
+    isVisible.resize(numVolumes);
+    size_t numVisible = 0;
+    size_t i = 0;
+
+#ifdef FRUSTUM_USE_SSE2
+    const auto absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    for (; i + 4 <= numVolumes; i += 4)
+    {
+        const auto boxX = _mm_loadu_ps(&volumes.boxCenterX[i]), boxY = _mm_loadu_ps(&volumes.boxCenterY[i]), boxZ = _mm_loadu_ps(&volumes.boxCenterZ[i]);
+        const auto extentX = _mm_loadu_ps(&volumes.boxExtentX[i]), extentY = _mm_loadu_ps(&volumes.boxExtentY[i]), extentZ = _mm_loadu_ps(&volumes.boxExtentZ[i]);
+        const auto sphereX = _mm_loadu_ps(&volumes.sphereCenterX[i]), sphereY = _mm_loadu_ps(&volumes.sphereCenterY[i]), sphereZ = _mm_loadu_ps(&volumes.sphereCenterZ[i]);
+        const auto radius = _mm_loadu_ps(&volumes.sphereRadius[i]);
+
+        // Lanes become set, once the box or the sphere of the object is behind any of the planes
+        auto isOutside = _mm_setzero_ps();
+        for (const auto& plane : _planes)
+        {
+            const auto normalX = _mm_set1_ps(plane.x), normalY = _mm_set1_ps(plane.y), normalZ = _mm_set1_ps(plane.z);
+            const auto distance = _mm_set1_ps(plane.w);
+
+            const auto boxDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, boxX), _mm_mul_ps(normalY, boxY)), _mm_add_ps(_mm_mul_ps(normalZ, boxZ), distance));
+            const auto boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(normalX, absMask), extentX), _mm_mul_ps(_mm_and_ps(normalY, absMask), extentY)),
+                _mm_mul_ps(_mm_and_ps(normalZ, absMask), extentZ));
+            const auto sphereDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, sphereX), _mm_mul_ps(normalY, sphereY)), _mm_add_ps(_mm_mul_ps(normalZ, sphereZ), distance));
+
+            isOutside = _mm_or_ps(isOutside, _mm_cmplt_ps(_mm_add_ps(boxDistance, boxRadius), _mm_setzero_ps()));
+            isOutside = _mm_or_ps(isOutside, _mm_cmplt_ps(_mm_add_ps(sphereDistance, radius), _mm_setzero_ps()));
+        }
+
+        const auto outsideBits = _mm_movemask_ps(isOutside);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            isVisible[i + lane] = (outsideBits & (1 << lane)) == 0 ? 1 : 0;
+            numVisible += isVisible[i + lane];
+        }
+    }
+#endif
+
+    // Objects not filling a whole batch (or all of them without SSE2)
+    for (; i < numVolumes; i++)
+    {
+        BoundingBox box;
+        const glm::vec3 center(volumes.boxCenterX[i], volumes.boxCenterY[i], volumes.boxCenterZ[i]);
+        const glm::vec3 extents(volumes.boxExtentX[i], volumes.boxExtentY[i], volumes.boxExtentZ[i]);
+        box.min = center - extents;
+        box.max = center + extents;
+        BoundingSphere sphere;
+        sphere.center = glm::vec3(volumes.sphereCenterX[i], volumes.sphereCenterY[i], volumes.sphereCenterZ[i]);
+        sphere.radius = volumes.sphereRadius[i];
+
+        isVisible[i] = intersects(box) && intersects(sphere) ? 1 : 0;
+        numVisible += isVisible[i];
+    }
+
+    return numVisible;
+}
+
+const glm::vec4& Frustum::getPlane(int index) const
+{
+    return _planes[index];
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "boundingVolume.h"
+
+/**
+ * World space bounding boxes and spheres of many objects, stored as arrays of single components (structure of arrays),
+ * so that the same component of 4 objects fills one SSE register.
+ */
+struct BoundingVolumeArray
+{
+    std::vector<float> boxCenterX, boxCenterY, boxCenterZ; // Centers of the boxes
+    std::vector<float> boxExtentX, boxExtentY, boxExtentZ; // Half sizes of the boxes
+    std::vector<float> sphereCenterX, sphereCenterY, sphereCenterZ; // Centers of the spheres
+    std::vector<float> sphereRadius; // Radii of the spheres
+
+    void clear();
+
+    /**
+     * Adds volumes of one object.
+     */
+    void add(const BoundingBox& box, const BoundingSphere& sphere);
+
+    /**
+     * Adds object without bounds, it passes every test.
+     */
+    void addUnbounded();
+
+    size_t size() const;
+};
+
+/**
+ * View frustum given by its six planes, extracted from a view projection matrix.
+ */
+class Frustum
+{
+public:
+    static const int NUM_PLANES = 6;
+
+    /**
+     * Creates frustum containing everything.
+     */
+    Frustum();
+
+    /**
+     * Extracts frustum planes from projection * view (world space planes) or from projection only (view space planes).
+     */
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    /**
+     * Checks, if the box is at least partially inside (conservative, may report boxes near the corners as inside).
+     */
+    bool intersects(const BoundingBox& box) const;
+
+    /**
+     * Checks, if the sphere is at least partially inside (conservative as well).
+     */
+    bool intersects(const BoundingSphere& sphere) const;
+
+    /**
+     * Checks, if the box is completely inside, so that everything in it is inside as well.
+     */
+    bool contains(const BoundingBox& box) const;
+
+    /**
+     * Tests all volumes of the array, 4 objects at a time with SSE2. Object is visible, if both its box
+     * and its sphere intersect the frustum.
+     *
+     * @param volumes    Tested volumes
+     * @param isVisible  Receives 1 for visible and 0 for culled objects, one per object
+     *
+     * @return Number of visible objects.
+     */
+    size_t cull(const BoundingVolumeArray& volumes, std::vector<uint8_t>& isVisible) const;
+
+    /**
+     * Gets plane with given index (left, right, bottom, top, near, far), normal xyz points inside, w is the distance.
+     */
+    const glm::vec4& getPlane(int index) const;
+
+private:
+    glm::vec4 _planes[NUM_PLANES]; // Normalized planes, point p is inside, if dot(plane.xyz, p) + plane.w >= 0 for all of them
+};
@@ -0,0 +1,293 @@
+// STL
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+// Project
+#include "glState.h"
+
+namespace {
+
+    const GLuint UNKNOWN = std::numeric_limits<GLuint>::max(); // Marks binding, that is not known
+
+    const GLenum TEXTURE_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D, GL_TEXTURE_BUFFER };
+    const GLenum BUFFER_TARGETS[] = { GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_PIXEL_UNPACK_BUFFER,
+        GL_PIXEL_PACK_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_TEXTURE_BUFFER };
+    const GLenum CAPABILITIES[] = { GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_PRIMITIVE_RESTART, GL_SCISSOR_TEST,
+        GL_STENCIL_TEST, GL_POLYGON_OFFSET_FILL, GL_MULTISAMPLE, GL_FRAMEBUFFER_SRGB };
+
+    const int NUM_TEXTURE_TARGETS = sizeof(TEXTURE_TARGETS) / sizeof(GLenum);
+    const int NUM_BUFFER_TARGETS = sizeof(BUFFER_TARGETS) / sizeof(GLenum);
+    const int NUM_CAPABILITIES = sizeof(CAPABILITIES) / sizeof(GLenum);
+
+    const char* CALL_NAMES[GLState::NUM_CALLS] = { "glUseProgram", "glBindVertexArray", "glActiveTexture", "glBindTexture",
+        "glBindBuffer", "glBindBufferBase", "glEnable/glDisable", "glPrimitiveRestartIndex" };
+
+    // Shadowed state of the context, everything starts unknown
+    struct State
+    {
+        GLuint program = UNKNOWN;
+        GLuint vao = UNKNOWN;
+        GLuint activeUnit = UNKNOWN;
+        GLuint textures[GLState::MAX_TEXTURE_UNITS][NUM_TEXTURE_TARGETS];
+        GLuint buffers[NUM_BUFFER_TARGETS];
+        GLuint uniformBuffers[GLState::MAX_INDEXED_BUFFERS];
+        int capabilities[NUM_CAPABILITIES]; // -1 unknown, 0 disabled, 1 enabled
+        GLuint primitiveRestartIndex = UNKNOWN;
+
+        State()
+        {
+            std::fill(&textures[0][0], &textures[0][0] + GLState::MAX_TEXTURE_UNITS * NUM_TEXTURE_TARGETS, UNKNOWN);
+            std::fill(std::begin(buffers), std::end(buffers), UNKNOWN);
+            std::fill(std::begin(uniformBuffers), std::end(uniformBuffers), UNKNOWN);
+            std::fill(std::begin(capabilities), std::end(capabilities), -1);
+        }
+    };
+
+    State state;
+    GLState::Statistics statistics;
+
+    template <size_t N>
+    int findSlot(const GLenum (&values)[N], GLenum value)
+    {
+        const auto it = std::find(std::begin(values), std::end(values), value);
+        return it != std::end(values) ? int(it - std::begin(values)) : -1;
+    }
+
+    // Counts the call and tells, if it has to be issued (value is not shadowed or differs)
+    template <typename T>
+    bool update(GLState::Call call, T* shadowed, T value)
+    {
+        if (shadowed != nullptr && *shadowed == value)
+        {
+            statistics.skipped[call]++;
+            return false;
+        }
+
+        if (shadowed != nullptr) {
+            *shadowed = value;
+        }
+        statistics.issued[call]++;
+        return true;
+    }
+
+    // Forgets every binding of the name in the array
+    void forget(GLuint* bindings, size_t count, GLuint name)
+    {
+        std::replace(bindings, bindings + count, name, UNKNOWN);
+    }
+
+} // namespace
+
+size_t GLState::Statistics::getTotalIssued() const
+{
+    size_t total = 0;
+    for (const auto count : issued) {
+        total += count;
+    }
+    return total;
+}
+
+size_t GLState::Statistics::getTotalSkipped() const
+{
+    size_t total = 0;
+    for (const auto count : skipped) {
+        total += count;
+    }
+    return total;
+}
+
+bool GLState::Statistics::operator==(const Statistics& other) const
+{
+    return std::equal(std::begin(issued), std::end(issued), std::begin(other.issued))
+        && std::equal(std::begin(skipped), std::end(skipped), std::begin(other.skipped));
+}
+
+bool GLState::Statistics::operator!=(const Statistics& other) const
+{
+    return !(*this == other);
+}
+
+bool GLState::useProgram(GLuint program)
+{
+    if (!update(USE_PROGRAM, &state.program, program)) {
+        return false;
+    }
+
+    glUseProgram(program);
+    return true;
+}
+
+bool GLState::bindVertexArray(GLuint vao)
+{
+    if (!update(BIND_VERTEX_ARRAY, &state.vao, vao)) {
+        return false;
+    }
+
+    glBindVertexArray(vao);
+    // Element array buffer binding is part of the VAO
+    state.buffers[findSlot(BUFFER_TARGETS, GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    return true;
+}
+
+bool GLState::activeTexture(GLuint unit)
+{
+    if (!update(ACTIVE_TEXTURE, &state.activeUnit, unit)) {
+        return false;
+    }
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+    return true;
+}
+
+bool GLState::bindTexture(GLenum target, GLuint texture)
+{
+    const auto targetSlot = findSlot(TEXTURE_TARGETS, target);
+    const auto isTracked = targetSlot != -1 && state.activeUnit < GLuint(MAX_TEXTURE_UNITS);
+    if (!update(BIND_TEXTURE, isTracked ? &state.textures[state.activeUnit][targetSlot] : nullptr, texture)) {
+        return false;
+    }
+
+    glBindTexture(target, texture);
+    return true;
+}
+
+bool GLState::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    const auto targetSlot = findSlot(TEXTURE_TARGETS, target);
+    if (targetSlot != -1 && unit < GLuint(MAX_TEXTURE_UNITS) && state.textures[unit][targetSlot] == texture)
+    {
+        statistics.skipped[BIND_TEXTURE]++;
+        return false;
+    }
+
+    activeTexture(unit);
+    return bindTexture(target, texture);
+}
+
+bool GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+    const auto targetSlot = findSlot(BUFFER_TARGETS, target);
+    if (!update(BIND_BUFFER, targetSlot != -1 ? &state.buffers[targetSlot] : nullptr, buffer)) {
+        return false;
+    }
+
+    glBindBuffer(target, buffer);
+    return true;
+}
+
+bool GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    const auto isTracked = target == GL_UNIFORM_BUFFER && index < GLuint(MAX_INDEXED_BUFFERS);
+    if (!update(BIND_BUFFER_BASE, isTracked ? &state.uniformBuffers[index] : nullptr, buffer)) {
+        return false;
+    }
+
+    glBindBufferBase(target, index, buffer);
+    const auto targetSlot = findSlot(BUFFER_TARGETS, target);
+    if (targetSlot != -1) {
+        state.buffers[targetSlot] = buffer;
+    }
+    return true;
+}
+
+bool GLState::enable(GLenum capability)
+{
+    return setEnabled(capability, true);
+}
+
+bool GLState::disable(GLenum capability)
+{
+    return setEnabled(capability, false);
+}
+
+bool GLState::setEnabled(GLenum capability, bool isEnabled)
+{
+    const auto slot = findSlot(CAPABILITIES, capability);
+    if (!update(ENABLE_DISABLE, slot != -1 ? &state.capabilities[slot] : nullptr, int(isEnabled))) {
+        return false;
+    }
+
+    if (isEnabled) {
+        glEnable(capability);
+    }
+    else {
+        glDisable(capability);
+    }
+    return true;
+}
+
+bool GLState::primitiveRestartIndex(GLuint index)
+{
+    if (!update(PRIMITIVE_RESTART_INDEX, &state.primitiveRestartIndex, index)) {
+        return false;
+    }
+
+    glPrimitiveRestartIndex(index);
+    return true;
+}
+
+void GLState::deleteTextures(GLsizei count, const GLuint* textures)
+{
+    glDeleteTextures(count, textures);
+    for (GLsizei i = 0; i < count; i++) {
+        forget(&state.textures[0][0], MAX_TEXTURE_UNITS * NUM_TEXTURE_TARGETS, textures[i]);
+    }
+}
+
+void GLState::deleteBuffers(GLsizei count, const GLuint* buffers)
+{
+    glDeleteBuffers(count, buffers);
+    for (GLsizei i = 0; i < count; i++)
+    {
+        forget(state.buffers, NUM_BUFFER_TARGETS, buffers[i]);
+        forget(state.uniformBuffers, MAX_INDEXED_BUFFERS, buffers[i]);
+    }
+}
+
+void GLState::deleteVertexArrays(GLsizei count, const GLuint* vaos)
+{
+    glDeleteVertexArrays(count, vaos);
+    for (GLsizei i = 0; i < count; i++)
+    {
+        if (state.vao == vaos[i])
+        {
+            state.vao = UNKNOWN;
+            state.buffers[findSlot(BUFFER_TARGETS, GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+        }
+    }
+}
+
+void GLState::deleteProgram(GLuint program)
+{
+    glDeleteProgram(program);
+    if (state.program == program) {
+        state.program = UNKNOWN;
+    }
+}
+
+void GLState::invalidate()
+{
+    state = State();
+}
+
+const GLState::Statistics& GLState::getStatistics()
+{
+    return statistics;
+}
+
+void GLState::resetStatistics()
+{
+    statistics = Statistics();
+}
+
+void GLState::printStatistics()
+{
+    std::cout << "OpenGL state calls: " << statistics.getTotalIssued() << " issued, " << statistics.getTotalSkipped() << " skipped" << std::endl;
+    for (int call = 0; call < NUM_CALLS; call++)
+    {
+        if (statistics.issued[call] > 0 || statistics.skipped[call] > 0) {
+            std::cout << "  " << CALL_NAMES[call] << ": " << statistics.issued[call] << " issued, " << statistics.skipped[call] << " skipped" << std::endl;
+        }
+    }
+}
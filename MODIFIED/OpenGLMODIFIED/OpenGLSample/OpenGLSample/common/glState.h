@@ -0,0 +1,135 @@
+#pragma once
+
+// STL
+#include <cstddef>
+
+// GLAD
+#include <glad/glad.h>
+
+/**
+ * Shadow copy of the OpenGL binding state (program, VAO, textures per unit, buffers and enabled capabilities)
+ * of the current context. Calls, that would set what's already set, are skipped and counted. All code must bind
+ * through GLState (and delete through it, so that recycled object names are not mistaken for bound ones),
+ * code calling OpenGL directly has to call invalidate() afterwards. State not known yet is always set.
+ */
+class GLState
+{
+public:
+    /**
+     * Kinds of filtered calls, used to index Statistics.
+     */
+    enum Call
+    {
+        USE_PROGRAM,
+        BIND_VERTEX_ARRAY,
+        ACTIVE_TEXTURE,
+        BIND_TEXTURE,
+        BIND_BUFFER,
+        BIND_BUFFER_BASE,
+        ENABLE_DISABLE,
+        PRIMITIVE_RESTART_INDEX,
+        NUM_CALLS
+    };
+
+    static const int MAX_TEXTURE_UNITS = 16; // Texture units tracked, binds to other units are always issued
+    static const int MAX_INDEXED_BUFFERS = 16; // Uniform buffer binding points tracked
+
+    /**
+     * Numbers of issued and skipped calls of every kind.
+     */
+    struct Statistics
+    {
+        size_t issued[NUM_CALLS] = {}; // Calls passed to OpenGL
+        size_t skipped[NUM_CALLS] = {}; // Calls filtered out, because they would change nothing
+
+        size_t getTotalIssued() const;
+        size_t getTotalSkipped() const;
+
+        bool operator==(const Statistics& other) const;
+        bool operator!=(const Statistics& other) const;
+    };
+
+    /**
+     * Calls glUseProgram, unless the program is in use already. Functions return true, if the call was issued.
+     */
+    static bool useProgram(GLuint program);
+
+    /**
+     * Calls glBindVertexArray, unless the VAO is bound already. Changes the element array buffer binding.
+     */
+    static bool bindVertexArray(GLuint vao);
+
+    /**
+     * Makes texture unit with given index (not GL_TEXTURE0 + index) active.
+     */
+    static bool activeTexture(GLuint unit);
+
+    /**
+     * Binds texture to the active texture unit.
+     */
+    static bool bindTexture(GLenum target, GLuint texture);
+
+    /**
+     * Binds texture to given texture unit, the unit is made active only if the binding changes.
+     */
+    static bool bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    /**
+     * Binds buffer to a generic binding point (element array buffer belongs to the bound VAO).
+     */
+    static bool bindBuffer(GLenum target, GLuint buffer);
+
+    /**
+     * Binds buffer to an indexed binding point (and to the generic one, same as OpenGL does).
+     */
+    static bool bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    static bool enable(GLenum capability);
+    static bool disable(GLenum capability);
+    static bool setEnabled(GLenum capability, bool isEnabled);
+
+    /**
+     * Sets primitive restart index.
+     */
+    static bool primitiveRestartIndex(GLuint index);
+
+    /**
+     * Deletes textures and forgets their bindings.
+     */
+    static void deleteTextures(GLsizei count, const GLuint* textures);
+
+    /**
+     * Deletes buffers and forgets their bindings.
+     */
+    static void deleteBuffers(GLsizei count, const GLuint* buffers);
+
+    /**
+     * Deletes VAOs and forgets their binding.
+     */
+    static void deleteVertexArrays(GLsizei count, const GLuint* vaos);
+
+    /**
+     * Deletes program and forgets its binding.
+     */
+    static void deleteProgram(GLuint program);
+
+    /**
+     * Forgets all shadowed state, next call of every kind is issued. Needed after OpenGL was called directly.
+     */
+    static void invalidate();
+
+    /**
+     * Gets counters of issued and skipped calls since the last resetStatistics().
+     */
+    static const Statistics& getStatistics();
+
+    /**
+     * Zeroes counters of issued and skipped calls (e.g. at the start of every frame).
+     */
+    static void resetStatistics();
+
+    /**
+     * Prints counters of issued and skipped calls.
+     */
+    static void printStatistics();
+};
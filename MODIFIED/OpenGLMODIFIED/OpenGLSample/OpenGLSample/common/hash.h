@@ -0,0 +1,31 @@
+#pragma once
+
+// STL
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Initial value of the 64-bit FNV-1a hash (hash of no data).
+ */
+const uint64_t HASH_OFFSET_BASIS = 14695981039346656037ULL;
+
+/**
+ * Computes 64-bit FNV-1a hash of the data. Data can be hashed in parts by passing hash of the previous
+ * parts as the initial value, the result is the same as of hashing all of it at once.
+ *
+ * @param data  Data to hash
+ * @param size  Size of the data (in bytes)
+ * @param hash  Initial value (hash of the preceding data)
+ *
+ * @return Hash of the data.
+ */
+inline uint64_t hashData(const void* data, size_t size, uint64_t hash = HASH_OFFSET_BASIS)
+{
+    const auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
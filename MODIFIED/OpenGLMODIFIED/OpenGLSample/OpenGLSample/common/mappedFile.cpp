@@ -0,0 +1,128 @@
+// Platform
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Project
+#include "mappedFile.h"
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const char* path)
+{
+    close();
+
+#ifdef _WIN32
+    const auto fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize))
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    _fileHandle = fileHandle;
+    _size = static_cast<size_t>(fileSize.QuadPart);
+    if (_size > 0)
+    {
+        _mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        _data = _mappingHandle ? static_cast<const char*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (_data == nullptr)
+        {
+            _isOpen = true;
+            close();
+            return false;
+        }
+    }
+#else
+    const auto fileDescriptor = ::open(path, O_RDONLY);
+    if (fileDescriptor == -1) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) != 0)
+    {
+        ::close(fileDescriptor);
+        return false;
+    }
+
+    _fileDescriptor = fileDescriptor;
+    _size = static_cast<size_t>(fileStat.st_size);
+    if (_size > 0)
+    {
+        const auto mapped = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (mapped == MAP_FAILED)
+        {
+            _isOpen = true;
+            close();
+            return false;
+        }
+
+        // Files are almost always read front to back
+        madvise(mapped, _size, MADV_SEQUENTIAL);
+        _data = static_cast<const char*>(mapped);
+    }
+#endif
+
+    _isOpen = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (!_isOpen) {
+        return;
+    }
+
+#ifdef _WIN32
+    if (_data) {
+        UnmapViewOfFile(_data);
+    }
+    if (_mappingHandle) {
+        CloseHandle(_mappingHandle);
+    }
+    CloseHandle(_fileHandle);
+    _mappingHandle = nullptr;
+    _fileHandle = nullptr;
+#else
+    if (_data) {
+        munmap(const_cast<char*>(_data), _size);
+    }
+    ::close(_fileDescriptor);
+    _fileDescriptor = -1;
+#endif
+
+    _data = nullptr;
+    _size = 0;
+    _isOpen = false;
+}
+
+bool MappedFile::isOpen() const
+{
+    return _isOpen;
+}
+
+const char* MappedFile::getData() const
+{
+    return _data;
+}
+
+size_t MappedFile::getSize() const
+{
+    return _size;
+}
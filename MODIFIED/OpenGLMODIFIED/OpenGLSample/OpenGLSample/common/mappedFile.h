@@ -0,0 +1,58 @@
+#pragma once
+
+// STL
+#include <cstddef>
+
+/**
+ * Read-only memory mapping of a whole file (Windows file mapping or POSIX mmap).
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Maps given file into memory (read-only).
+     *
+     * @param path  Path to the file
+     *
+     * @return True, if the file has been mapped successfully (empty file is mapped to nullptr with size 0).
+     */
+    bool open(const char* path);
+
+    /**
+     * Unmaps the file (data pointer becomes invalid).
+     */
+    void close();
+
+    /**
+     * Checks, if a file is mapped.
+     */
+    bool isOpen() const;
+
+    /**
+     * Gets pointer to the mapped file contents.
+     */
+    const char* getData() const;
+
+    /**
+     * Gets size of the mapped file (in bytes).
+     */
+    size_t getSize() const;
+
+private:
+    const char* _data = nullptr; // Pointer to the mapped file contents
+    size_t _size = 0; // Size of the mapped file
+    bool _isOpen = false; // Flag telling, if a file is mapped
+
+#ifdef _WIN32
+    void* _fileHandle = nullptr; // Windows file handle
+    void* _mappingHandle = nullptr; // Windows file mapping handle
+#else
+    int _fileDescriptor = -1; // POSIX file descriptor
+#endif
+};
@@ -0,0 +1,213 @@
+// STL
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "meshFile.h"
+#include "fileUtils.h"
+#include "meshOptimizer.hpp"
+#include "objloader.hpp"
+#include "vboindexer.hpp"
+
+const char MeshFile::MAGIC[4] = { 'M', 'E', 'S', 'H' };
+const uint32_t MeshFile::VERSION = 2;
+
+namespace {
+
+    // Offset rounded up to the multiple of 16 (so that data in the mapped file are well aligned)
+    uint64_t alignOffset(uint64_t offset)
+    {
+        return (offset + 15) & ~uint64_t(15);
+    }
+
+    // Vertex as stored by convertOBJToMeshFile (all attributes, interleaved)
+    struct PackedVertex
+    {
+        glm::vec3 position;
+        glm::vec2 textureCoordinate;
+        glm::vec3 normal;
+    };
+
+    static_assert(sizeof(PackedVertex) == 32, "PackedVertex must be tightly packed");
+
+} // namespace
+
+bool MeshFile::open(const char* path)
+{
+    close();
+    if (!_file.open(path)) {
+        return false;
+    }
+
+    // Header must be complete, before any of its fields is read
+    const auto size = _file.getSize();
+    if (size < sizeof(MeshFileHeader))
+    {
+        _file.close();
+        return false;
+    }
+
+    // Header must describe data, that are really present in the file
+    const auto header = reinterpret_cast<const MeshFileHeader*>(_file.getData());
+    const auto indexByteSize = header->indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(GLuint);
+    const auto isValid = memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+        && header->version == VERSION
+        && (header->indexType == GL_UNSIGNED_SHORT || header->indexType == GL_UNSIGNED_INT)
+        && header->vertexDataSize == uint64_t(header->numVertices) * header->vertexByteSize
+        && header->indexDataSize == uint64_t(header->numIndices) * indexByteSize
+        && header->vertexDataOffset >= sizeof(MeshFileHeader)
+        && header->vertexDataOffset <= size && header->vertexDataSize <= size - header->vertexDataOffset
+        && header->indexDataOffset <= size && header->indexDataSize <= size - header->indexDataOffset;
+
+    if (!isValid)
+    {
+        _file.close();
+        return false;
+    }
+
+    _header = header;
+    return true;
+}
+
+void MeshFile::close()
+{
+    _header = nullptr;
+    _file.close();
+}
+
+const MeshFileHeader& MeshFile::getHeader() const
+{
+    return *_header;
+}
+
+const void* MeshFile::getVertexData() const
+{
+    return _file.getData() + _header->vertexDataOffset;
+}
+
+const void* MeshFile::getIndexData() const
+{
+    return _file.getData() + _header->indexDataOffset;
+}
+
+bool MeshFile::isUpToDate(const char* meshPath, const char* sourcePath)
+{
+    MeshFile meshFile;
+    if (!meshFile.open(meshPath)) {
+        return false;
+    }
+
+    FileInfo recordedInfo;
+    const auto& header = meshFile.getHeader();
+    recordedInfo.hash = header.sourceHash;
+    recordedInfo.modificationTime = header.sourceModificationTime;
+    recordedInfo.size = header.sourceSize;
+    meshFile.close();
+    return isBuiltFromCurrentSource(meshPath, offsetof(MeshFileHeader, sourceModificationTime), recordedInfo, sourcePath);
+}
+
+bool MeshFile::write(const char* path, MeshFileHeader header, const void* vertexData, const void* indexData)
+{
+    const auto indexByteSize = header.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(GLuint);
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.vertexDataOffset = alignOffset(sizeof(MeshFileHeader));
+    header.vertexDataSize = uint64_t(header.numVertices) * header.vertexByteSize;
+    header.indexDataOffset = alignOffset(header.vertexDataOffset + header.vertexDataSize);
+    header.indexDataSize = uint64_t(header.numIndices) * indexByteSize;
+
+    const auto file = fopen(path, "wb");
+    if (file == nullptr)
+    {
+        std::cerr << "Could not open mesh file " << path << " for writing!" << std::endl;
+        return false;
+    }
+
+    // Padding between the parts is written as zeros
+    const char zeros[16] = {};
+    const auto isWritten = fwrite(&header, sizeof(MeshFileHeader), 1, file) == 1
+        && fwrite(zeros, 1, size_t(header.vertexDataOffset - sizeof(MeshFileHeader)), file) == header.vertexDataOffset - sizeof(MeshFileHeader)
+        && fwrite(vertexData, 1, size_t(header.vertexDataSize), file) == header.vertexDataSize
+        && fwrite(zeros, 1, size_t(header.indexDataOffset - header.vertexDataOffset - header.vertexDataSize), file) == header.indexDataOffset - header.vertexDataOffset - header.vertexDataSize
+        && fwrite(indexData, 1, size_t(header.indexDataSize), file) == header.indexDataSize;
+
+    if (fclose(file) != 0 || !isWritten)
+    {
+        std::cerr << "Could not write mesh file " << path << "!" << std::endl;
+        remove(path);
+        return false;
+    }
+
+    return true;
+}
+
+bool convertOBJToMeshFile(const char* objPath, const char* meshPath, unsigned int numThreads)
+{
+    FileInfo sourceInfo;
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    if (!getFileInfo(objPath, true, sourceInfo) || !loadOBJ(objPath, vertices, uvs, normals, numThreads)) {
+        return false;
+    }
+
+    // Merge identical vertices of the triangle soup and interleave them
+    std::vector<GLuint> indices;
+    std::vector<glm::vec3> indexedVertices, indexedNormals;
+    std::vector<glm::vec2> indexedUVs;
+    if (!indexVBO(vertices, uvs, normals, indices, indexedVertices, indexedUVs, indexedNormals)) {
+        return false;
+    }
+
+    // Reorder triangles for the vertex cache and overdraw, then vertices in the order triangles use them
+    const auto statisticsBefore = analyzeVertexCache(indices, indexedVertices.size());
+    optimizeOverdraw(indices, indexedVertices);
+    optimizeVertexFetch(indices, indexedVertices, indexedUVs, indexedNormals);
+    const auto statisticsAfter = analyzeVertexCache(indices, indexedVertices.size());
+    std::cout << "Optimized " << objPath << " for vertex cache, ACMR " << statisticsBefore.acmr << " -> " << statisticsAfter.acmr
+        << ", ATVR " << statisticsBefore.atvr << " -> " << statisticsAfter.atvr << std::endl;
+
+    std::vector<PackedVertex> packedVertices(indexedVertices.size());
+    for (size_t i = 0; i < packedVertices.size(); i++) {
+        packedVertices[i] = PackedVertex{ indexedVertices[i], indexedUVs[i], indexedNormals[i] };
+    }
+
+    MeshFileHeader header = {};
+    header.sourceHash = sourceInfo.hash;
+    header.sourceModificationTime = sourceInfo.modificationTime;
+    header.sourceSize = sourceInfo.size;
+    header.numVertices = static_cast<uint32_t>(packedVertices.size());
+    header.numIndices = static_cast<uint32_t>(indices.size());
+    header.attributeMask = MeshFileHeader::POSITIONS | MeshFileHeader::TEXTURE_COORDINATES | MeshFileHeader::NORMALS;
+    header.vertexByteSize = sizeof(PackedVertex);
+    header.positionOffset = offsetof(PackedVertex, position);
+    header.textureCoordinateOffset = offsetof(PackedVertex, textureCoordinate);
+    header.normalOffset = offsetof(PackedVertex, normal);
+
+    glm::vec3 boundingBoxMin(0.0f), boundingBoxMax(0.0f);
+    for (size_t i = 0; i < packedVertices.size(); i++)
+    {
+        boundingBoxMin = i == 0 ? packedVertices[i].position : glm::min(boundingBoxMin, packedVertices[i].position);
+        boundingBoxMax = i == 0 ? packedVertices[i].position : glm::max(boundingBoxMax, packedVertices[i].position);
+    }
+    memcpy(header.boundingBoxMin, &boundingBoxMin, sizeof(header.boundingBoxMin));
+    memcpy(header.boundingBoxMax, &boundingBoxMax, sizeof(header.boundingBoxMax));
+
+    // 16-bit indices are enough, if all vertices and the primitive restart index fit into them
+    if (header.numVertices < 0xFFFF)
+    {
+        std::vector<unsigned short> shortIndices;
+        shortenIndices(indices, shortIndices);
+        header.indexType = GL_UNSIGNED_SHORT;
+        return MeshFile::write(meshPath, header, packedVertices.data(), shortIndices.data());
+    }
+
+    header.indexType = GL_UNSIGNED_INT;
+    return MeshFile::write(meshPath, header, packedVertices.data(), indices.data());
+}
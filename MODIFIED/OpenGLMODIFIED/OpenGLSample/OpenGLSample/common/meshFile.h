@@ -0,0 +1,125 @@
+#pragma once
+
+// STL
+#include <cstdint>
+
+// GLAD
+#include <glad/glad.h>
+
+// Project
+#include "mappedFile.h"
+
+/**
+ * Header of the binary mesh file. File consists of this header, interleaved vertex data
+ * (position, texture coordinate, normal - only attributes present in attributeMask)
+ * and index data (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT), all of it stored exactly as it
+ * is uploaded to the GPU.
+ */
+struct MeshFileHeader
+{
+    static const uint32_t POSITIONS = 1; // Attribute mask bit of vertex positions
+    static const uint32_t TEXTURE_COORDINATES = 2; // Attribute mask bit of texture coordinates
+    static const uint32_t NORMALS = 4; // Attribute mask bit of vertex normals
+
+    char magic[4]; // Always MeshFile::MAGIC
+    uint32_t version; // Version of the format, files with other version than MeshFile::VERSION are rebuilt
+    uint64_t sourceHash; // Hash of the contents of the source file, the mesh was converted from
+    int64_t sourceModificationTime; // Modification time of the source file (seconds since epoch)
+    uint64_t sourceSize; // Size of the source file (in bytes)
+
+    uint32_t numVertices; // Number of vertices in the vertex data
+    uint32_t numIndices; // Number of indices in the index data (3 per triangle)
+    uint32_t indexType; // Type of the indices (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+    uint32_t attributeMask; // Combination of POSITIONS, TEXTURE_COORDINATES and NORMALS
+    uint32_t vertexByteSize; // Byte size of one vertex (all its attributes)
+    uint32_t positionOffset; // Byte offset of position within vertex
+    uint32_t textureCoordinateOffset; // Byte offset of texture coordinate within vertex
+    uint32_t normalOffset; // Byte offset of normal within vertex
+    float boundingBoxMin[3]; // Minimal corner of the axis aligned bounding box of the mesh
+    float boundingBoxMax[3]; // Maximal corner of the axis aligned bounding box of the mesh
+    uint32_t reserved[2]; // Unused, keeps data offsets 8-byte aligned
+
+    uint64_t vertexDataOffset; // Byte offset of the vertex data from the start of the file
+    uint64_t vertexDataSize; // Byte size of the vertex data
+    uint64_t indexDataOffset; // Byte offset of the index data from the start of the file
+    uint64_t indexDataSize; // Byte size of the index data
+};
+
+static_assert(sizeof(MeshFileHeader) == 128, "MeshFileHeader must not contain implicit padding");
+
+/**
+ * Binary mesh file loaded by memory mapping. Vertex and index data point directly to the mapped
+ * file and can be handed to OpenGL as they are, no per-vertex work is done when loading.
+ */
+class MeshFile
+{
+public:
+    static const char MAGIC[4]; // Magic number at the start of every mesh file ("MESH")
+    static const uint32_t VERSION; // Current version of the format
+
+    /**
+     * Maps given mesh file and validates its header.
+     *
+     * @param path  Path to the mesh file
+     *
+     * @return True, if the file is a valid mesh file of the current version.
+     */
+    bool open(const char* path);
+
+    /**
+     * Unmaps the mesh file (all data pointers become invalid).
+     */
+    void close();
+
+    /**
+     * Gets header of the opened mesh file.
+     */
+    const MeshFileHeader& getHeader() const;
+
+    /**
+     * Gets pointer to the vertex data.
+     */
+    const void* getVertexData() const;
+
+    /**
+     * Gets pointer to the index data.
+     */
+    const void* getIndexData() const;
+
+    /**
+     * Checks, if mesh file at given path was converted from the current version of the source file
+     * (see isBuiltFromCurrentSource).
+     *
+     * @param meshPath    Path to the mesh file
+     * @param sourcePath  Path to the source file
+     */
+    static bool isUpToDate(const char* meshPath, const char* sourcePath);
+
+    /**
+     * Writes mesh file. Offsets and sizes of the data in the header are filled in automatically.
+     *
+     * @param path        Path to the written mesh file
+     * @param header      Header of the mesh (description of the data and the source file)
+     * @param vertexData  Vertex data (numVertices * vertexByteSize bytes)
+     * @param indexData   Index data (numIndices indices of indexType)
+     *
+     * @return True, if the file has been written successfully.
+     */
+    static bool write(const char* path, MeshFileHeader header, const void* vertexData, const void* indexData);
+
+private:
+    MappedFile _file; // Mapped mesh file
+    const MeshFileHeader* _header = nullptr; // Header of the mapped mesh file (nullptr if none is opened)
+};
+
+/**
+ * Converts OBJ file to the binary mesh file (offline step). Identical vertices are merged
+ * and indexed, vertices contain positions, texture coordinates and normals.
+ *
+ * @param objPath     Path to the OBJ file
+ * @param meshPath    Path to the written mesh file
+ * @param numThreads  Number of threads used for parsing the OBJ file (see loadOBJ)
+ *
+ * @return True, if the conversion succeeded.
+ */
+bool convertOBJToMeshFile(const char* objPath, const char* meshPath, unsigned int numThreads = 1);
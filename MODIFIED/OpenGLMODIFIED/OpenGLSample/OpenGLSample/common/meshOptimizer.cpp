@@ -0,0 +1,284 @@
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+
+#include <glm/glm.hpp>
+
+#include "meshOptimizer.hpp"
+
+namespace {
+
+const unsigned int NO_VERTEX = 0xFFFFFFFF;
+
+// Triangles using each vertex, stored as one array with offsets per vertex
+struct VertexTriangles
+{
+	std::vector<unsigned int> offsets; // Triangles of vertex v are triangles[offsets[v]] .. triangles[offsets[v + 1] - 1]
+	std::vector<unsigned int> triangles;
+
+	VertexTriangles(const std::vector<unsigned int> & indices, size_t numVertices)
+		: offsets(numVertices + 1, 0)
+		, triangles(indices.size())
+	{
+		for (size_t i = 0; i < indices.size(); i++)
+			offsets[indices[i] + 1]++;
+		for (size_t v = 0; v < numVertices; v++)
+			offsets[v + 1] += offsets[v];
+
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+			triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+	}
+};
+
+// Tipsify by Sander, Nehab and Barczak: fans around vertices, choosing the next fanning vertex among vertices
+// of the emitted triangles that will still be in the cache. Returns the new triangle list, hard cluster boundaries
+// (first triangle of every cluster, new cluster starts whenever a dead-end had to be skipped) go to out_clusters.
+std::vector<unsigned int> tipsify(
+	const std::vector<unsigned int> & indices,
+	size_t numVertices,
+	unsigned int cacheSize,
+	std::vector<unsigned int> & out_clusters
+){
+	const size_t numTriangles = indices.size() / 3;
+	const VertexTriangles vertexTriangles(indices, numVertices);
+
+	std::vector<unsigned int> liveTriangles(numVertices);
+	for (size_t v = 0; v < numVertices; v++)
+		liveTriangles[v] = vertexTriangles.offsets[v + 1] - vertexTriangles.offsets[v];
+
+	std::vector<unsigned int> cacheTimestamps(numVertices, 0);
+	std::vector<bool> isEmitted(numTriangles, false);
+	std::vector<unsigned int> deadEnds;
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> result;
+	result.reserve(numTriangles * 3);
+	out_clusters.clear();
+
+	unsigned int timestamp = cacheSize + 1;
+	size_t cursor = 0; // Next vertex to try, when there are no dead-ends to resume from
+	unsigned int fanningVertex = NO_VERTEX;
+	for (;;) {
+		if (fanningVertex == NO_VERTEX) {
+			// Dead-end, resume from a recently used vertex with live triangles, or from any such vertex
+			while (!deadEnds.empty() && fanningVertex == NO_VERTEX) {
+				if (liveTriangles[deadEnds.back()] > 0)
+					fanningVertex = deadEnds.back();
+				deadEnds.pop_back();
+			}
+			while (fanningVertex == NO_VERTEX && cursor < numVertices) {
+				if (liveTriangles[cursor] > 0)
+					fanningVertex = static_cast<unsigned int>(cursor);
+				cursor++;
+			}
+			if (fanningVertex == NO_VERTEX)
+				break;
+			out_clusters.push_back(static_cast<unsigned int>(result.size() / 3));
+		}
+
+		// Emit all remaining triangles around the fanning vertex
+		candidates.clear();
+		for (unsigned int i = vertexTriangles.offsets[fanningVertex]; i < vertexTriangles.offsets[fanningVertex + 1]; i++) {
+			const unsigned int triangle = vertexTriangles.triangles[i];
+			if (isEmitted[triangle])
+				continue;
+
+			for (int c = 0; c < 3; c++) {
+				const unsigned int v = indices[triangle * 3 + c];
+				result.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				liveTriangles[v]--;
+				if (timestamp - cacheTimestamps[v] > cacheSize)
+					cacheTimestamps[v] = timestamp++;
+			}
+			isEmitted[triangle] = true;
+		}
+
+		// Next fanning vertex is the oldest candidate, that will still be in the cache after its fan is emitted
+		unsigned int bestVertex = NO_VERTEX;
+		int bestPriority = -1;
+		for (size_t i = 0; i < candidates.size(); i++) {
+			const unsigned int v = candidates[i];
+			if (liveTriangles[v] == 0)
+				continue;
+
+			int priority = 0;
+			if (timestamp - cacheTimestamps[v] + 2 * liveTriangles[v] <= cacheSize)
+				priority = static_cast<int>(timestamp - cacheTimestamps[v]);
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				bestVertex = v;
+			}
+		}
+		fanningVertex = bestVertex;
+	}
+
+	return result;
+}
+
+// Number of cache misses of the triangles [firstTriangle, lastTriangle) starting with empty cache
+unsigned int countCacheMisses(
+	const std::vector<unsigned int> & indices,
+	size_t firstTriangle, size_t lastTriangle,
+	unsigned int cacheSize,
+	std::vector<unsigned int> & cacheTimestamps,
+	unsigned int & timestamp
+){
+	// Cache is emptied by moving the time far enough
+	timestamp += cacheSize + 1;
+	unsigned int misses = 0;
+	for (size_t i = firstTriangle * 3; i < lastTriangle * 3; i++) {
+		const unsigned int v = indices[i];
+		if (timestamp - cacheTimestamps[v] > cacheSize) {
+			cacheTimestamps[v] = timestamp++;
+			misses++;
+		}
+	}
+	return misses;
+}
+
+} // namespace
+
+VertexCacheStatistics analyzeVertexCache(
+	const std::vector<unsigned int> & indices,
+	size_t numVertices,
+	unsigned int cacheSize
+){
+	std::vector<unsigned int> cacheTimestamps(numVertices, 0);
+	unsigned int timestamp = 0;
+	const size_t numTriangles = indices.size() / 3;
+
+	VertexCacheStatistics statistics;
+	statistics.vertexShaderInvocations = countCacheMisses(indices, 0, numTriangles, cacheSize, cacheTimestamps, timestamp);
+	statistics.acmr = numTriangles > 0 ? float(statistics.vertexShaderInvocations) / numTriangles : 0.0f;
+	statistics.atvr = numVertices > 0 ? float(statistics.vertexShaderInvocations) / numVertices : 0.0f;
+	return statistics;
+}
+
+void optimizeVertexCache(
+	std::vector<unsigned int> & indices,
+	size_t numVertices,
+	unsigned int cacheSize
+){
+	std::vector<unsigned int> clusters;
+	indices = tipsify(indices, numVertices, cacheSize, clusters);
+}
+
+void optimizeOverdraw(
+	std::vector<unsigned int> & indices,
+	const std::vector<glm::vec3> & vertices,
+	unsigned int cacheSize,
+	float threshold
+){
+	const size_t numTriangles = indices.size() / 3;
+	std::vector<unsigned int> hardClusters;
+	const std::vector<unsigned int> optimized = tipsify(indices, vertices.size(), cacheSize, hardClusters);
+	hardClusters.push_back(static_cast<unsigned int>(numTriangles));
+
+	// Split hard clusters, wherever the part so far is about as cache efficient as the whole cluster
+	std::vector<unsigned int> cacheTimestamps(vertices.size(), 0);
+	unsigned int timestamp = 0;
+	std::vector<unsigned int> clusters;
+	for (size_t c = 0; c + 1 < hardClusters.size(); c++) {
+		const size_t first = hardClusters[c], last = hardClusters[c + 1];
+		const float clusterACMR = float(countCacheMisses(optimized, first, last, cacheSize, cacheTimestamps, timestamp)) / (last - first);
+
+		clusters.push_back(static_cast<unsigned int>(first));
+		size_t start = first;
+		unsigned int misses = 0;
+		timestamp += cacheSize + 1;
+		for (size_t t = first; t < last; t++) {
+			for (int i = 0; i < 3; i++) {
+				const unsigned int v = optimized[t * 3 + i];
+				if (timestamp - cacheTimestamps[v] > cacheSize) {
+					cacheTimestamps[v] = timestamp++;
+					misses++;
+				}
+			}
+			if (t + 1 < last && float(misses) / (t + 1 - start) <= threshold * clusterACMR) {
+				clusters.push_back(static_cast<unsigned int>(t + 1));
+				start = t + 1;
+				misses = 0;
+				timestamp += cacheSize + 1;
+			}
+		}
+	}
+	clusters.push_back(static_cast<unsigned int>(numTriangles));
+
+	// Area weighted centroid and normal of every cluster
+	const size_t numClusters = clusters.size() - 1;
+	std::vector<glm::vec3> clusterCentroids(numClusters), clusterNormals(numClusters);
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < numClusters; c++) {
+		glm::vec3 centroid(0.0f), normal(0.0f);
+		float area = 0.0f;
+		for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+			const glm::vec3 & v0 = vertices[optimized[t * 3 + 0]];
+			const glm::vec3 & v1 = vertices[optimized[t * 3 + 1]];
+			const glm::vec3 & v2 = vertices[optimized[t * 3 + 2]];
+			const glm::vec3 faceNormal = glm::cross(v1 - v0, v2 - v0); // Length is twice the area
+			const float faceArea = glm::length(faceNormal);
+			centroid += (v0 + v1 + v2) * (faceArea / 3.0f);
+			normal += faceNormal;
+			area += faceArea;
+		}
+
+		meshCentroid += centroid;
+		meshArea += area;
+		clusterCentroids[c] = area > 0.0f ? centroid / area : vertices[optimized[clusters[c] * 3]];
+		const float normalLength = glm::length(normal);
+		clusterNormals[c] = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f);
+	}
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	// Clusters facing away from the center of the mesh (likely in front of others) are drawn first
+	std::vector<float> sortKeys(numClusters);
+	std::vector<unsigned int> clusterOrder(numClusters);
+	for (size_t c = 0; c < numClusters; c++) {
+		sortKeys[c] = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c]);
+		clusterOrder[c] = static_cast<unsigned int>(c);
+	}
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](unsigned int a, unsigned int b) {
+		return sortKeys[a] > sortKeys[b];
+	});
+
+	indices.clear();
+	for (size_t i = 0; i < numClusters; i++) {
+		const unsigned int c = clusterOrder[i];
+		indices.insert(indices.end(), optimized.begin() + clusters[c] * 3, optimized.begin() + clusters[c + 1] * 3);
+	}
+}
+
+void optimizeVertexFetch(
+	std::vector<unsigned int> & indices,
+	std::vector<glm::vec3> & vertices,
+	std::vector<glm::vec2> & uvs,
+	std::vector<glm::vec3> & normals
+){
+	// New index of every vertex is the order of its first use
+	std::vector<unsigned int> remap(vertices.size(), NO_VERTEX);
+	unsigned int numUsed = 0;
+	for (size_t i = 0; i < indices.size(); i++) {
+		unsigned int & newIndex = remap[indices[i]];
+		if (newIndex == NO_VERTEX)
+			newIndex = numUsed++;
+		indices[i] = newIndex;
+	}
+
+	std::vector<glm::vec3> newVertices(numUsed), newNormals(numUsed);
+	std::vector<glm::vec2> newUVs(numUsed);
+	for (size_t v = 0; v < remap.size(); v++) {
+		if (remap[v] == NO_VERTEX)
+			continue;
+		newVertices[remap[v]] = vertices[v];
+		newUVs[remap[v]] = uvs[v];
+		newNormals[remap[v]] = normals[v];
+	}
+
+	vertices.swap(newVertices);
+	uvs.swap(newUVs);
+	normals.swap(newNormals);
+}
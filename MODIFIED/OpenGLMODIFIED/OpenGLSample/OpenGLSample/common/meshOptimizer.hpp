@@ -0,0 +1,49 @@
+#ifndef MESHOPTIMIZER_HPP
+#define MESHOPTIMIZER_HPP
+
+// Default number of entries of the simulated post-transform vertex cache (FIFO)
+const unsigned int VERTEX_CACHE_SIZE = 16;
+
+// Efficiency of the post-transform vertex cache for given triangle list
+struct VertexCacheStatistics
+{
+	unsigned int vertexShaderInvocations; // Number of cache misses (vertices transformed)
+	float acmr; // Average cache miss ratio, transformed vertices per triangle (0.5 is ideal, 3 is the worst)
+	float atvr; // Average transformed vertex ratio, transformed vertices per vertex (1 is ideal)
+};
+
+// Simulates FIFO vertex cache of given size over the triangle list
+VertexCacheStatistics analyzeVertexCache(
+	const std::vector<unsigned int> & indices,
+	size_t numVertices,
+	unsigned int cacheSize = VERTEX_CACHE_SIZE
+);
+
+// Reorders triangles for the post-transform vertex cache (Tipsify, linear time)
+void optimizeVertexCache(
+	std::vector<unsigned int> & indices,
+	size_t numVertices,
+	unsigned int cacheSize = VERTEX_CACHE_SIZE
+);
+
+// Reorders triangles for the vertex cache and then reorders clusters of those triangles, so that outer
+// parts of the mesh come first and hide parts behind them (linear-speed overdraw reduction by Sander et al.).
+// Clusters are split further while their ACMR stays within threshold times the ACMR of the whole cluster,
+// so higher threshold means less overdraw for the price of more vertex shading (1.05 is a good default).
+void optimizeOverdraw(
+	std::vector<unsigned int> & indices,
+	const std::vector<glm::vec3> & vertices,
+	unsigned int cacheSize = VERTEX_CACHE_SIZE,
+	float threshold = 1.05f
+);
+
+// Reorders vertices in the order they are first used by the triangle list (and updates indices), so that
+// vertex fetch reads memory sequentially. Vertices not used by any triangle are removed.
+void optimizeVertexFetch(
+	std::vector<unsigned int> & indices,
+	std::vector<glm::vec3> & vertices,
+	std::vector<glm::vec2> & uvs,
+	std::vector<glm::vec3> & normals
+);
+
+#endif
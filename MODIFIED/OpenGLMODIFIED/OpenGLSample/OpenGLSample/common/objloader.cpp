@@ -1,11 +1,20 @@
 #include <vector>
+#include <cstddef>
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <string>
 #include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <thread>
 
 #include <glm/glm.hpp>
 
+#include "mappedFile.h"
 #include "objloader.hpp"
+#include "parallel.hpp"
 
 // Very, VERY simple OBJ loader.
 // Here is a short list of features a real function would provide : 
@@ -17,99 +26,540 @@
 // - More secure. Change another line and you can inject code.
 // - Loading from memory, stream, etc
 
-bool loadOBJ(
-	const char * path, 
-	std::vector<glm::vec3> & out_vertices, 
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals
-){
-	printf("Loading OBJ file %s...\n", path);
+namespace {
 
-	std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
-	std::vector<glm::vec3> temp_vertices; 
-	std::vector<glm::vec2> temp_uvs;
-	std::vector<glm::vec3> temp_normals;
+// Index of a face corner attribute, that is not present in the file (e.g. "1//3" has no UV)
+const int MISSING_INDEX = std::numeric_limits<int>::min();
 
+// Indices of one triangle corner. Positive OBJ indices are stored as absolute 0-based indices, negative (relative)
+// OBJ indices are stored relative to the start of the chunk they were parsed in and flagged in the relative mask,
+// so that chunks can be parsed independently and resolved once the number of elements before them is known.
+struct ObjCorner
+{
+	int vertex;
+	int uv;
+	int normal;
+	unsigned char relativeMask;
+};
 
-	FILE * file = fopen(path, "r");
-	if( file == NULL ){
-		printf("Impossible to open the file ! Are you in the right path ? See Tutorial 1 for details\n");
-		getchar();
-		return false;
+const unsigned char RELATIVE_VERTEX = 1;
+const unsigned char RELATIVE_UV = 2;
+const unsigned char RELATIVE_NORMAL = 4;
+
+// Everything parsed from one contiguous range of lines of an OBJ file
+struct ObjChunk
+{
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::vector<ObjCorner> corners; // 3 corners per triangle, faces are already triangulated
+	size_t numLines = 0;
+	size_t errorLine = 0; // 1-based line (within chunk) of the first error, 0 if there's no error
+};
+
+const double POWERS_OF_TEN[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline bool isDigit(char c)
+{
+	return static_cast<unsigned char>(c - '0') < 10;
+}
+
+inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* p, const char* end)
+{
+	while (p < end && isBlank(*p))
+		p++;
+	return p;
+}
+
+// Rare number formats (inf, nan, more than 19 significant digits...) are left to strtod
+const char* parseFloatSlow(const char* p, const char* end, float& value)
+{
+	char buffer[64];
+	size_t length = 0;
+	while (p + length < end && length < sizeof(buffer) - 1 && !isBlank(p[length]) && p[length] != '\n' && p[length] != '/')
+		length++;
+	memcpy(buffer, p, length);
+	buffer[length] = '\0';
+
+	char* parsedEnd = nullptr;
+	value = static_cast<float>(strtod(buffer, &parsedEnd));
+	return parsedEnd == buffer ? nullptr : p + (parsedEnd - buffer);
+}
+
+// Parses decimal floating point number, returns pointer behind it or nullptr if there is no number
+const char* parseFloat(const char* p, const char* end, float& value)
+{
+	p = skipBlanks(p, end);
+	const char* start = p;
+
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	int significantDigits = 0;
+	bool hasDigits = false;
+	while (p < end && isDigit(*p))
+	{
+		if (significantDigits < 19)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			significantDigits += mantissa != 0;
+		}
+		else
+			exponent++;
+		hasDigits = true;
+		p++;
+	}
+	if (p < end && *p == '.')
+	{
+		p++;
+		while (p < end && isDigit(*p))
+		{
+			if (significantDigits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				significantDigits += mantissa != 0;
+				exponent--;
+			}
+			hasDigits = true;
+			p++;
+		}
+	}
+	if (!hasDigits || significantDigits >= 19)
+		return parseFloatSlow(start, end, value);
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char* exponentStart = p++;
+		bool negativeExponent = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negativeExponent = *p == '-';
+			p++;
+		}
+		if (p < end && isDigit(*p))
+		{
+			int explicitExponent = 0;
+			while (p < end && isDigit(*p))
+			{
+				if (explicitExponent < 10000)
+					explicitExponent = explicitExponent * 10 + (*p - '0');
+				p++;
+			}
+			exponent += negativeExponent ? -explicitExponent : explicitExponent;
+		}
+		else
+			p = exponentStart; // just an 'e' after the number, not an exponent
+	}
+
+	double result = static_cast<double>(mantissa);
+	if (exponent < 0 && exponent >= -22)
+		result /= POWERS_OF_TEN[-exponent];
+	else if (exponent > 0 && exponent <= 22)
+		result *= POWERS_OF_TEN[exponent];
+	else if (exponent != 0)
+		result *= pow(10.0, exponent);
+
+	value = static_cast<float>(negative ? -result : result);
+	return p;
+}
+
+// Parses (optionally signed) decimal integer, returns pointer behind it or nullptr if there is no number
+const char* parseInt(const char* p, const char* end, int& value)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+	if (p >= end || !isDigit(*p))
+		return nullptr;
+
+	int64_t result = 0;
+	while (p < end && isDigit(*p))
+	{
+		if (result <= std::numeric_limits<int>::max())
+			result = result * 10 + (*p - '0');
+		p++;
+	}
+	value = static_cast<int>(negative ? -std::min<int64_t>(result, std::numeric_limits<int>::max()) : std::min<int64_t>(result, std::numeric_limits<int>::max()));
+	return p;
+}
+
+// Converts OBJ index (1-based, or negative relative to the number of elements parsed so far) to corner index
+inline bool resolveObjIndex(int objIndex, size_t localCount, unsigned char relativeFlag, int& index, unsigned char& relativeMask)
+{
+	if (objIndex > 0)
+	{
+		index = objIndex - 1;
+		return true;
+	}
+	if (objIndex < 0)
+	{
+		// Stays relative to the chunk start, may even point before it (to previous chunks)
+		index = static_cast<int>(localCount) + objIndex;
+		relativeMask |= relativeFlag;
+		return true;
+	}
+	return false; // index 0 is invalid in OBJ
+}
+
+// Parses one face corner ("v", "v/vt", "v//vn" or "v/vt/vn")
+const char* parseCorner(const char* p, const char* end, const ObjChunk& chunk, ObjCorner& corner)
+{
+	corner.uv = MISSING_INDEX;
+	corner.normal = MISSING_INDEX;
+	corner.relativeMask = 0;
+
+	int objIndex;
+	p = parseInt(p, end, objIndex);
+	if (p == nullptr || !resolveObjIndex(objIndex, chunk.vertices.size(), RELATIVE_VERTEX, corner.vertex, corner.relativeMask))
+		return nullptr;
+
+	if (p < end && *p == '/')
+	{
+		p++;
+		if (p < end && *p != '/')
+		{
+			p = parseInt(p, end, objIndex);
+			if (p == nullptr || !resolveObjIndex(objIndex, chunk.uvs.size(), RELATIVE_UV, corner.uv, corner.relativeMask))
+				return nullptr;
+		}
+		if (p < end && *p == '/')
+		{
+			p++;
+			p = parseInt(p, end, objIndex);
+			if (p == nullptr || !resolveObjIndex(objIndex, chunk.normals.size(), RELATIVE_NORMAL, corner.normal, corner.relativeMask))
+				return nullptr;
+		}
+	}
+	return p;
+}
+
+// Counts elements in the range, so that chunk arrays can be reserved exactly
+void reserveObjChunk(const char* begin, const char* end, ObjChunk& chunk)
+{
+	size_t numVertices = 0, numUVs = 0, numNormals = 0, numTriangles = 0;
+	const char* p = begin;
+	while (p < end)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+		if (lineEnd == nullptr)
+			lineEnd = end;
+
+		p = skipBlanks(p, lineEnd);
+		if (lineEnd - p >= 2)
+		{
+			if (p[0] == 'v')
+			{
+				if (isBlank(p[1]))
+					numVertices++;
+				else if (p[1] == 't')
+					numUVs++;
+				else if (p[1] == 'n')
+					numNormals++;
+			}
+			else if (p[0] == 'f' && isBlank(p[1]))
+			{
+				// Face with N corners turns into N-2 triangles
+				size_t numCorners = 0;
+				for (p = p + 1; p < lineEnd;)
+				{
+					p = skipBlanks(p, lineEnd);
+					if (p < lineEnd)
+						numCorners++;
+					while (p < lineEnd && !isBlank(*p))
+						p++;
+				}
+				if (numCorners > 2)
+					numTriangles += numCorners - 2;
+			}
+		}
+		p = lineEnd + 1;
 	}
 
-	while( 1 ){
+	chunk.vertices.reserve(numVertices);
+	chunk.uvs.reserve(numUVs);
+	chunk.normals.reserve(numNormals);
+	chunk.corners.reserve(numTriangles * 3);
+}
+
+// Parses all lines in the range into the chunk. Stops at the first malformed line (chunk.errorLine is set then).
+void parseObjChunk(const char* begin, const char* end, ObjChunk& chunk)
+{
+	reserveObjChunk(begin, end, chunk);
 
-		char lineHeader[128];
-		// read the first word of the line
-		int res = fscanf(file, "%s", lineHeader);
-		if (res == EOF)
-			break; // EOF = End Of File. Quit the loop.
+	std::vector<ObjCorner> faceCorners;
+	const char* p = begin;
+	while (p < end)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+		if (lineEnd == nullptr)
+			lineEnd = end;
+		chunk.numLines++;
 
-		// else : parse lineHeader
-		
-		if ( strcmp( lineHeader, "v" ) == 0 ){
+		p = skipBlanks(p, lineEnd);
+		bool isValid = true;
+		if (lineEnd - p >= 2 && p[0] == 'v' && isBlank(p[1]))
+		{
 			glm::vec3 vertex;
-			fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z );
-			temp_vertices.push_back(vertex);
-		}else if ( strcmp( lineHeader, "vt" ) == 0 ){
+			isValid = (p = parseFloat(p + 1, lineEnd, vertex.x)) && (p = parseFloat(p, lineEnd, vertex.y)) && (p = parseFloat(p, lineEnd, vertex.z));
+			chunk.vertices.push_back(vertex);
+		}
+		else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && isBlank(p[2]))
+		{
 			glm::vec2 uv;
-			fscanf(file, "%f %f\n", &uv.x, &uv.y );
+			isValid = (p = parseFloat(p + 2, lineEnd, uv.x)) && (p = parseFloat(p, lineEnd, uv.y));
 			uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
-			temp_uvs.push_back(uv);
-		}else if ( strcmp( lineHeader, "vn" ) == 0 ){
+			chunk.uvs.push_back(uv);
+		}
+		else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && isBlank(p[2]))
+		{
 			glm::vec3 normal;
-			fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z );
-			temp_normals.push_back(normal);
-		}else if ( strcmp( lineHeader, "f" ) == 0 ){
-			std::string vertex1, vertex2, vertex3;
-			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-			int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2] );
-			if (matches != 9){
-				printf("File can't be read by our simple parser :-( Try exporting with other options\n");
-				fclose(file);
-				return false;
+			isValid = (p = parseFloat(p + 2, lineEnd, normal.x)) && (p = parseFloat(p, lineEnd, normal.y)) && (p = parseFloat(p, lineEnd, normal.z));
+			chunk.normals.push_back(normal);
+		}
+		else if (lineEnd - p >= 2 && p[0] == 'f' && isBlank(p[1]))
+		{
+			faceCorners.clear();
+			p = skipBlanks(p + 1, lineEnd);
+			while (isValid && p < lineEnd)
+			{
+				ObjCorner corner;
+				p = parseCorner(p, lineEnd, chunk, corner);
+				isValid = p != nullptr && (p == lineEnd || isBlank(*p));
+				if (isValid)
+				{
+					faceCorners.push_back(corner);
+					p = skipBlanks(p, lineEnd);
+				}
 			}
-			vertexIndices.push_back(vertexIndex[0]);
-			vertexIndices.push_back(vertexIndex[1]);
-			vertexIndices.push_back(vertexIndex[2]);
-			uvIndices    .push_back(uvIndex[0]);
-			uvIndices    .push_back(uvIndex[1]);
-			uvIndices    .push_back(uvIndex[2]);
-			normalIndices.push_back(normalIndex[0]);
-			normalIndices.push_back(normalIndex[1]);
-			normalIndices.push_back(normalIndex[2]);
-		}else{
-			// Probably a comment, eat up the rest of the line
-			char stupidBuffer[1000];
-			fgets(stupidBuffer, 1000, file);
+			isValid = isValid && faceCorners.size() >= 3;
+
+			// Quads and other polygons are triangulated as a fan around the first corner
+			for (size_t i = 1; isValid && i + 1 < faceCorners.size(); i++)
+			{
+				chunk.corners.push_back(faceCorners[0]);
+				chunk.corners.push_back(faceCorners[i]);
+				chunk.corners.push_back(faceCorners[i + 1]);
+			}
+		}
+		// Anything else is a comment or a statement we don't care about (o, g, s, usemtl...)
+
+		if (!isValid)
+		{
+			chunk.errorLine = chunk.numLines;
+			return;
 		}
+		p = lineEnd + 1;
+	}
+}
+
+// Resolves an attribute index of a corner to an absolute index, returns false if it's out of range
+inline bool resolveCornerIndex(int& index, bool isRelative, size_t chunkBase, size_t totalCount)
+{
+	if (isRelative)
+		index += static_cast<int>(chunkBase);
+	return index >= 0 && static_cast<size_t>(index) < totalCount;
+}
+
+// Splits the range into (at most) given number of ranges, each ending with a whole line
+std::vector<const char*> splitAtLines(const char* begin, const char* end, size_t numChunks)
+{
+	std::vector<const char*> boundaries{ begin };
+	const size_t size = end - begin;
+	for (size_t i = 1; i < numChunks; i++)
+	{
+		const char* boundary = begin + size / numChunks * i;
+		if (boundary <= boundaries.back())
+			continue;
 
+		boundary = static_cast<const char*>(memchr(boundary, '\n', end - boundary));
+		if (boundary == nullptr)
+			break;
+		if (boundary + 1 > boundaries.back() && boundary + 1 < end)
+			boundaries.push_back(boundary + 1);
 	}
+	boundaries.push_back(end);
+	return boundaries;
+}
 
+// Expands triangles of one chunk into the output arrays, returns name of the missing element on error or nullptr
+const char* expandObjChunk(
+	const ObjChunk & chunk,
+	size_t vertexBase, size_t uvBase, size_t normalBase,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	glm::vec3 * out_vertices,
+	glm::vec2 * out_uvs,
+	glm::vec3 * out_normals
+){
 	// For each vertex of each triangle
-	for( unsigned int i=0; i<vertexIndices.size(); i++ ){
-
-		// Get the indices of its attributes
-		unsigned int vertexIndex = vertexIndices[i];
-		unsigned int uvIndex = uvIndices[i];
-		unsigned int normalIndex = normalIndices[i];
-		
-		// Get the attributes thanks to the index
-		glm::vec3 vertex = temp_vertices[ vertexIndex-1 ];
-		glm::vec2 uv = temp_uvs[ uvIndex-1 ];
-		glm::vec3 normal = temp_normals[ normalIndex-1 ];
-		
-		// Put the attributes in buffers
-		out_vertices.push_back(vertex);
-		out_uvs     .push_back(uv);
-		out_normals .push_back(normal);
-	
+	const auto& corners = chunk.corners;
+	for (size_t i = 0; i < corners.size(); i += 3)
+	{
+		bool hasNormals = true;
+		for (size_t j = i; j < i + 3; j++)
+		{
+			ObjCorner corner = corners[j];
+			if (!resolveCornerIndex(corner.vertex, (corner.relativeMask & RELATIVE_VERTEX) != 0, vertexBase, vertices.size()))
+				return "vertex";
+			out_vertices[j] = vertices[corner.vertex];
+
+			if (corner.uv == MISSING_INDEX)
+				out_uvs[j] = glm::vec2(0.0f);
+			else if (resolveCornerIndex(corner.uv, (corner.relativeMask & RELATIVE_UV) != 0, uvBase, uvs.size()))
+				out_uvs[j] = uvs[corner.uv];
+			else
+				return "texture coordinate";
+
+			if (corner.normal == MISSING_INDEX)
+				hasNormals = false;
+			else if (resolveCornerIndex(corner.normal, (corner.relativeMask & RELATIVE_NORMAL) != 0, normalBase, normals.size()))
+				out_normals[j] = normals[corner.normal];
+			else
+				return "normal";
+		}
+
+		// Triangles without normals get flat face normal
+		if (!hasNormals)
+		{
+			const glm::vec3 faceNormal = glm::cross(out_vertices[i + 1] - out_vertices[i], out_vertices[i + 2] - out_vertices[i]);
+			const float faceNormalLength = glm::length(faceNormal);
+			const glm::vec3 normal = faceNormalLength > 0.0f ? faceNormal / faceNormalLength : glm::vec3(0.0f, 1.0f, 0.0f);
+			out_normals[i] = out_normals[i + 1] = out_normals[i + 2] = normal;
+		}
+	}
+
+	return nullptr;
+}
+
+// Merges parsed chunks and expands the indexed data into the triangle soup loadOBJ returns.
+// With more chunks, every chunk is merged and expanded on its own thread.
+bool buildTriangleSoup(
+	const char * path,
+	std::vector<ObjChunk> & chunks,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+){
+	// Prefix sums of element counts give the position of every chunk's elements in the merged arrays
+	const size_t firstOutput = out_vertices.size();
+	size_t totalVertices = 0, totalUVs = 0, totalNormals = 0, totalCorners = firstOutput, totalLines = 0;
+	std::vector<size_t> vertexBases, uvBases, normalBases, cornerBases;
+	for (const auto& chunk : chunks)
+	{
+		if (chunk.errorLine != 0)
+		{
+			printf("File %s can't be read by our OBJ parser, line %zu is malformed\n", path, totalLines + chunk.errorLine);
+			return false;
+		}
+		vertexBases.push_back(totalVertices);
+		uvBases.push_back(totalUVs);
+		normalBases.push_back(totalNormals);
+		cornerBases.push_back(totalCorners);
+		totalVertices += chunk.vertices.size();
+		totalUVs += chunk.uvs.size();
+		totalNormals += chunk.normals.size();
+		totalCorners += chunk.corners.size();
+		totalLines += chunk.numLines;
+	}
+
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	if (chunks.size() == 1)
+	{
+		vertices.swap(chunks[0].vertices);
+		uvs.swap(chunks[0].uvs);
+		normals.swap(chunks[0].normals);
+	}
+	else
+	{
+		vertices.resize(totalVertices);
+		uvs.resize(totalUVs);
+		normals.resize(totalNormals);
+		runOnThreads(chunks.size(), [&](size_t i) {
+			std::copy(chunks[i].vertices.begin(), chunks[i].vertices.end(), vertices.begin() + vertexBases[i]);
+			std::copy(chunks[i].uvs.begin(), chunks[i].uvs.end(), uvs.begin() + uvBases[i]);
+			std::copy(chunks[i].normals.begin(), chunks[i].normals.end(), normals.begin() + normalBases[i]);
+		});
 	}
-	fclose(file);
+
+	// Merged arrays must be complete before any chunk is expanded, relative indices may point to other chunks
+	out_vertices.resize(totalCorners);
+	out_uvs.resize(totalCorners);
+	out_normals.resize(totalCorners);
+	std::vector<const char*> errors(chunks.size(), nullptr);
+	runOnThreads(chunks.size(), [&](size_t i) {
+		errors[i] = expandObjChunk(chunks[i], vertexBases[i], uvBases[i], normalBases[i], vertices, uvs, normals,
+			out_vertices.data() + cornerBases[i], out_uvs.data() + cornerBases[i], out_normals.data() + cornerBases[i]);
+	});
+
+	for (const auto error : errors)
+	{
+		if (error != nullptr)
+		{
+			printf("File %s references %s that doesn't exist\n", path, error);
+			out_vertices.resize(firstOutput);
+			out_uvs.resize(firstOutput);
+			out_normals.resize(firstOutput);
+			return false;
+		}
+	}
+
 	return true;
 }
 
+} // namespace
+
+bool loadOBJ(
+	const char * path, 
+	std::vector<glm::vec3> & out_vertices, 
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	unsigned int numThreads
+){
+	printf("Loading OBJ file %s...\n", path);
+
+	MappedFile file;
+	if (!file.open(path)) {
+		printf("Impossible to open the file %s ! Are you in the right path ?\n", path);
+		return false;
+	}
+
+	const char* begin = file.getData();
+	const char* end = begin + file.getSize();
+
+	// Small files are parsed serially, spawning threads would take longer than parsing them
+	if (numThreads == OBJ_LOADER_ALL_CORES)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	const size_t maxChunks = std::max<size_t>(file.getSize() / OBJ_LOADER_MIN_CHUNK_SIZE, 1);
+	const auto boundaries = splitAtLines(begin, end, std::min<size_t>(numThreads, maxChunks));
+
+	std::vector<ObjChunk> chunks(boundaries.size() - 1);
+	runOnThreads(chunks.size(), [&](size_t i) {
+		parseObjChunk(boundaries[i], boundaries[i + 1], chunks[i]);
+	});
+
+	return buildTriangleSoup(path, chunks, out_vertices, out_uvs, out_normals);
+}
+
 
 #ifdef USE_ASSIMP // don't use this #define, it's only for me (it AssImp fails to compile on your machine, at least all the other tutorials still work)
 
@@ -1,11 +1,22 @@
 #ifndef OBJLOADER_H
 #define OBJLOADER_H
 
+#include <cstddef>
+
+// Pass as numThreads to loadOBJ to parse on all hardware threads
+const unsigned int OBJ_LOADER_ALL_CORES = 0;
+
+// Files are never split into chunks smaller than this (in bytes), smaller files are parsed serially
+const size_t OBJ_LOADER_MIN_CHUNK_SIZE = 1 << 20;
+
+// Loads OBJ file as a triangle soup. Parsing is split at line boundaries into up to numThreads chunks,
+// which are parsed (and then de-indexed) in parallel, each on its own thread.
 bool loadOBJ(
 	const char * path, 
 	std::vector<glm::vec3> & out_vertices, 
 	std::vector<glm::vec2> & out_uvs, 
-	std::vector<glm::vec3> & out_normals
+	std::vector<glm::vec3> & out_normals,
+	unsigned int numThreads = 1
 );
 
 
@@ -0,0 +1,38 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+// Pass as numThreads to use all hardware threads
+const unsigned int ALL_HARDWARE_THREADS = 0;
+
+// Calls function(i) for every i in [0, count), each call on its own thread (the last one on the calling thread)
+template <typename Function>
+void runOnThreads(size_t count, const Function& function)
+{
+	std::vector<std::thread> threads;
+	threads.reserve(count);
+	for (size_t i = 0; i + 1 < count; i++)
+		threads.emplace_back(function, i);
+	if (count > 0)
+		function(count - 1);
+	for (auto& thread : threads)
+		thread.join();
+}
+
+// Splits [0, count) into contiguous ranges of at least minRangeSize elements and calls function(begin, end)
+// for every range, each on its own thread. Ranges depend only on count, numThreads and minRangeSize.
+template <typename Function>
+void parallelForRanges(size_t count, unsigned int numThreads, size_t minRangeSize, const Function& function)
+{
+	if (numThreads == ALL_HARDWARE_THREADS)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	const size_t numRanges = std::max<size_t>(std::min<size_t>(numThreads, count / std::max<size_t>(minRangeSize, 1)), 1);
+	runOnThreads(numRanges, [&](size_t range) {
+		function(count * range / numRanges, count * (range + 1) / numRanges);
+	});
+}
+
+#endif
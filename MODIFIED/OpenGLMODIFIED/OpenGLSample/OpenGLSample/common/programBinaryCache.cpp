@@ -0,0 +1,218 @@
+// STL
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// GLAD (types and constants only, functions are loaded in ProgramBinaryCache::initialize)
+#include <glad/glad.h>
+
+// Project
+#include "programBinaryCache.h"
+#include "fileUtils.h"
+#include "hash.h"
+#include "mappedFile.h"
+
+// Program binaries are core in OpenGL 4.1 only, 3.3 contexts expose them through ARB_get_program_binary
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+const char ProgramBinaryCache::MAGIC[4] = { 'P', 'B', 'I', 'N' };
+const uint32_t ProgramBinaryCache::VERSION = 1;
+
+namespace {
+
+    std::string cacheDirectory = "shadercache"; // Directory of the binary files ("" = cache disabled)
+    bool isSupported = false; // True, if all functions were loaded and driver has at least one binary format
+
+    // Functions used by the cache, loaded through the application's loader, so that the cache works
+    // the same with GLAD and GLEW and with loaders generated for OpenGL versions without program binaries
+    struct Functions
+    {
+        const GLubyte* (APIENTRY* getString)(GLenum name);
+        void (APIENTRY* getIntegerv)(GLenum pname, GLint* data);
+        GLuint (APIENTRY* createProgram)();
+        void (APIENTRY* deleteProgram)(GLuint program);
+        void (APIENTRY* getProgramiv)(GLuint program, GLenum pname, GLint* params);
+        void (APIENTRY* programParameteri)(GLuint program, GLenum pname, GLint value);
+        void (APIENTRY* getProgramBinary)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+        void (APIENTRY* programBinary)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+    } gl = {};
+
+    template <typename Function>
+    bool loadFunction(ProgramBinaryCache::LoadProc loadProc, const char* name, Function& function)
+    {
+        function = reinterpret_cast<Function>(loadProc(name));
+        return function != nullptr;
+    }
+
+    // Hashes string including its terminating zero, so that ("ab", "c") and ("a", "bc") differ
+    uint64_t hashString(const char* text, uint64_t hash)
+    {
+        return hashData(text ? text : "", text ? strlen(text) + 1 : 1, hash);
+    }
+
+} // namespace
+
+bool ProgramBinaryCache::initialize(LoadProc loadProc)
+{
+    isSupported = loadFunction(loadProc, "glGetString", gl.getString)
+        && loadFunction(loadProc, "glGetIntegerv", gl.getIntegerv)
+        && loadFunction(loadProc, "glCreateProgram", gl.createProgram)
+        && loadFunction(loadProc, "glDeleteProgram", gl.deleteProgram)
+        && loadFunction(loadProc, "glGetProgramiv", gl.getProgramiv)
+        && loadFunction(loadProc, "glProgramParameteri", gl.programParameteri)
+        && loadFunction(loadProc, "glGetProgramBinary", gl.getProgramBinary)
+        && loadFunction(loadProc, "glProgramBinary", gl.programBinary);
+    if (isSupported)
+    {
+        // Some drivers (Mesa without its shader disk cache) expose the functions, but no formats
+        GLint numFormats = 0;
+        gl.getIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        isSupported = numFormats > 0;
+    }
+
+    if (!isSupported) {
+        std::cout << "Program binaries are not supported by the driver, shaders will be compiled on every launch" << std::endl;
+    }
+    return isSupported;
+}
+
+void ProgramBinaryCache::setDirectory(const std::string& directory)
+{
+    cacheDirectory = directory;
+}
+
+const std::string& ProgramBinaryCache::getDirectory()
+{
+    return cacheDirectory;
+}
+
+bool ProgramBinaryCache::isAvailable()
+{
+    return isSupported && !cacheDirectory.empty();
+}
+
+uint64_t ProgramBinaryCache::computeKey(const std::vector<std::string>& sources)
+{
+    if (!isAvailable()) {
+        return 0;
+    }
+
+    auto key = hashData(&VERSION, sizeof(VERSION));
+    for (const auto& source : sources) {
+        key = hashString(source.c_str(), key);
+    }
+
+    // Binaries are valid only for the exact driver, that produced them
+    const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+    for (const auto name : driverStrings) {
+        key = hashString(reinterpret_cast<const char*>(gl.getString(name)), key);
+    }
+    return key;
+}
+
+unsigned int ProgramBinaryCache::load(uint64_t key)
+{
+    if (!isAvailable()) {
+        return 0;
+    }
+
+    MappedFile file;
+    if (!file.open(getPath(key).c_str())) {
+        return 0;
+    }
+
+    const auto header = reinterpret_cast<const ProgramBinaryHeader*>(file.getData());
+    if (file.getSize() < sizeof(ProgramBinaryHeader)
+        || memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+        || header->version != VERSION
+        || header->key != key
+        || header->binaryLength != file.getSize() - sizeof(ProgramBinaryHeader)) {
+        return 0;
+    }
+
+    const auto program = gl.createProgram();
+    gl.programBinary(program, header->binaryFormat, file.getData() + sizeof(ProgramBinaryHeader), GLsizei(header->binaryLength));
+    GLint isLinked = GL_FALSE;
+    gl.getProgramiv(program, GL_LINK_STATUS, &isLinked);
+    if (isLinked != GL_TRUE)
+    {
+        // Driver changed without changing its strings, program gets compiled and stored again
+        std::cout << "Cached program binary " << getPath(key) << " was rejected by the driver" << std::endl;
+        gl.deleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+void ProgramBinaryCache::prepareForLinking(unsigned int program)
+{
+    if (isAvailable()) {
+        gl.programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+bool ProgramBinaryCache::store(unsigned int program, uint64_t key)
+{
+    if (!isAvailable()) {
+        return false;
+    }
+
+    GLint binaryLength = 0;
+    gl.getProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    if (binaryLength <= 0) {
+        return false;
+    }
+
+    ProgramBinaryHeader header = {};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.key = key;
+    std::vector<char> binary(binaryLength);
+    GLsizei writtenLength = 0;
+    GLenum binaryFormat = 0;
+    gl.getProgramBinary(program, binaryLength, &writtenLength, &binaryFormat, binary.data());
+    if (writtenLength <= 0) {
+        return false;
+    }
+    header.binaryFormat = binaryFormat;
+    header.binaryLength = uint32_t(writtenLength);
+
+    createDirectory(cacheDirectory);
+    const auto path = getPath(key);
+    const auto file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        std::cerr << "Could not open program binary file " << path << " for writing!" << std::endl;
+        return false;
+    }
+
+    const auto isWritten = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(binary.data(), 1, header.binaryLength, file) == header.binaryLength;
+    if (fclose(file) != 0 || !isWritten)
+    {
+        std::cerr << "Could not write program binary file " << path << "!" << std::endl;
+        remove(path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+std::string ProgramBinaryCache::getPath(uint64_t key)
+{
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%016llx.bin", static_cast<unsigned long long>(key));
+    return cacheDirectory + "/" + fileName;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Header of the cached program binary file, followed by the binary itself.
+ */
+struct ProgramBinaryHeader
+{
+    char magic[4]; // Always ProgramBinaryCache::MAGIC
+    uint32_t version; // Version of the format, files with other version are ignored
+    uint64_t key; // Key of the program (see ProgramBinaryCache::computeKey)
+    uint32_t binaryFormat; // Driver specific format returned by glGetProgramBinary
+    uint32_t binaryLength; // Byte size of the binary
+};
+
+static_assert(sizeof(ProgramBinaryHeader) == 24, "ProgramBinaryHeader must not contain implicit padding");
+
+/**
+ * On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary), so that shaders
+ * are compiled only on the first launch. Programs are keyed on their sources (including defines)
+ * and on the vendor, renderer and version strings of the driver, binaries from other drivers are
+ * never even looked at. Driver can still reject a binary (after an update with the same strings),
+ * callers then compile the program from the sources as usual and store the new binary.
+ *
+ * Header doesn't include any OpenGL loader, so it can be used with both GLAD and GLEW code,
+ * program IDs are passed as unsigned int (GLuint). Cache stays disabled until initialize() succeeds.
+ */
+class ProgramBinaryCache
+{
+public:
+    static const char MAGIC[4]; // Magic number at the start of every binary file ("PBIN")
+    static const uint32_t VERSION; // Current version of the format
+
+    typedef void* (*LoadProc)(const char* name); // Function loader, e.g. glfwGetProcAddress
+
+    /**
+     * Loads the functions used by the cache (OpenGL context must be current). Fails, if the driver
+     * doesn't support program binaries, the cache is then disabled and shaders are always compiled.
+     *
+     * @param loadProc  Function returning address of OpenGL function by its name
+     *
+     * @return True, if program binaries are supported.
+     */
+    static bool initialize(LoadProc loadProc);
+
+    /**
+     * Sets directory, where the binaries are stored (empty string disables the cache). Default is "shadercache".
+     */
+    static void setDirectory(const std::string& directory);
+
+    /**
+     * Gets directory, where the binaries are stored.
+     */
+    static const std::string& getDirectory();
+
+    /**
+     * Checks, if the cache has been initialized, is enabled and the driver supports program binaries.
+     */
+    static bool isAvailable();
+
+    /**
+     * Computes key of the program from its sources and identification of the current driver.
+     *
+     * @param sources  Final source of every shader stage (with all defines inserted), in stage order
+     *
+     * @return Key of the program, or 0 if the cache is not available.
+     */
+    static uint64_t computeKey(const std::vector<std::string>& sources);
+
+    /**
+     * Creates program from the cached binary.
+     *
+     * @param key  Key of the program
+     *
+     * @return Linked program, or 0 if there's no binary for the key or the driver rejected it.
+     */
+    static unsigned int load(uint64_t key);
+
+    /**
+     * Asks the driver to keep the binary of the program retrievable, must be called before linking.
+     */
+    static void prepareForLinking(unsigned int program);
+
+    /**
+     * Stores binary of the successfully linked program.
+     *
+     * @param program  Linked program
+     * @param key      Key of the program
+     *
+     * @return True, if the binary has been written.
+     */
+    static bool store(unsigned int program, uint64_t key);
+
+private:
+    /**
+     * Gets path of the binary file for given key.
+     */
+    static std::string getPath(uint64_t key);
+};
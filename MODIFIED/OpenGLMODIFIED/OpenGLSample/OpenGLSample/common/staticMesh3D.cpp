@@ -1,19 +1,39 @@
+// STL
+#include <cstring>
+
 // GLM
 #include <glm/glm.hpp>
 
 // Project
 #include "staticMesh3D.h"
+#include "glState.h"
 
 namespace static_meshes_3D {
 
+void VertexLayout::writePosition(void* vertexData, int vertexIndex, const glm::vec3& position) const
+{
+    memcpy(static_cast<unsigned char*>(vertexData) + positionOffset + positionStride*vertexIndex, &position, sizeof(glm::vec3));
+}
+
+void VertexLayout::writeTextureCoordinate(void* vertexData, int vertexIndex, const glm::vec2& textureCoordinate) const
+{
+    memcpy(static_cast<unsigned char*>(vertexData) + textureCoordinateOffset + textureCoordinateStride*vertexIndex, &textureCoordinate, sizeof(glm::vec2));
+}
+
+void VertexLayout::writeNormal(void* vertexData, int vertexIndex, const glm::vec3& normal) const
+{
+    memcpy(static_cast<unsigned char*>(vertexData) + normalOffset + normalStride*vertexIndex, &normal, sizeof(glm::vec3));
+}
+
 const int StaticMesh3D::POSITION_ATTRIBUTE_INDEX           = 0;
 const int StaticMesh3D::TEXTURE_COORDINATE_ATTRIBUTE_INDEX = 1;
 const int StaticMesh3D::NORMAL_ATTRIBUTE_INDEX             = 2;
 
-StaticMesh3D::StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals)
+StaticMesh3D::StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout::Packing packing)
     : _hasPositions(withPositions)
     , _hasTextureCoordinates(withTextureCoordinates)
-    , _hasNormals(withNormals) {}
+    , _hasNormals(withNormals)
+    , _packing(packing) {}
 
 StaticMesh3D::~StaticMesh3D()
 {
@@ -26,7 +46,7 @@ void StaticMesh3D::deleteMesh()
         return;
     }
 
-    glDeleteVertexArrays(1, &_vao);
+    GLState::deleteVertexArrays(1, &_vao);
     _vbo.deleteVBO();
 
     _isInitialized = false;
@@ -63,32 +83,97 @@ int StaticMesh3D::getVertexByteSize() const
     return result;
 }
 
+VertexLayout::Packing StaticMesh3D::getVertexPacking() const
+{
+    return _packing;
+}
+
+const VertexLayout& StaticMesh3D::getVertexLayout() const
+{
+    return _vertexLayout;
+}
+
+GLuint StaticMesh3D::getVAO() const
+{
+    return _vao;
+}
+
+const MeshBounds& StaticMesh3D::getBounds() const
+{
+    return _bounds;
+}
+
+const VertexLayout& StaticMesh3D::createVertexLayout(int numVertices)
+{
+    // Planar packing puts whole attribute blocks one after another, interleaved packing puts attributes of one vertex next to each other
+    const auto isInterleaved = _packing == VertexLayout::Packing::Interleaved;
+    const auto vertexByteSize = size_t(getVertexByteSize());
+
+    VertexLayout layout;
+    layout.packing = _packing;
+    layout.numVertices = numVertices;
+    layout.byteSize = vertexByteSize*numVertices;
+
+    size_t offset = 0;
+    if (hasPositions())
+    {
+        layout.positionOffset = offset;
+        layout.positionStride = isInterleaved ? vertexByteSize : sizeof(glm::vec3);
+        offset += isInterleaved ? sizeof(glm::vec3) : sizeof(glm::vec3)*numVertices;
+    }
+
+    if (hasTextureCoordinates())
+    {
+        layout.textureCoordinateOffset = offset;
+        layout.textureCoordinateStride = isInterleaved ? vertexByteSize : sizeof(glm::vec2);
+        offset += isInterleaved ? sizeof(glm::vec2) : sizeof(glm::vec2)*numVertices;
+    }
+
+    if (hasNormals())
+    {
+        layout.normalOffset = offset;
+        layout.normalStride = isInterleaved ? vertexByteSize : sizeof(glm::vec3);
+        offset += isInterleaved ? sizeof(glm::vec3) : sizeof(glm::vec3)*numVertices;
+    }
+
+    _vertexLayout = layout;
+    return _vertexLayout;
+}
+
 void StaticMesh3D::setVertexAttributesPointers(int numVertices)
 {
-    uint64_t offset = 0;
+    if (_vertexLayout.numVertices != numVertices) {
+        createVertexLayout(numVertices);
+    }
+
+    const auto& layout = _vertexLayout;
     if (hasPositions())
     {
         glEnableVertexAttribArray(POSITION_ATTRIBUTE_INDEX);
-        glVertexAttribPointer(POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(offset));
-
-        offset += sizeof(glm::vec3)*numVertices;
+        glVertexAttribPointer(POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, GLsizei(layout.positionStride), reinterpret_cast<void*>(layout.positionOffset));
     }
 
     if (hasTextureCoordinates())
     {
         glEnableVertexAttribArray(TEXTURE_COORDINATE_ATTRIBUTE_INDEX);
-        glVertexAttribPointer(TEXTURE_COORDINATE_ATTRIBUTE_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), reinterpret_cast<void*>(offset));
-
-        offset += sizeof(glm::vec2)*numVertices;
+        glVertexAttribPointer(TEXTURE_COORDINATE_ATTRIBUTE_INDEX, 2, GL_FLOAT, GL_FALSE, GLsizei(layout.textureCoordinateStride), reinterpret_cast<void*>(layout.textureCoordinateOffset));
     }
 
     if (hasNormals())
     {
         glEnableVertexAttribArray(NORMAL_ATTRIBUTE_INDEX);
-        glVertexAttribPointer(NORMAL_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(offset));
+        glVertexAttribPointer(NORMAL_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, GLsizei(layout.normalStride), reinterpret_cast<void*>(layout.normalOffset));
+    }
+}
 
-        offset += sizeof(glm::vec3)*numVertices;
+void StaticMesh3D::computeBounds(const void* vertexData)
+{
+    if (!hasPositions()) {
+        return;
     }
+
+    const auto& layout = _vertexLayout;
+    _bounds = MeshBounds::fromPositions(static_cast<const unsigned char*>(vertexData) + layout.positionOffset, layout.positionStride, size_t(layout.numVertices));
 }
 
 } // namespace static_meshes_3D
\ No newline at end of file
@@ -1,11 +1,56 @@
 #define _CRT_SECURE_NO_WARNINGS
 #pragma once
 
+// GLM
+#include <glm/glm.hpp>
+
 // Project
-#include "/Users/zuzan/CompSci/OpenGLSample/OpenGLSample/common/vertexBufferObject.h"
+#include "vertexBufferObject.h"
+#include "boundingVolume.h"
 
 namespace static_meshes_3D {
 
+/**
+ * Describes where vertex attributes of a static mesh are stored in its vertex buffer.
+ */
+struct VertexLayout
+{
+	/**
+	 * How vertex attributes are packed in the buffer.
+	 */
+	enum class Packing
+	{
+		Planar, // All positions first, then all texture coordinates, then all normals (SoA)
+		Interleaved // Attributes of one vertex stored next to each other (AoS)
+	};
+
+	Packing packing = Packing::Interleaved; // Packing of the attributes
+	int numVertices = 0; // Number of vertices in the buffer
+	size_t byteSize = 0; // Byte size of data of all vertices
+
+	size_t positionOffset = 0; // Byte offset of the first vertex position
+	size_t positionStride = 0; // Byte distance between two consecutive vertex positions
+	size_t textureCoordinateOffset = 0; // Byte offset of the first texture coordinate
+	size_t textureCoordinateStride = 0; // Byte distance between two consecutive texture coordinates
+	size_t normalOffset = 0; // Byte offset of the first vertex normal
+	size_t normalStride = 0; // Byte distance between two consecutive vertex normals
+
+	/**
+	 * Writes position of given vertex to the vertex data.
+	 */
+	void writePosition(void* vertexData, int vertexIndex, const glm::vec3& position) const;
+
+	/**
+	 * Writes texture coordinate of given vertex to the vertex data.
+	 */
+	void writeTextureCoordinate(void* vertexData, int vertexIndex, const glm::vec2& textureCoordinate) const;
+
+	/**
+	 * Writes normal of given vertex to the vertex data.
+	 */
+	void writeNormal(void* vertexData, int vertexIndex, const glm::vec3& normal) const;
+};
+
 /**
  * Represents generic 3D static mesh.
  */
@@ -16,7 +61,8 @@ public:
 	static const int TEXTURE_COORDINATE_ATTRIBUTE_INDEX; // Vertex attribute index of texture coordinate (1)
 	static const int NORMAL_ATTRIBUTE_INDEX; // Vertex attribute index of vertex normal (2)
 
-	StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals);
+	StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals,
+		VertexLayout::Packing packing = VertexLayout::Packing::Interleaved);
 	virtual ~StaticMesh3D();
 
 	/**
@@ -55,14 +101,37 @@ public:
 	 */
 	int getVertexByteSize() const;
 
+	/**
+	 * Gets packing of the vertex attributes chosen for this mesh.
+	 */
+	VertexLayout::Packing getVertexPacking() const;
+
+	/**
+	 * Gets layout of the vertex data of this mesh (valid once the mesh is initialized).
+	 */
+	const VertexLayout& getVertexLayout() const;
+
+	/**
+	 * Gets VAO ID of the mesh (0 until the mesh is initialized).
+	 */
+	GLuint getVAO() const;
+
+	/**
+	 * Gets model space bounding box and sphere of the mesh (empty until the mesh is initialized).
+	 */
+	const MeshBounds& getBounds() const;
+
 protected:
 	bool _hasPositions = false; // Flag telling, if we have vertex positions
 	bool _hasTextureCoordinates = false; // Flag telling, if we have texture coordinates
 	bool _hasNormals = false; // Flag telling, if we have vertex normals
+	VertexLayout::Packing _packing; // Packing of the vertex attributes
+	VertexLayout _vertexLayout; // Layout of the vertex data in the VBO
 
 	bool _isInitialized = false; // Is mesh initialized flag
 	GLuint _vao = 0; // VAO ID from OpenGL
 	VertexBufferObject _vbo; // Our VBO wrapper class holding static mesh data
+	MeshBounds _bounds; // Bounding volumes of the vertex positions
 
 	/**
 	 * Initializes vertex data. Default implementation does nothing as its not needed for all classes
@@ -70,11 +139,25 @@ protected:
 	virtual void initializeData() {}
 
 	/**
-	* Sets vertex attribute pointers in a standard way.
+	 * Computes vertex layout for given number of vertices and chosen packing and remembers it.
+	 *
+	 * @param numVertices  Number of vertices, that will be present in the buffer
+	 */
+	const VertexLayout& createVertexLayout(int numVertices);
+
+	/**
+	* Sets vertex attribute pointers according to the vertex layout.
 	*
 	* @param numVertices  Number of vertices present in the buffer
 	*/
 	void setVertexAttributesPointers(int numVertices);
+
+	/**
+	 * Computes bounds of the positions in vertex data written according to the vertex layout.
+	 *
+	 * @param vertexData  Vertex data of the mesh
+	 */
+	void computeBounds(const void* vertexData);
 };
 
 }; // namespace static_meshes_3D
\ No newline at end of file
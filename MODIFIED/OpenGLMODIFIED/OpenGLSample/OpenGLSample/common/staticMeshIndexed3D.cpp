@@ -1,10 +1,16 @@
+// STL
+#include <cstdint>
+
 // Project
 #include "staticMeshIndexed3D.h"
+#include "glState.h"
 
 namespace static_meshes_3D {
 
-StaticMeshIndexed3D::StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals)
-    : StaticMesh3D(withPositions, withTextureCoordinates, withNormals) {}
+const GLuint StaticMeshIndexed3D::PRIMITIVE_RESTART_MARKER = 0xFFFFFFFF;
+
+StaticMeshIndexed3D::StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout::Packing packing)
+    : StaticMesh3D(withPositions, withTextureCoordinates, withNormals, packing) {}
 
 StaticMeshIndexed3D::~StaticMeshIndexed3D()
 {
@@ -22,4 +28,67 @@ void StaticMeshIndexed3D::deleteMesh()
     }
 }
 
+GLenum StaticMeshIndexed3D::getIndexType() const
+{
+    return _indexType;
+}
+
+int StaticMeshIndexed3D::getNumIndices() const
+{
+    return _numIndices;
+}
+
+GLuint StaticMeshIndexed3D::getPrimitiveRestartIndex() const
+{
+    return _primitiveRestartIndex;
+}
+
+void StaticMeshIndexed3D::uploadIndices(const std::vector<GLuint>& indices)
+{
+    _numIndices = static_cast<int>(indices.size());
+
+    // 16-bit indices are enough, if all vertices and the restart index itself fit into them
+    if (_numVertices < 0xFFFF)
+    {
+        _indexType = GL_UNSIGNED_SHORT;
+        _primitiveRestartIndex = 0xFFFF;
+        _indicesVBO.createVBO(indices.size() * sizeof(uint16_t));
+        auto data = static_cast<uint16_t*>(_indicesVBO.allocateRawData(indices.size() * sizeof(uint16_t)));
+        for (size_t i = 0; i < indices.size(); i++) {
+            data[i] = indices[i] == PRIMITIVE_RESTART_MARKER ? uint16_t(0xFFFF) : static_cast<uint16_t>(indices[i]);
+        }
+    }
+    else
+    {
+        _indexType = GL_UNSIGNED_INT;
+        _primitiveRestartIndex = PRIMITIVE_RESTART_MARKER;
+        _indicesVBO.createVBO(indices.size() * sizeof(GLuint));
+        _indicesVBO.addRawData(indices.data(), indices.size() * sizeof(GLuint));
+    }
+
+    _indicesVBO.bindVBO(GL_ELEMENT_ARRAY_BUFFER);
+    _indicesVBO.uploadDataToGPU(GL_STATIC_DRAW);
+}
+
+void StaticMeshIndexed3D::uploadIndices(const void* indexData, int numIndices, GLenum indexType)
+{
+    const auto indexByteSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(GLuint);
+    _numIndices = numIndices;
+    _indexType = indexType;
+    _primitiveRestartIndex = indexType == GL_UNSIGNED_SHORT ? 0xFFFF : PRIMITIVE_RESTART_MARKER;
+
+    _indicesVBO.createVBO();
+    _indicesVBO.bindVBO(GL_ELEMENT_ARRAY_BUFFER);
+    _indicesVBO.uploadDataToGPU(indexData, numIndices * indexByteSize, GL_STATIC_DRAW);
+}
+
+void StaticMeshIndexed3D::renderIndexed(GLenum primitiveType) const
+{
+    GLState::bindVertexArray(_vao);
+    GLState::enable(GL_PRIMITIVE_RESTART);
+    GLState::primitiveRestartIndex(_primitiveRestartIndex);
+    glDrawElements(primitiveType, _numIndices, _indexType, nullptr);
+    GLState::disable(GL_PRIMITIVE_RESTART);
+}
+
 } // namespace static_meshes_3D
\ No newline at end of file
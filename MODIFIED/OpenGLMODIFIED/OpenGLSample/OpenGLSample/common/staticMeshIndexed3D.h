@@ -1,5 +1,8 @@
 #pragma once
 
+// STL
+#include <vector>
+
 // Project
 #include "staticMesh3D.h"
 
@@ -11,17 +14,62 @@ namespace static_meshes_3D {
 class StaticMeshIndexed3D : public StaticMesh3D
 {
 public:
-    StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals);
+    static const GLuint PRIMITIVE_RESTART_MARKER; // Marks primitive restart in indices passed to uploadIndices()
+
+    StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals,
+        VertexLayout::Packing packing = VertexLayout::Packing::Interleaved);
     virtual ~StaticMeshIndexed3D();
 
     void deleteMesh() override;
 
+    /**
+     * Gets type of the indices (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT).
+     */
+    GLenum getIndexType() const;
+
+    /**
+     * Gets number of indices rendered by renderIndexed() (including primitive restart indices).
+     */
+    int getNumIndices() const;
+
+    /**
+     * Gets primitive restart index matching the index type.
+     */
+    GLuint getPrimitiveRestartIndex() const;
+
 protected:
     VertexBufferObject _indicesVBO; // Our VBO wrapper class holding indices data
 
     int _numVertices = 0; // Holds the total number of generated vertices
     int _numIndices = 0; // Holds the number of generated indices used for rendering
-    int _primitiveRestartIndex = 0; // Index of primitive restart
+    GLuint _primitiveRestartIndex = 0; // Index of primitive restart
+    GLenum _indexType = GL_UNSIGNED_INT; // Type of the indices in the indices VBO
+
+    /**
+     * Creates indices VBO and uploads given indices to it. Smallest index type able to address all
+     * vertices is chosen (16-bit if possible) and PRIMITIVE_RESTART_MARKER entries are turned into
+     * primitive restart index of that type. VAO of the mesh must be bound.
+     *
+     * @param indices  Indices to upload, _numVertices must be set already
+     */
+    void uploadIndices(const std::vector<GLuint>& indices);
+
+    /**
+     * Creates indices VBO and uploads already encoded indices to it as they are (no conversion, no copy).
+     * Primitive restart index is set to the largest value of the index type. VAO of the mesh must be bound.
+     *
+     * @param indexData   Pointer to the indices
+     * @param numIndices  Number of indices
+     * @param indexType   Type of the indices (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+     */
+    void uploadIndices(const void* indexData, int numIndices, GLenum indexType);
+
+    /**
+     * Renders all indices with primitive restart enabled (in one draw call).
+     *
+     * @param primitiveType  Type of rendered primitives (GL_TRIANGLE_STRIP for instance)
+     */
+    void renderIndexed(GLenum primitiveType) const;
 };
 
 }; // namespace static_meshes_3D
\ No newline at end of file
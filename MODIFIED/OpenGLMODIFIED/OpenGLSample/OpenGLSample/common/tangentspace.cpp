@@ -1,6 +1,15 @@
 #include <vector>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
 #include <glm/glm.hpp>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TANGENTSPACE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "parallel.hpp"
 #include "tangentspace.hpp"
 
 void computeTangentBasis(
@@ -70,4 +79,224 @@ void computeTangentBasis(
 
 }
 
+namespace {
+
+const float PI = 3.14159265358979f;
+
+// Less triangles / vertices than this are not worth another thread
+const size_t MIN_ELEMENTS_PER_THREAD = 16384;
+
+// Angle weighted tangents and bitangents of triangle corners, stored as separate component arrays.
+// Corner c of triangle t is at c * numTriangles + t, so the same corner of consecutive triangles is contiguous.
+struct CornerTangents
+{
+	size_t numTriangles;
+	std::vector<float> tx, ty, tz, bx, by, bz;
+
+	explicit CornerTangents(size_t numTriangles)
+		: numTriangles(numTriangles)
+		, tx(numTriangles * 3), ty(numTriangles * 3), tz(numTriangles * 3)
+		, bx(numTriangles * 3), by(numTriangles * 3), bz(numTriangles * 3)
+	{
+	}
+};
+
+inline float clampedAcos(float cosine)
+{
+	return acosf(std::max(-1.0f, std::min(1.0f, cosine)));
+}
+
+void computeCornerTangents(
+	const std::vector<unsigned int> & indices,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	size_t triangle,
+	CornerTangents & corners
+){
+	const unsigned int i0 = indices[triangle*3+0], i1 = indices[triangle*3+1], i2 = indices[triangle*3+2];
+	const glm::vec3 deltaPos1 = vertices[i1] - vertices[i0];
+	const glm::vec3 deltaPos2 = vertices[i2] - vertices[i0];
+	const glm::vec3 deltaPos3 = vertices[i2] - vertices[i1];
+	const glm::vec2 deltaUV1 = uvs[i1] - uvs[i0];
+	const glm::vec2 deltaUV2 = uvs[i2] - uvs[i0];
+
+	const float determinant = deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x;
+	const float r = determinant != 0.0f ? 1.0f / determinant : 0.0f;
+	const glm::vec3 tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y)*r;
+	const glm::vec3 bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x)*r;
+
+	// Angles at the corners, degenerate triangles don't contribute at all
+	const float length1 = glm::length(deltaPos1), length2 = glm::length(deltaPos2), length3 = glm::length(deltaPos3);
+	float weights[3] = { 0.0f, 0.0f, 0.0f };
+	if (length1 * length2 * length3 > 0.0f) {
+		weights[0] = clampedAcos(glm::dot(deltaPos1, deltaPos2) / (length1 * length2));
+		weights[1] = clampedAcos(-glm::dot(deltaPos1, deltaPos3) / (length1 * length3));
+		weights[2] = std::max(PI - weights[0] - weights[1], 0.0f);
+	}
+
+	for (int c = 0; c < 3; c++) {
+		const size_t slot = c * corners.numTriangles + triangle;
+		corners.tx[slot] = tangent.x * weights[c];
+		corners.ty[slot] = tangent.y * weights[c];
+		corners.tz[slot] = tangent.z * weights[c];
+		corners.bx[slot] = bitangent.x * weights[c];
+		corners.by[slot] = bitangent.y * weights[c];
+		corners.bz[slot] = bitangent.z * weights[c];
+	}
+}
+
+#ifdef TANGENTSPACE_USE_SSE2
+
+inline __m128 dot4(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+}
+
+// Same as computeCornerTangents for 4 consecutive triangles at once, one triangle per SSE lane
+void computeCornerTangents4(
+	const std::vector<unsigned int> & indices,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	size_t firstTriangle,
+	CornerTangents & corners
+){
+	// Gather corners of the 4 triangles into component arrays (positions[corner][component][lane])
+	float positions[3][3][4], textureCoordinates[3][2][4];
+	for (int lane = 0; lane < 4; lane++) {
+		for (int c = 0; c < 3; c++) {
+			const unsigned int v = indices[(firstTriangle + lane) * 3 + c];
+			positions[c][0][lane] = vertices[v].x;
+			positions[c][1][lane] = vertices[v].y;
+			positions[c][2][lane] = vertices[v].z;
+			textureCoordinates[c][0][lane] = uvs[v].x;
+			textureCoordinates[c][1][lane] = uvs[v].y;
+		}
+	}
+
+	const __m128 x0 = _mm_loadu_ps(positions[0][0]), y0 = _mm_loadu_ps(positions[0][1]), z0 = _mm_loadu_ps(positions[0][2]);
+	const __m128 x1 = _mm_loadu_ps(positions[1][0]), y1 = _mm_loadu_ps(positions[1][1]), z1 = _mm_loadu_ps(positions[1][2]);
+	const __m128 x2 = _mm_loadu_ps(positions[2][0]), y2 = _mm_loadu_ps(positions[2][1]), z2 = _mm_loadu_ps(positions[2][2]);
+	const __m128 u0 = _mm_loadu_ps(textureCoordinates[0][0]), v0 = _mm_loadu_ps(textureCoordinates[0][1]);
+	const __m128 u1 = _mm_loadu_ps(textureCoordinates[1][0]), v1 = _mm_loadu_ps(textureCoordinates[1][1]);
+	const __m128 u2 = _mm_loadu_ps(textureCoordinates[2][0]), v2 = _mm_loadu_ps(textureCoordinates[2][1]);
 
+	const __m128 dx1 = _mm_sub_ps(x1, x0), dy1 = _mm_sub_ps(y1, y0), dz1 = _mm_sub_ps(z1, z0);
+	const __m128 dx2 = _mm_sub_ps(x2, x0), dy2 = _mm_sub_ps(y2, y0), dz2 = _mm_sub_ps(z2, z0);
+	const __m128 dx3 = _mm_sub_ps(x2, x1), dy3 = _mm_sub_ps(y2, y1), dz3 = _mm_sub_ps(z2, z1);
+	const __m128 du1 = _mm_sub_ps(u1, u0), dv1 = _mm_sub_ps(v1, v0);
+	const __m128 du2 = _mm_sub_ps(u2, u0), dv2 = _mm_sub_ps(v2, v0);
+
+	// Lanes with zero UV determinant get zero tangents (division result is masked out)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 determinant = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(dv1, du2));
+	const __m128 r = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), determinant), _mm_cmpneq_ps(determinant, zero));
+
+	const __m128 tx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dx1, dv2), _mm_mul_ps(dx2, dv1)), r);
+	const __m128 ty = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dy1, dv2), _mm_mul_ps(dy2, dv1)), r);
+	const __m128 tz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dz1, dv2), _mm_mul_ps(dz2, dv1)), r);
+	const __m128 bx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dx2, du1), _mm_mul_ps(dx1, du2)), r);
+	const __m128 by = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dy2, du1), _mm_mul_ps(dy1, du2)), r);
+	const __m128 bz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dz2, du1), _mm_mul_ps(dz1, du2)), r);
+
+	// Cosines of the angles at the first two corners, acos itself has no SSE instruction
+	const __m128 length1 = _mm_sqrt_ps(dot4(dx1, dy1, dz1, dx1, dy1, dz1));
+	const __m128 length2 = _mm_sqrt_ps(dot4(dx2, dy2, dz2, dx2, dy2, dz2));
+	const __m128 length3 = _mm_sqrt_ps(dot4(dx3, dy3, dz3, dx3, dy3, dz3));
+	const __m128 isValid = _mm_cmpgt_ps(_mm_mul_ps(_mm_mul_ps(length1, length2), length3), zero);
+	float cosines0[4], cosines1[4], valid[4];
+	_mm_storeu_ps(cosines0, _mm_div_ps(dot4(dx1, dy1, dz1, dx2, dy2, dz2), _mm_mul_ps(length1, length2)));
+	_mm_storeu_ps(cosines1, _mm_div_ps(_mm_sub_ps(zero, dot4(dx1, dy1, dz1, dx3, dy3, dz3)), _mm_mul_ps(length1, length3)));
+	_mm_storeu_ps(valid, _mm_and_ps(isValid, _mm_set1_ps(1.0f)));
+
+	float weights[3][4];
+	for (int lane = 0; lane < 4; lane++) {
+		weights[0][lane] = valid[lane] != 0.0f ? clampedAcos(cosines0[lane]) : 0.0f;
+		weights[1][lane] = valid[lane] != 0.0f ? clampedAcos(cosines1[lane]) : 0.0f;
+		weights[2][lane] = valid[lane] != 0.0f ? std::max(PI - weights[0][lane] - weights[1][lane], 0.0f) : 0.0f;
+	}
+
+	for (int c = 0; c < 3; c++) {
+		const size_t slot = c * corners.numTriangles + firstTriangle;
+		const __m128 weight = _mm_loadu_ps(weights[c]);
+		_mm_storeu_ps(&corners.tx[slot], _mm_mul_ps(tx, weight));
+		_mm_storeu_ps(&corners.ty[slot], _mm_mul_ps(ty, weight));
+		_mm_storeu_ps(&corners.tz[slot], _mm_mul_ps(tz, weight));
+		_mm_storeu_ps(&corners.bx[slot], _mm_mul_ps(bx, weight));
+		_mm_storeu_ps(&corners.by[slot], _mm_mul_ps(by, weight));
+		_mm_storeu_ps(&corners.bz[slot], _mm_mul_ps(bz, weight));
+	}
+}
+
+#endif
+
+} // namespace
+
+void computeTangentBasisIndexed(
+	// inputs
+	const std::vector<unsigned int> & indices,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	// outputs
+	std::vector<glm::vec3> & tangents,
+	std::vector<glm::vec3> & bitangents,
+	unsigned int numThreads
+){
+	const size_t numVertices = vertices.size();
+	const size_t numTriangles = indices.size() / 3;
+	if (uvs.size() != numVertices || normals.size() != numVertices) {
+		printf("Can't compute tangents, numbers of vertices, UVs and normals differ\n");
+		return;
+	}
+
+	// Weighted tangents of all triangle corners, each range of triangles on its own thread
+	CornerTangents corners(numTriangles);
+	parallelForRanges(numTriangles, numThreads, MIN_ELEMENTS_PER_THREAD, [&](size_t begin, size_t end) {
+		size_t triangle = begin;
+#ifdef TANGENTSPACE_USE_SSE2
+		for (; triangle + 4 <= end; triangle += 4)
+			computeCornerTangents4(indices, vertices, uvs, triangle, corners);
+#endif
+		for (; triangle < end; triangle++)
+			computeCornerTangents(indices, vertices, uvs, triangle, corners);
+	});
+
+	// Corners of every vertex (offsets per vertex into one array), in the order they appear in the indices
+	std::vector<unsigned int> vertexCornerOffsets(numVertices + 1, 0);
+	std::vector<unsigned int> vertexCorners(numTriangles * 3);
+	for (size_t i = 0; i < numTriangles * 3; i++)
+		vertexCornerOffsets[indices[i] + 1]++;
+	for (size_t v = 0; v < numVertices; v++)
+		vertexCornerOffsets[v + 1] += vertexCornerOffsets[v];
+	std::vector<unsigned int> fill(vertexCornerOffsets.begin(), vertexCornerOffsets.end() - 1);
+	for (size_t i = 0; i < numTriangles * 3; i++)
+		vertexCorners[fill[indices[i]]++] = static_cast<unsigned int>((i % 3) * numTriangles + i / 3);
+
+	// Sum up corners of every vertex and orthogonalize, each range of vertices on its own thread
+	tangents.resize(numVertices);
+	bitangents.resize(numVertices);
+	parallelForRanges(numVertices, numThreads, MIN_ELEMENTS_PER_THREAD, [&](size_t begin, size_t end) {
+		for (size_t v = begin; v < end; v++) {
+			glm::vec3 t(0.0f), b(0.0f);
+			for (unsigned int i = vertexCornerOffsets[v]; i < vertexCornerOffsets[v + 1]; i++) {
+				const unsigned int slot = vertexCorners[i];
+				t += glm::vec3(corners.tx[slot], corners.ty[slot], corners.tz[slot]);
+				b += glm::vec3(corners.bx[slot], corners.by[slot], corners.bz[slot]);
+			}
+
+			// Gram-Schmidt orthogonalize, vertices without usable UVs get any tangent perpendicular to the normal
+			const glm::vec3 & n = normals[v];
+			t = t - n * glm::dot(n, t);
+			if (glm::dot(t, t) <= 0.0f)
+				t = glm::cross(n, fabsf(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f));
+			t = glm::normalize(t);
+
+			// Calculate handedness
+			if (glm::dot(glm::cross(n, t), b) < 0.0f)
+				t = t * -1.0f;
+
+			tangents[v] = t;
+			bitangents[v] = glm::dot(b, b) > 0.0f ? glm::normalize(b) : glm::cross(n, t);
+		}
+	});
+}
@@ -11,5 +11,21 @@ void computeTangentBasis(
 	std::vector<glm::vec3> & bitangents
 );
 
+// Indexed variant: tangents and bitangents of all triangles sharing a vertex are summed up, weighted by the angle
+// of the triangle at that vertex, then the tangent is Gram-Schmidt orthogonalized to the normal and both are normalized.
+// Triangles and vertices are processed in ranges on numThreads threads (0 = all hardware threads), every vertex
+// sums contributions of its triangles in the same order, so the result doesn't depend on the number of threads.
+void computeTangentBasisIndexed(
+	// inputs
+	const std::vector<unsigned int> & indices,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	// outputs
+	std::vector<glm::vec3> & tangents,
+	std::vector<glm::vec3> & bitangents,
+	unsigned int numThreads = 1
+);
+
 
 #endif
\ No newline at end of file
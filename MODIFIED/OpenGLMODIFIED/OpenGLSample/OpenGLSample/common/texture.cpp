@@ -150,21 +150,10 @@ GLuint loadDDS(const char * imagepath){
 
 	unsigned int height      = *(unsigned int*)&(header[8 ]);
 	unsigned int width	     = *(unsigned int*)&(header[12]);
-	unsigned int linearSize	 = *(unsigned int*)&(header[16]);
 	unsigned int mipMapCount = *(unsigned int*)&(header[24]);
 	unsigned int fourCC      = *(unsigned int*)&(header[80]);
 
  
-	unsigned char * buffer;
-	unsigned int bufsize;
-	/* how big is it going to be including all mipmaps? */ 
-	bufsize = mipMapCount > 1 ? linearSize * 2 : linearSize; 
-	buffer = (unsigned char*)malloc(bufsize * sizeof(unsigned char)); 
-	fread(buffer, 1, bufsize, fp); 
-	/* close the file pointer */ 
-	fclose(fp);
-
-	unsigned int components  = (fourCC == FOURCC_DXT1) ? 3 : 4; 
 	unsigned int format;
 	switch(fourCC) 
 	{ 
@@ -178,6 +167,28 @@ GLuint loadDDS(const char * imagepath){
 		format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; 
 		break; 
 	default: 
+		fclose(fp); 
+		return 0; 
+	}
+	unsigned int blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16; 
+
+	/* how big is it going to be including all mipmaps? (linear size in the header covers only the first
+	   level and the rest isn't the same size again, so it's summed level by level, files without mipmaps
+	   may store 0 as the count) */ 
+	if (mipMapCount == 0) mipMapCount = 1;
+	unsigned int bufsize = 0;
+	for (unsigned int level = 0, w = width, h = height; level < mipMapCount; ++level) 
+	{ 
+		bufsize += ((w+3)/4)*((h+3)/4)*blockSize; 
+		w = w > 1 ? w / 2 : 1; 
+		h = h > 1 ? h / 2 : 1; 
+	} 
+	unsigned char * buffer = (unsigned char*)malloc(bufsize * sizeof(unsigned char)); 
+	size_t bytesRead = fread(buffer, 1, bufsize, fp); 
+	/* close the file pointer */ 
+	fclose(fp);
+	if (bytesRead != bufsize) {
+		printf("%s is truncated, %u bytes of mipmaps expected\n", imagepath, bufsize);
 		free(buffer); 
 		return 0; 
 	}
@@ -190,7 +201,6 @@ GLuint loadDDS(const char * imagepath){
 	glBindTexture(GL_TEXTURE_2D, textureID);
 	glPixelStorei(GL_UNPACK_ALIGNMENT,1);	
 	
-	unsigned int blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16; 
 	unsigned int offset = 0;
 
 	/* load the mipmaps */ 
@@ -0,0 +1,442 @@
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURECOMPRESSOR_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "textureCompressor.hpp"
+#include "parallel.hpp"
+
+namespace {
+
+// Pixels of one 4x4 block, one array per channel so that 4 pixels fill one SSE register
+struct BlockPixels
+{
+	alignas(16) float r[16];
+	alignas(16) float g[16];
+	alignas(16) float b[16];
+	alignas(16) float a[16];
+};
+
+// Reads 4x4 block at block coordinates (blockX, blockY), pixels outside of the image repeat the edge
+void fetchBlock(const unsigned char * pixels, int width, int height, int numComponents, int blockX, int blockY, BlockPixels & out_block)
+{
+	for (int y = 0; y < 4; y++) {
+		const int sourceY = std::min(blockY * 4 + y, height - 1);
+		for (int x = 0; x < 4; x++) {
+			const int sourceX = std::min(blockX * 4 + x, width - 1);
+			const unsigned char * source = pixels + (size_t(sourceY) * width + sourceX) * numComponents;
+			const int i = y * 4 + x;
+			if (numComponents <= 2) {
+				out_block.r[i] = out_block.g[i] = out_block.b[i] = source[0];
+				out_block.a[i] = numComponents == 2 ? source[1] : 255.0f;
+			}
+			else {
+				out_block.r[i] = source[0];
+				out_block.g[i] = source[1];
+				out_block.b[i] = source[2];
+				out_block.a[i] = numComponents == 4 ? source[3] : 255.0f;
+			}
+		}
+	}
+}
+
+void writeUint16(unsigned char * destination, unsigned int value)
+{
+	destination[0] = static_cast<unsigned char>(value);
+	destination[1] = static_cast<unsigned char>(value >> 8);
+}
+
+// ---------------------------------------------------------------------------------------------
+// BC1 color block: two RGB565 endpoints and 2-bit index per pixel into the 4 color palette
+// ---------------------------------------------------------------------------------------------
+
+unsigned int packRGB565(const float color[3])
+{
+	const int r = static_cast<int>(std::min(std::max(color[0], 0.0f), 255.0f) * (31.0f / 255.0f) + 0.5f);
+	const int g = static_cast<int>(std::min(std::max(color[1], 0.0f), 255.0f) * (63.0f / 255.0f) + 0.5f);
+	const int b = static_cast<int>(std::min(std::max(color[2], 0.0f), 255.0f) * (31.0f / 255.0f) + 0.5f);
+	return (r << 11) | (g << 5) | b;
+}
+
+void unpackRGB565(unsigned int packed, float out_color[3])
+{
+	const int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+	out_color[0] = float((r << 3) | (r >> 2));
+	out_color[1] = float((g << 2) | (g >> 4));
+	out_color[2] = float((b << 3) | (b >> 2));
+}
+
+// Chooses the nearest palette entry for every pixel, returns sum of squared errors
+float selectColorIndices(const BlockPixels & block, const float palette[4][3], unsigned char out_indices[16])
+{
+#ifdef TEXTURECOMPRESSOR_USE_SSE2
+	__m128 totalError = _mm_setzero_ps();
+	for (int i = 0; i < 16; i += 4) {
+		const __m128 r = _mm_load_ps(block.r + i), g = _mm_load_ps(block.g + i), b = _mm_load_ps(block.b + i);
+		__m128 bestError = _mm_set1_ps(1e30f);
+		__m128i bestIndex = _mm_setzero_si128();
+		for (int e = 0; e < 4; e++) {
+			const __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[e][0]));
+			const __m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[e][1]));
+			const __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[e][2]));
+			const __m128 error = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+			const __m128i isBetter = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+			bestError = _mm_min_ps(error, bestError);
+			bestIndex = _mm_or_si128(_mm_and_si128(isBetter, _mm_set1_epi32(e)), _mm_andnot_si128(isBetter, bestIndex));
+		}
+		totalError = _mm_add_ps(totalError, bestError);
+		alignas(16) int32_t indices[4];
+		_mm_store_si128(reinterpret_cast<__m128i *>(indices), bestIndex);
+		for (int j = 0; j < 4; j++)
+			out_indices[i + j] = static_cast<unsigned char>(indices[j]);
+	}
+	alignas(16) float errors[4];
+	_mm_store_ps(errors, totalError);
+	return errors[0] + errors[1] + errors[2] + errors[3];
+#else
+	float totalError = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		float bestError = 1e30f;
+		for (int e = 0; e < 4; e++) {
+			const float dr = block.r[i] - palette[e][0], dg = block.g[i] - palette[e][1], db = block.b[i] - palette[e][2];
+			const float error = dr * dr + dg * dg + db * db;
+			if (error < bestError) {
+				bestError = error;
+				out_indices[i] = static_cast<unsigned char>(e);
+			}
+		}
+		totalError += bestError;
+	}
+	return totalError;
+#endif
+}
+
+// Quantizes endpoints to 565 and picks indices, endpoints are ordered so that the block is in 4 color mode
+float encodeColorEndpoints(const BlockPixels & block, const float endpoint0[3], const float endpoint1[3], unsigned int & out_color0, unsigned int & out_color1, unsigned char out_indices[16])
+{
+	unsigned int color0 = packRGB565(endpoint0), color1 = packRGB565(endpoint1);
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	float palette[4][3];
+	unpackRGB565(color0, palette[0]);
+	unpackRGB565(color1, palette[1]);
+	for (int c = 0; c < 3; c++) {
+		palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+		palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+	}
+
+	out_color0 = color0;
+	out_color1 = color1;
+	if (color0 == color1) {
+		// Equal endpoints would switch the block to 3 color mode, where index 3 is transparent black
+		memset(out_indices, 0, 16);
+		float error = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			const float dr = block.r[i] - palette[0][0], dg = block.g[i] - palette[0][1], db = block.b[i] - palette[0][2];
+			error += dr * dr + dg * dg + db * db;
+		}
+		return error;
+	}
+	return selectColorIndices(block, palette, out_indices);
+}
+
+void boundingBoxEndpoints(const BlockPixels & block, float out_endpoint0[3], float out_endpoint1[3])
+{
+	const float * channels[3] = { block.r, block.g, block.b };
+	for (int c = 0; c < 3; c++) {
+#ifdef TEXTURECOMPRESSOR_USE_SSE2
+		__m128 minimum = _mm_load_ps(channels[c]), maximum = minimum;
+		for (int i = 4; i < 16; i += 4) {
+			minimum = _mm_min_ps(minimum, _mm_load_ps(channels[c] + i));
+			maximum = _mm_max_ps(maximum, _mm_load_ps(channels[c] + i));
+		}
+		alignas(16) float minimums[4], maximums[4];
+		_mm_store_ps(minimums, minimum);
+		_mm_store_ps(maximums, maximum);
+		float low = std::min(std::min(minimums[0], minimums[1]), std::min(minimums[2], minimums[3]));
+		float high = std::max(std::max(maximums[0], maximums[1]), std::max(maximums[2], maximums[3]));
+#else
+		float low = *std::min_element(channels[c], channels[c] + 16);
+		float high = *std::max_element(channels[c], channels[c] + 16);
+#endif
+		// Inset by 1/16 of the range, extremes are reproduced poorly by the interpolated colors anyway
+		const float inset = (high - low) / 16.0f;
+		out_endpoint0[c] = high - inset;
+		out_endpoint1[c] = low + inset;
+	}
+}
+
+void principalAxisEndpoints(const BlockPixels & block, float out_endpoint0[3], float out_endpoint1[3])
+{
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++) {
+		mean[0] += block.r[i];
+		mean[1] += block.g[i];
+		mean[2] += block.b[i];
+	}
+	for (int c = 0; c < 3; c++)
+		mean[c] /= 16.0f;
+
+	float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }; // rr, rg, rb, gg, gb, bb
+	for (int i = 0; i < 16; i++) {
+		const float r = block.r[i] - mean[0], g = block.g[i] - mean[1], b = block.b[i] - mean[2];
+		covariance[0] += r * r;
+		covariance[1] += r * g;
+		covariance[2] += r * b;
+		covariance[3] += g * g;
+		covariance[4] += g * b;
+		covariance[5] += b * b;
+	}
+
+	// Power iteration, starting from the bounding box diagonal
+	float boxHigh[3], boxLow[3];
+	boundingBoxEndpoints(block, boxHigh, boxLow);
+	float axis[3] = { boxHigh[0] - boxLow[0], boxHigh[1] - boxLow[1], boxHigh[2] - boxLow[2] };
+	for (int iteration = 0; iteration < 8; iteration++) {
+		const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+		const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+		const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+		const float length = std::max(std::max(fabsf(x), fabsf(y)), fabsf(z));
+		if (length <= 0.0f)
+			break;
+		axis[0] = x / length;
+		axis[1] = y / length;
+		axis[2] = z / length;
+	}
+	const float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	if (axisLength2 <= 0.0f) {
+		// Single color block
+		std::copy(mean, mean + 3, out_endpoint0);
+		std::copy(mean, mean + 3, out_endpoint1);
+		return;
+	}
+
+	float minimum = 1e30f, maximum = -1e30f;
+	for (int i = 0; i < 16; i++) {
+		const float t = ((block.r[i] - mean[0]) * axis[0] + (block.g[i] - mean[1]) * axis[1] + (block.b[i] - mean[2]) * axis[2]) / axisLength2;
+		minimum = std::min(minimum, t);
+		maximum = std::max(maximum, t);
+	}
+	// Same inset as for the bounding box
+	const float inset = (maximum - minimum) / 16.0f;
+	maximum -= inset;
+	minimum += inset;
+	for (int c = 0; c < 3; c++) {
+		out_endpoint0[c] = mean[c] + axis[c] * maximum;
+		out_endpoint1[c] = mean[c] + axis[c] * minimum;
+	}
+}
+
+// Endpoints minimizing squared error for the given indices (least squares, solved per channel), false if singular
+bool refineColorEndpoints(const BlockPixels & block, const unsigned char indices[16], float out_endpoint0[3], float out_endpoint1[3])
+{
+	// Weight of endpoint 0 for every palette entry
+	static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++) {
+		const float alpha = weights[indices[i]], beta = 1.0f - alpha;
+		const float pixel[3] = { block.r[i], block.g[i], block.b[i] };
+		aa += alpha * alpha;
+		ab += alpha * beta;
+		bb += beta * beta;
+		for (int c = 0; c < 3; c++) {
+			ax[c] += alpha * pixel[c];
+			bx[c] += beta * pixel[c];
+		}
+	}
+
+	const float determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f)
+		return false;
+	for (int c = 0; c < 3; c++) {
+		out_endpoint0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+		out_endpoint1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+	}
+	return true;
+}
+
+void encodeColorBlock(const BlockPixels & block, CompressionQuality quality, unsigned char * out_block)
+{
+	float endpoint0[3], endpoint1[3];
+	if (quality == CompressionQuality::Fast)
+		boundingBoxEndpoints(block, endpoint0, endpoint1);
+	else
+		principalAxisEndpoints(block, endpoint0, endpoint1);
+
+	unsigned int color0, color1;
+	unsigned char indices[16];
+	float error = encodeColorEndpoints(block, endpoint0, endpoint1, color0, color1, indices);
+
+	if (quality == CompressionQuality::High) {
+		for (int iteration = 0; iteration < 2; iteration++) {
+			// Indices are relative to the swapped endpoints, so the refined ones come out in the same order
+			float refined0[3], refined1[3];
+			if (!refineColorEndpoints(block, indices, refined0, refined1))
+				break;
+			unsigned int refinedColor0, refinedColor1;
+			unsigned char refinedIndices[16];
+			const float refinedError = encodeColorEndpoints(block, refined0, refined1, refinedColor0, refinedColor1, refinedIndices);
+			if (refinedError >= error)
+				break;
+			error = refinedError;
+			color0 = refinedColor0;
+			color1 = refinedColor1;
+			memcpy(indices, refinedIndices, sizeof(indices));
+		}
+	}
+
+	writeUint16(out_block, color0);
+	writeUint16(out_block + 2, color1);
+	uint32_t packedIndices = 0;
+	for (int i = 0; i < 16; i++)
+		packedIndices |= uint32_t(indices[i]) << (i * 2);
+	for (int i = 0; i < 4; i++)
+		out_block[4 + i] = static_cast<unsigned char>(packedIndices >> (i * 8));
+}
+
+// ---------------------------------------------------------------------------------------------
+// BC4 channel block: two 8-bit endpoints and 3-bit index per pixel into the 8 value ramp
+// ---------------------------------------------------------------------------------------------
+
+// Picks indices for endpoints high > low (8 value mode), returns sum of squared errors
+int selectChannelIndices(const float values[16], int high, int low, unsigned char out_indices[16])
+{
+	const float stepScale = 7.0f / (high - low);
+	int totalError = 0;
+	for (int i = 0; i < 16; i++) {
+		// Nearest of the 8 evenly spaced values, step 0 is low and step 7 is high
+		const int value = static_cast<int>(values[i]);
+		const int step = std::min(std::max(static_cast<int>((values[i] - low) * stepScale + 0.5f), 0), 7);
+		const int decoded = ((7 - step) * low + step * high) / 7;
+		totalError += (value - decoded) * (value - decoded);
+
+		// Index 0 is high, 1 is low, 2-7 go from high towards low
+		out_indices[i] = static_cast<unsigned char>(step == 7 ? 0 : step == 0 ? 1 : 8 - step);
+	}
+	return totalError;
+}
+
+void encodeChannelBlock(const float values[16], CompressionQuality quality, unsigned char * out_block)
+{
+	int low = 255, high = 0;
+	for (int i = 0; i < 16; i++) {
+		low = std::min(low, static_cast<int>(values[i]));
+		high = std::max(high, static_cast<int>(values[i]));
+	}
+
+	unsigned char indices[16];
+	if (high == low) {
+		memset(indices, 0, sizeof(indices));
+	}
+	else {
+		int error = selectChannelIndices(values, high, low, indices);
+		if (quality != CompressionQuality::Fast) {
+			// Endpoints moved inwards often fit the values in between better than the extremes
+			const int maxInset = quality == CompressionQuality::High ? 4 : 1;
+			const int range = std::min(maxInset, (high - low - 1) / 2);
+			int bestHigh = high, bestLow = low;
+			for (int highInset = 0; highInset <= range; highInset++) {
+				for (int lowInset = 0; lowInset <= range; lowInset++) {
+					unsigned char candidateIndices[16];
+					const int candidateError = selectChannelIndices(values, high - highInset, low + lowInset, candidateIndices);
+					if (candidateError < error) {
+						error = candidateError;
+						bestHigh = high - highInset;
+						bestLow = low + lowInset;
+					}
+				}
+			}
+			high = bestHigh;
+			low = bestLow;
+			selectChannelIndices(values, high, low, indices);
+		}
+	}
+
+	out_block[0] = static_cast<unsigned char>(high);
+	out_block[1] = static_cast<unsigned char>(low);
+	uint64_t packedIndices = 0;
+	for (int i = 0; i < 16; i++)
+		packedIndices |= uint64_t(indices[i]) << (i * 3);
+	for (int i = 0; i < 6; i++)
+		out_block[2 + i] = static_cast<unsigned char>(packedIndices >> (i * 8));
+}
+
+size_t getBlockSize(BlockFormat format)
+{
+	return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+} // namespace
+
+unsigned int getBlockFormatGLFormat(BlockFormat format)
+{
+	switch (format) {
+	case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+	case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+	}
+	return 0;
+}
+
+size_t getCompressedImageSize(int width, int height, BlockFormat format)
+{
+	return size_t((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+}
+
+BlockFormat getBlockFormatForComponents(int numComponents)
+{
+	switch (numComponents) {
+	case 1: return BlockFormat::BC4;
+	case 2: return BlockFormat::BC5;
+	case 3: return BlockFormat::BC1;
+	default: return BlockFormat::BC3;
+	}
+}
+
+void compressImage(
+	const unsigned char * pixels,
+	int width, int height, int numComponents,
+	BlockFormat format,
+	CompressionQuality quality,
+	unsigned char * out_blocks,
+	unsigned int numThreads
+){
+	const int numBlocksX = (width + 3) / 4;
+	const int numBlocksY = (height + 3) / 4;
+	const size_t blockSize = getBlockSize(format);
+
+	parallelForRanges(numBlocksY, numThreads, 4, [&](size_t firstRow, size_t lastRow) {
+		BlockPixels block;
+		for (size_t blockY = firstRow; blockY < lastRow; blockY++) {
+			unsigned char * output = out_blocks + blockY * numBlocksX * blockSize;
+			for (int blockX = 0; blockX < numBlocksX; blockX++, output += blockSize) {
+				fetchBlock(pixels, width, height, numComponents, blockX, static_cast<int>(blockY), block);
+				switch (format) {
+				case BlockFormat::BC1:
+					encodeColorBlock(block, quality, output);
+					break;
+				case BlockFormat::BC3:
+					encodeChannelBlock(block.a, quality, output);
+					encodeColorBlock(block, quality, output + 8);
+					break;
+				case BlockFormat::BC4:
+					encodeChannelBlock(block.r, quality, output);
+					break;
+				case BlockFormat::BC5:
+					// Gray + alpha images keep alpha in the second channel, same as uncompressed GL_RG
+					encodeChannelBlock(block.r, quality, output);
+					encodeChannelBlock(numComponents == 2 ? block.a : block.g, quality, output + 8);
+					break;
+				}
+			}
+		}
+	});
+}
@@ -0,0 +1,58 @@
+#ifndef TEXTURECOMPRESSOR_HPP
+#define TEXTURECOMPRESSOR_HPP
+
+#include <stddef.h>
+
+// Compressed formats, EXT_texture_compression_s3tc isn't part of core OpenGL
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RED_RGTC1
+#define GL_COMPRESSED_RED_RGTC1 0x8DBB
+#endif
+#ifndef GL_COMPRESSED_RG_RGTC2
+#define GL_COMPRESSED_RG_RGTC2 0x8DBD
+#endif
+
+// Block compressed formats, every 4x4 pixel block is encoded separately
+enum class BlockFormat
+{
+	BC1, // RGB, 8 bytes per block (DXT1)
+	BC3, // RGBA, 16 bytes per block (DXT5, alpha is encoded like BC4)
+	BC4, // Red channel only, 8 bytes per block (specular or height maps)
+	BC5, // Red and green channels, 16 bytes per block (tangent space normal maps)
+};
+
+// Time spent on choosing block endpoints
+enum class CompressionQuality
+{
+	Fast, // Endpoints from the bounding box of the block colors
+	Normal, // Endpoints along the principal axis of the block colors, channel endpoints moved inwards by up to 1
+	High, // Principal axis refined by least squares, channel endpoints moved inwards by up to 4
+};
+
+// OpenGL internal format of the compressed texture
+unsigned int getBlockFormatGLFormat(BlockFormat format);
+
+// Byte size of the compressed image (partial blocks at the edges count as whole blocks)
+size_t getCompressedImageSize(int width, int height, BlockFormat format);
+
+// Block format used for images with given number of components (BC4 for 1, BC5 for 2, BC1 for 3, BC3 for 4),
+// so that compressed textures are sampled the same way as uncompressed GL_RED / GL_RG / GL_RGB / GL_RGBA ones
+BlockFormat getBlockFormatForComponents(int numComponents);
+
+// Compresses 8-bit image with 1-4 interleaved components (gray, gray + alpha, RGB or RGBA) into blocks,
+// out_blocks must have getCompressedImageSize bytes. Rows of blocks are split between numThreads threads.
+void compressImage(
+	const unsigned char * pixels,
+	int width, int height, int numComponents,
+	BlockFormat format,
+	CompressionQuality quality,
+	unsigned char * out_blocks,
+	unsigned int numThreads = 1
+);
+
+#endif
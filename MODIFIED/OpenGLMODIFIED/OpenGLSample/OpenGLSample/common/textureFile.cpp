@@ -0,0 +1,233 @@
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// Project
+#include "textureFile.h"
+#include "fileUtils.h"
+#include "textureCompressor.hpp"
+
+const char TextureFile::MAGIC[4] = { 'T', 'E', 'X', 'R' };
+const uint32_t TextureFile::VERSION = 1;
+
+namespace {
+
+    // Offset rounded up to the multiple of 16 (so that level data in the mapped file are well aligned)
+    uint64_t alignOffset(uint64_t offset)
+    {
+        return (offset + 15) & ~uint64_t(15);
+    }
+
+    // Checks, if the current context exposes given extension
+    bool hasExtension(const char* name)
+    {
+        GLint numExtensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+        for (GLint i = 0; i < numExtensions; i++)
+        {
+            const auto extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+            if (extension != nullptr && strcmp(extension, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Byte size of a level with given dimensions in the format of the texture (0 for formats, that are never cooked)
+    uint64_t getLevelDataSize(const TextureFileHeader& header, uint32_t width, uint32_t height)
+    {
+        if (header.glFormat == 0)
+        {
+            const auto numBlocks = uint64_t((width + 3) / 4) * ((height + 3) / 4);
+            switch (header.glInternalFormat) {
+            case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_RED_RGTC1: return numBlocks * 8;
+            case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            case GL_COMPRESSED_RG_RGTC2: return numBlocks * 16;
+            default: return 0;
+            }
+        }
+
+        if (header.glType != GL_UNSIGNED_BYTE) {
+            return 0;
+        }
+        switch (header.glFormat) {
+        case GL_RED: return uint64_t(width) * height;
+        case GL_RG: return uint64_t(width) * height * 2;
+        case GL_RGB: return uint64_t(width) * height * 3;
+        case GL_RGBA: return uint64_t(width) * height * 4;
+        default: return 0;
+        }
+    }
+
+} // namespace
+
+bool TextureFile::open(const char* path)
+{
+    close();
+    if (!_file.open(path)) {
+        return false;
+    }
+
+    // Header must be complete, before any of its fields is read
+    const auto size = _file.getSize();
+    if (size < sizeof(TextureFileHeader))
+    {
+        _file.close();
+        return false;
+    }
+
+    // Header must describe levels, that are really present in the file
+    const auto header = reinterpret_cast<const TextureFileHeader*>(_file.getData());
+    auto isValid = memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+        && header->version == VERSION
+        && header->numLevels > 0 && header->numLevels <= TextureFileHeader::MAX_LEVELS
+        && header->width > 0 && header->height > 0;
+
+    for (uint32_t i = 0; isValid && i < header->numLevels; i++)
+    {
+        const auto& level = header->levels[i];
+        isValid = level.dataOffset >= sizeof(TextureFileHeader)
+            && level.dataOffset <= size && level.dataSize <= size - level.dataOffset
+            && level.width == std::max(header->width >> i, 1u)
+            && level.height == std::max(header->height >> i, 1u)
+            && level.dataSize == getLevelDataSize(*header, level.width, level.height) && level.dataSize > 0;
+    }
+
+    if (!isValid)
+    {
+        _file.close();
+        return false;
+    }
+
+    _header = header;
+    return true;
+}
+
+void TextureFile::close()
+{
+    _header = nullptr;
+    _file.close();
+}
+
+const TextureFileHeader& TextureFile::getHeader() const
+{
+    return *_header;
+}
+
+const void* TextureFile::getLevelData(uint32_t level) const
+{
+    return _file.getData() + _header->levels[level].dataOffset;
+}
+
+size_t TextureFile::getDataSize() const
+{
+    size_t dataSize = 0;
+    for (uint32_t i = 0; i < _header->numLevels; i++) {
+        dataSize += size_t(_header->levels[i].dataSize);
+    }
+    return dataSize;
+}
+
+bool TextureFile::isSupported() const
+{
+    return _header->glFormat != 0 || isFormatSupported(_header->glInternalFormat);
+}
+
+bool TextureFile::upload() const
+{
+    if (!isSupported()) {
+        return false;
+    }
+
+    // Rows of cooked levels are tightly packed
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (uint32_t i = 0; i < _header->numLevels; i++)
+    {
+        const auto& level = _header->levels[i];
+        if (_header->glFormat == 0) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, _header->glInternalFormat, level.width, level.height, 0, GLsizei(level.dataSize), getLevelData(i));
+        }
+        else {
+            glTexImage2D(GL_TEXTURE_2D, i, _header->glInternalFormat, level.width, level.height, 0, _header->glFormat, _header->glType, getLevelData(i));
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Texture is complete with the stored levels, even if the chain doesn't go down to 1x1
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, _header->numLevels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _header->numLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    return true;
+}
+
+bool TextureFile::isFormatSupported(uint32_t glInternalFormat)
+{
+    if (glInternalFormat != GL_COMPRESSED_RGB_S3TC_DXT1_EXT && glInternalFormat != GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) {
+        return true;
+    }
+
+    // Extensions don't change during the lifetime of the (only) context
+    static const auto isS3TCSupported = hasExtension("GL_EXT_texture_compression_s3tc");
+    return isS3TCSupported;
+}
+
+bool TextureFile::isUpToDate(const char* texturePath, const char* sourcePath)
+{
+    TextureFile textureFile;
+    if (!textureFile.open(texturePath)) {
+        return false;
+    }
+
+    FileInfo recordedInfo;
+    const auto& header = textureFile.getHeader();
+    recordedInfo.hash = header.sourceHash;
+    recordedInfo.modificationTime = header.sourceModificationTime;
+    recordedInfo.size = header.sourceSize;
+    textureFile.close();
+    return isBuiltFromCurrentSource(texturePath, offsetof(TextureFileHeader, sourceModificationTime), recordedInfo, sourcePath);
+}
+
+bool TextureFile::write(const char* path, TextureFileHeader header, const void* const* levelData)
+{
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    auto offset = alignOffset(sizeof(TextureFileHeader));
+    for (uint32_t i = 0; i < header.numLevels; i++)
+    {
+        header.levels[i].dataOffset = offset;
+        offset = alignOffset(offset + header.levels[i].dataSize);
+    }
+
+    const auto file = fopen(path, "wb");
+    if (file == nullptr)
+    {
+        std::cerr << "Could not open texture file " << path << " for writing!" << std::endl;
+        return false;
+    }
+
+    // Padding before every level is written as zeros
+    const char zeros[16] = {};
+    auto isWritten = fwrite(&header, sizeof(TextureFileHeader), 1, file) == 1;
+    uint64_t position = sizeof(TextureFileHeader);
+    for (uint32_t i = 0; isWritten && i < header.numLevels; i++)
+    {
+        const auto& level = header.levels[i];
+        const auto paddingSize = size_t(level.dataOffset - position);
+        isWritten = fwrite(zeros, 1, paddingSize, file) == paddingSize
+            && fwrite(levelData[i], 1, size_t(level.dataSize), file) == level.dataSize;
+        position = level.dataOffset + level.dataSize;
+    }
+
+    if (fclose(file) != 0 || !isWritten)
+    {
+        std::cerr << "Could not write texture file " << path << "!" << std::endl;
+        remove(path);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+// STL
+#include <cstdint>
+
+// GLAD
+#include <glad/glad.h>
+
+// Project
+#include "mappedFile.h"
+
+/**
+ * Description of one mipmap level stored in the texture file.
+ */
+struct TextureFileLevel
+{
+    uint64_t dataOffset; // Byte offset of the level data from the start of the file
+    uint64_t dataSize; // Byte size of the level data
+    uint32_t width; // Width of the level
+    uint32_t height; // Height of the level
+};
+
+/**
+ * Header of the cooked texture file. File consists of this header and data of all mipmap levels
+ * (largest first), every level stored exactly as it is uploaded to the GPU - tightly packed rows
+ * of uncompressed pixels (glFormat/glType) or compressed blocks (glFormat is 0).
+ */
+struct TextureFileHeader
+{
+    static const uint32_t MAX_LEVELS = 16; // Enough for textures up to 32768x32768
+    static const uint32_t SRGB_FILTERED = 1; // Flag telling, that mipmaps were filtered in linear space
+
+    char magic[4]; // Always TextureFile::MAGIC
+    uint32_t version; // Version of the format, files with other version than TextureFile::VERSION are cooked again
+    uint64_t sourceHash; // Hash of the contents of the source image, the texture was cooked from
+    int64_t sourceModificationTime; // Modification time of the source image (seconds since epoch)
+    uint64_t sourceSize; // Size of the source image (in bytes)
+
+    uint32_t width; // Width of the base level
+    uint32_t height; // Height of the base level
+    uint32_t numLevels; // Number of stored mipmap levels
+    uint32_t numComponents; // Number of color components of the source image (1-4)
+    uint32_t glInternalFormat; // Internal format of the texture
+    uint32_t glFormat; // Pixel format of uncompressed data (0 for compressed data)
+    uint32_t glType; // Pixel type of uncompressed data (0 for compressed data)
+    uint32_t flags; // Combination of SRGB_FILTERED
+
+    TextureFileLevel levels[MAX_LEVELS]; // Stored mipmap levels (only first numLevels are valid)
+};
+
+static_assert(sizeof(TextureFileHeader) == 64 + 24 * TextureFileHeader::MAX_LEVELS, "TextureFileHeader must not contain implicit padding");
+
+/**
+ * Cooked texture file loaded by memory mapping. Mipmap levels point directly to the mapped file
+ * and are uploaded as they are, no decoding or mipmap generation is done when loading.
+ */
+class TextureFile
+{
+public:
+    static const char MAGIC[4]; // Magic number at the start of every texture file ("TEXR")
+    static const uint32_t VERSION; // Current version of the format
+
+    /**
+     * Maps given texture file and validates its header. Every level must have the size given by its
+     * dimensions and the format (GL_UNSIGNED_BYTE pixels or BC1/BC3/BC4/BC5 blocks).
+     *
+     * @param path  Path to the texture file
+     *
+     * @return True, if the file is a valid texture file of the current version.
+     */
+    bool open(const char* path);
+
+    /**
+     * Unmaps the texture file (all data pointers become invalid).
+     */
+    void close();
+
+    /**
+     * Gets header of the opened texture file.
+     */
+    const TextureFileHeader& getHeader() const;
+
+    /**
+     * Gets pointer to the data of given mipmap level.
+     */
+    const void* getLevelData(uint32_t level) const;
+
+    /**
+     * Gets byte size of all mipmap levels together.
+     */
+    size_t getDataSize() const;
+
+    /**
+     * Checks, if the current OpenGL context can sample the texture (OpenGL thread only).
+     */
+    bool isSupported() const;
+
+    /**
+     * Uploads all mipmap levels into the currently bound GL_TEXTURE_2D and sets up trilinear filtering.
+     *
+     * @return False (and nothing is uploaded), if the texture is not supported (see isSupported).
+     */
+    bool upload() const;
+
+    /**
+     * Checks, if the current OpenGL context can sample textures with given internal format. BC4 and BC5
+     * are core, BC1 and BC3 need EXT_texture_compression_s3tc (OpenGL thread only).
+     */
+    static bool isFormatSupported(uint32_t glInternalFormat);
+
+    /**
+     * Checks, if texture file at given path was cooked from the current version of the source image
+     * (see isBuiltFromCurrentSource).
+     *
+     * @param texturePath  Path to the texture file
+     * @param sourcePath   Path to the source image
+     */
+    static bool isUpToDate(const char* texturePath, const char* sourcePath);
+
+    /**
+     * Writes texture file. Data offsets of the levels in the header are filled in automatically.
+     *
+     * @param path       Path to the written texture file
+     * @param header     Header of the texture (description of the levels and the source image)
+     * @param levelData  Data of every level (levels[i].dataSize bytes each)
+     *
+     * @return True, if the file has been written successfully.
+     */
+    static bool write(const char* path, TextureFileHeader header, const void* const* levelData);
+
+private:
+    MappedFile _file; // Mapped texture file
+    const TextureFileHeader* _header = nullptr; // Header of the mapped texture file (nullptr if none is opened)
+};
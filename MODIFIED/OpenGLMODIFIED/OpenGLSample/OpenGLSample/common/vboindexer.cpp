@@ -0,0 +1,293 @@
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include <glm/glm.hpp>
+
+#include "vboindexer.hpp"
+
+namespace {
+
+// One attribute array of the indexed vertices (all positions, all UVs...) seen as flat floats,
+// so that attributes are streamed straight from the input arrays without building per-vertex structs
+struct WeldedAttribute
+{
+	const float * data;
+	int numComponents;
+};
+
+const unsigned int EMPTY_SLOT = 0xFFFFFFFF;
+
+// Welds vertices given by their attribute arrays using open addressing hash table with linear probing.
+// Table is sized for the worst case (all vertices unique) upfront, so it never has to grow.
+class VertexWelder
+{
+public:
+	VertexWelder(const WeldedAttribute * attributes, int numAttributes, float epsilon)
+		: _attributes(attributes)
+		, _numAttributes(numAttributes)
+		, _inverseEpsilon(epsilon > 0.0f ? 1.0 / epsilon : 0.0)
+	{
+	}
+
+	// Fills index of the merged vertex for every input vertex and input index of every merged vertex
+	bool weld(size_t numVertices, std::vector<unsigned int> & out_indices, std::vector<unsigned int> & out_sources) const
+	{
+		if (numVertices >= EMPTY_SLOT) {
+			printf("Can't index %zu vertices, there are too many of them\n", numVertices);
+			return false;
+		}
+
+		size_t capacity = 16;
+		while (capacity < numVertices + numVertices / 2)
+			capacity <<= 1;
+		const size_t mask = capacity - 1;
+		std::vector<unsigned int> slots(capacity, EMPTY_SLOT);
+		std::vector<uint32_t> slotHashes(capacity);
+
+		out_indices.resize(numVertices);
+		out_sources.clear();
+		for (size_t i = 0; i < numVertices; i++) {
+			const uint32_t hash = hashVertex(i);
+			for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+				const unsigned int mergedIndex = slots[slot];
+				if (mergedIndex == EMPTY_SLOT) {
+					// First vertex with these attributes
+					slots[slot] = static_cast<unsigned int>(out_sources.size());
+					slotHashes[slot] = hash;
+					out_indices[i] = slots[slot];
+					out_sources.push_back(static_cast<unsigned int>(i));
+					break;
+				}
+				if (slotHashes[slot] == hash && areVerticesEqual(out_sources[mergedIndex], i)) {
+					out_indices[i] = mergedIndex;
+					break;
+				}
+			}
+		}
+
+		return true;
+	}
+
+private:
+	const WeldedAttribute * _attributes;
+	int _numAttributes;
+	double _inverseEpsilon; // 0 for bitwise comparison
+
+	// Integer key of one attribute component, equal keys mean equal components
+	uint64_t quantize(float value) const
+	{
+		if (_inverseEpsilon > 0.0) {
+			const double cell = floor(value * _inverseEpsilon + 0.5);
+			return static_cast<uint64_t>(static_cast<int64_t>(fmax(fmin(cell, 9.0e18), -9.0e18)));
+		}
+
+		value += 0.0f; // -0 becomes +0
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	uint32_t hashVertex(size_t vertex) const
+	{
+		uint64_t hash = 0;
+		for (int a = 0; a < _numAttributes; a++) {
+			const float * components = _attributes[a].data + vertex * _attributes[a].numComponents;
+			for (int c = 0; c < _attributes[a].numComponents; c++) {
+				hash = (hash ^ quantize(components[c])) * 0x9E3779B97F4A7C15ULL;
+				hash ^= hash >> 29;
+			}
+		}
+		return static_cast<uint32_t>(hash ^ (hash >> 32));
+	}
+
+	bool areVerticesEqual(size_t a, size_t b) const
+	{
+		for (int i = 0; i < _numAttributes; i++) {
+			const int numComponents = _attributes[i].numComponents;
+			const float * componentsA = _attributes[i].data + a * numComponents;
+			const float * componentsB = _attributes[i].data + b * numComponents;
+			for (int c = 0; c < numComponents; c++) {
+				if (quantize(componentsA[c]) != quantize(componentsB[c]))
+					return false;
+			}
+		}
+		return true;
+	}
+};
+
+template <typename T>
+void gatherVertices(const std::vector<T> & in_data, const std::vector<unsigned int> & sources, std::vector<T> & out_data)
+{
+	out_data.resize(sources.size());
+	for (size_t i = 0; i < sources.size(); i++)
+		out_data[i] = in_data[sources[i]];
+}
+
+bool weldVertices(
+	const std::vector<glm::vec3> & in_vertices,
+	const std::vector<glm::vec2> & in_uvs,
+	const std::vector<glm::vec3> & in_normals,
+	float epsilon,
+	std::vector<unsigned int> & out_indices,
+	std::vector<unsigned int> & out_sources
+){
+	if (in_uvs.size() != in_vertices.size() || in_normals.size() != in_vertices.size()) {
+		printf("Can't index vertices, numbers of vertices, UVs and normals differ\n");
+		return false;
+	}
+
+	const WeldedAttribute attributes[] = {
+		{ in_vertices.empty() ? nullptr : &in_vertices[0].x, 3 },
+		{ in_uvs.empty() ? nullptr : &in_uvs[0].x, 2 },
+		{ in_normals.empty() ? nullptr : &in_normals[0].x, 3 },
+	};
+	const VertexWelder welder(attributes, 3, epsilon);
+	return welder.weld(in_vertices.size(), out_indices, out_sources);
+}
+
+void sumMergedVectors(const std::vector<glm::vec3> & in_data, const std::vector<unsigned int> & indices, size_t numMerged, std::vector<glm::vec3> & out_data)
+{
+	out_data.assign(numMerged, glm::vec3(0.0f));
+	for (size_t i = 0; i < indices.size(); i++)
+		out_data[indices[i]] += in_data[i];
+}
+
+} // namespace
+
+bool shortenIndices(
+	const std::vector<unsigned int> & indices,
+	std::vector<unsigned short> & out_indices
+){
+	for (size_t i = 0; i < indices.size(); i++) {
+		if (indices[i] >= 0xFFFF) {
+			printf("Index %u doesn't fit into 16 bits\n", indices[i]);
+			return false;
+		}
+	}
+
+	out_indices.assign(indices.begin(), indices.end());
+	return true;
+}
+
+bool indexVBO(
+	const std::vector<glm::vec3> & in_vertices,
+	const std::vector<glm::vec2> & in_uvs,
+	const std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+
+	float epsilon
+){
+	std::vector<unsigned int> sources;
+	if (!weldVertices(in_vertices, in_uvs, in_normals, epsilon, out_indices, sources))
+		return false;
+
+	gatherVertices(in_vertices, sources, out_vertices);
+	gatherVertices(in_uvs, sources, out_uvs);
+	gatherVertices(in_normals, sources, out_normals);
+	return true;
+}
+
+bool indexVBO(
+	const std::vector<glm::vec3> & in_vertices,
+	const std::vector<glm::vec2> & in_uvs,
+	const std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+
+	float epsilon
+){
+	std::vector<unsigned int> indices, sources;
+	if (!weldVertices(in_vertices, in_uvs, in_normals, epsilon, indices, sources))
+		return false;
+	if (sources.size() >= 0xFFFF) {
+		printf("Indexed mesh has %zu vertices, which is too many for 16-bit indices\n", sources.size());
+		return false;
+	}
+
+	shortenIndices(indices, out_indices);
+	gatherVertices(in_vertices, sources, out_vertices);
+	gatherVertices(in_uvs, sources, out_uvs);
+	gatherVertices(in_normals, sources, out_normals);
+	return true;
+}
+
+bool indexVBO_TBN(
+	const std::vector<glm::vec3> & in_vertices,
+	const std::vector<glm::vec2> & in_uvs,
+	const std::vector<glm::vec3> & in_normals,
+	const std::vector<glm::vec3> & in_tangents,
+	const std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents,
+
+	float epsilon
+){
+	if (in_tangents.size() != in_vertices.size() || in_bitangents.size() != in_vertices.size()) {
+		printf("Can't index vertices, numbers of vertices, tangents and bitangents differ\n");
+		return false;
+	}
+
+	std::vector<unsigned int> sources;
+	if (!weldVertices(in_vertices, in_uvs, in_normals, epsilon, out_indices, sources))
+		return false;
+
+	gatherVertices(in_vertices, sources, out_vertices);
+	gatherVertices(in_uvs, sources, out_uvs);
+	gatherVertices(in_normals, sources, out_normals);
+	sumMergedVectors(in_tangents, out_indices, sources.size(), out_tangents);
+	sumMergedVectors(in_bitangents, out_indices, sources.size(), out_bitangents);
+	return true;
+}
+
+bool indexVBO_TBN(
+	const std::vector<glm::vec3> & in_vertices,
+	const std::vector<glm::vec2> & in_uvs,
+	const std::vector<glm::vec3> & in_normals,
+	const std::vector<glm::vec3> & in_tangents,
+	const std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents,
+
+	float epsilon
+){
+	if (in_tangents.size() != in_vertices.size() || in_bitangents.size() != in_vertices.size()) {
+		printf("Can't index vertices, numbers of vertices, tangents and bitangents differ\n");
+		return false;
+	}
+
+	std::vector<unsigned int> indices, sources;
+	if (!weldVertices(in_vertices, in_uvs, in_normals, epsilon, indices, sources))
+		return false;
+	if (sources.size() >= 0xFFFF) {
+		printf("Indexed mesh has %zu vertices, which is too many for 16-bit indices\n", sources.size());
+		return false;
+	}
+
+	shortenIndices(indices, out_indices);
+	gatherVertices(in_vertices, sources, out_vertices);
+	gatherVertices(in_uvs, sources, out_uvs);
+	gatherVertices(in_normals, sources, out_normals);
+	sumMergedVectors(in_tangents, indices, sources.size(), out_tangents);
+	sumMergedVectors(in_bitangents, indices, sources.size(), out_bitangents);
+	return true;
+}
@@ -1,31 +1,81 @@
 #ifndef VBOINDEXER_HPP
 #define VBOINDEXER_HPP
 
-void indexVBO(
-	std::vector<glm::vec3> & in_vertices,
-	std::vector<glm::vec2> & in_uvs,
-	std::vector<glm::vec3> & in_normals,
+// Merges identical vertices of a triangle soup and produces indices into the merged vertices.
+// With epsilon 0 only bitwise equal vertices are merged (-0 and +0 are considered equal), with positive
+// epsilon all attributes are snapped to a grid with cells of that size and vertices in the same cell are merged
+// (the first vertex of the cell is kept). Runs in linear time. Output arrays are overwritten.
+//
+// 32-bit version handles any number of vertices. 16-bit version returns false (and leaves outputs untouched)
+// if the merged mesh has 65535 or more vertices, as index 0xFFFF is reserved for primitive restart.
+bool indexVBO(
+	const std::vector<glm::vec3> & in_vertices,
+	const std::vector<glm::vec2> & in_uvs,
+	const std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+
+	float epsilon = 0.0f
+);
+
+bool indexVBO(
+	const std::vector<glm::vec3> & in_vertices,
+	const std::vector<glm::vec2> & in_uvs,
+	const std::vector<glm::vec3> & in_normals,
 
 	std::vector<unsigned short> & out_indices,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals
+	std::vector<glm::vec3> & out_normals,
+
+	float epsilon = 0.0f
 );
 
 
-void indexVBO_TBN(
-	std::vector<glm::vec3> & in_vertices,
-	std::vector<glm::vec2> & in_uvs,
-	std::vector<glm::vec3> & in_normals,
-	std::vector<glm::vec3> & in_tangents,
-	std::vector<glm::vec3> & in_bitangents,
+// Same as indexVBO, tangents and bitangents of merged vertices are summed up
+bool indexVBO_TBN(
+	const std::vector<glm::vec3> & in_vertices,
+	const std::vector<glm::vec2> & in_uvs,
+	const std::vector<glm::vec3> & in_normals,
+	const std::vector<glm::vec3> & in_tangents,
+	const std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents,
+
+	float epsilon = 0.0f
+);
+
+bool indexVBO_TBN(
+	const std::vector<glm::vec3> & in_vertices,
+	const std::vector<glm::vec2> & in_uvs,
+	const std::vector<glm::vec3> & in_normals,
+	const std::vector<glm::vec3> & in_tangents,
+	const std::vector<glm::vec3> & in_bitangents,
 
 	std::vector<unsigned short> & out_indices,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
 	std::vector<glm::vec3> & out_normals,
 	std::vector<glm::vec3> & out_tangents,
-	std::vector<glm::vec3> & out_bitangents
+	std::vector<glm::vec3> & out_bitangents,
+
+	float epsilon = 0.0f
+);
+
+
+// Converts 32-bit indices to 16-bit ones, returns false (and leaves output untouched) if some index doesn't fit
+// (is 0xFFFF or larger, 0xFFFF being the primitive restart index)
+bool shortenIndices(
+	const std::vector<unsigned int> & indices,
+	std::vector<unsigned short> & out_indices
 );
 
-#endif
\ No newline at end of file
+#endif
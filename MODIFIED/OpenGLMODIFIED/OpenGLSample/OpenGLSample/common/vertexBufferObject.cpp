@@ -1,9 +1,11 @@
 // STL
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 
 // Project
 #include "vertexBufferObject.h"
+#include "glState.h"
 
 void VertexBufferObject::createVBO(size_t reserveSizeBytes)
 {
@@ -14,9 +16,9 @@ void VertexBufferObject::createVBO(size_t reserveSizeBytes)
     }
 
     glGenBuffers(1, &_bufferID);
-    _rawData.reserve(reserveSizeBytes > 0 ? reserveSizeBytes : 1024);
+    reserveBytes(reserveSizeBytes > 0 ? reserveSizeBytes : 1024);
 
-    std::cout << "Created vertex buffer object with ID " << _bufferID << " and initial reserved size " << _rawData.capacity() << " bytes" << std::endl;
+    std::cout << "Created vertex buffer object with ID " << _bufferID << " and initial reserved size " << _capacity << " bytes" << std::endl;
     _isBufferCreated = true;
 }
 
@@ -29,31 +31,72 @@ void VertexBufferObject::bindVBO(GLenum bufferType)
     }
 
     _bufferType = bufferType;
-    glBindBuffer(_bufferType, _bufferID);
+    GLState::bindBuffer(_bufferType, _bufferID);
 }
 
-void VertexBufferObject::addRawData(const void* ptrData, size_t dataSize, int repeat)
+void VertexBufferObject::reserveBytes(size_t totalSizeBytes)
 {
-    const auto bytesToAdd = dataSize * repeat;
-    if (_bytesAdded + bytesToAdd > _rawData.capacity())
+    if (totalSizeBytes <= _capacity) {
+        return;
+    }
+
+    std::unique_ptr<unsigned char[]> newRawData(new unsigned char[totalSizeBytes]);
+    if (_bytesAdded > 0) {
+        memcpy(newRawData.get(), _rawData.get(), _bytesAdded);
+    }
+
+    if (_rawData) {
+        _stagingStats.reallocations++;
+    }
+
+    _rawData = std::move(newRawData);
+    _capacity = totalSizeBytes;
+}
+
+void VertexBufferObject::reserveVertices(size_t numVertices, size_t vertexByteSize)
+{
+    reserveBytes(_bytesAdded + numVertices * vertexByteSize);
+}
+
+void* VertexBufferObject::allocateRawData(size_t dataSizeBytes)
+{
+    const auto requiredBytes = _bytesAdded + dataSizeBytes;
+    if (requiredBytes > _capacity)
     {
-        const auto newCapacity = _rawData.capacity() * 2;
-        std::vector<unsigned char> newRawData;
-        newRawData.reserve(newCapacity);
-        memcpy(newRawData.data(), _rawData.data(), _bytesAdded);
-        _rawData = std::move(newRawData);
+        // Grow geometrically, so that adding data stays amortized O(1), but always enough to satisfy whole request
+        reserveBytes(std::max(std::max(_capacity * 2, size_t(1024)), requiredBytes));
+    }
+
+    auto result = _rawData.get() + _bytesAdded;
+    _bytesAdded = requiredBytes;
+    _stagingStats.bytesStaged += dataSizeBytes;
+    _stagingStats.peakBytes = std::max(_stagingStats.peakBytes, _bytesAdded);
+    return result;
+}
+
+void VertexBufferObject::addRawData(const void* ptrData, size_t dataSize, int repeat)
+{
+    if (dataSize == 0 || repeat <= 0) {
+        return;
     }
 
-    for (int i = 0; i < repeat; i++)
+    const auto bytesToAdd = dataSize * repeat;
+    auto destination = static_cast<unsigned char*>(allocateRawData(bytesToAdd));
+    memcpy(destination, ptrData, dataSize);
+
+    // Repeated data are filled by doubling the already copied part, so it takes only log(repeat) copies
+    auto bytesFilled = dataSize;
+    while (bytesFilled < bytesToAdd)
     {
-        memcpy(_rawData.data() + _bytesAdded, ptrData, dataSize);
-        _bytesAdded += dataSize;
+        const auto bytesToCopy = std::min(bytesFilled, bytesToAdd - bytesFilled);
+        memcpy(destination + bytesFilled, destination, bytesToCopy);
+        bytesFilled += bytesToCopy;
     }
 }
 
 void* VertexBufferObject::getRawDataPointer()
 {
-    return _rawData.data();
+    return _rawData.get();
 }
 
 void VertexBufferObject::uploadDataToGPU(GLenum usageHint)
@@ -64,12 +107,25 @@ void VertexBufferObject::uploadDataToGPU(GLenum usageHint)
         return;
     }
 
-    glBufferData(_bufferType, _bytesAdded, _rawData.data(), usageHint);
+    glBufferData(_bufferType, _bytesAdded, _rawData.get(), usageHint);
     _isDataUploaded = true;
     _uploadedDataSize = _bytesAdded;
     _bytesAdded = 0;
 }
 
+void VertexBufferObject::uploadDataToGPU(const void* ptrData, size_t dataSizeBytes, GLenum usageHint)
+{
+    if (!_isBufferCreated)
+    {
+        std::cerr << "This buffer is not created yet! Call createVBO before uploading data to GPU!" << std::endl;
+        return;
+    }
+
+    glBufferData(_bufferType, dataSizeBytes, ptrData, usageHint);
+    _isDataUploaded = true;
+    _uploadedDataSize = dataSizeBytes;
+}
+
 void* VertexBufferObject::mapBufferToMemory(GLenum usageHint)
 {
     if (!_isDataUploaded)
@@ -105,6 +161,11 @@ size_t VertexBufferObject::getBufferSize()
     return _isDataUploaded ? _uploadedDataSize : _bytesAdded;
 }
 
+const VertexBufferObject::StagingStats& VertexBufferObject::getStagingStats() const
+{
+    return _stagingStats;
+}
+
 void VertexBufferObject::deleteVBO()
 {
     if (!_isBufferCreated) {
@@ -112,7 +173,10 @@ void VertexBufferObject::deleteVBO()
     }
 
     std::cout << "Deleting vertex buffer object with ID " << _bufferID << "..." << std::endl;
-    glDeleteBuffers(1, &_bufferID);
+    GLState::deleteBuffers(1, &_bufferID);
+    _rawData.reset();
+    _capacity = 0;
+    _bytesAdded = 0;
     _isDataUploaded = false;
     _isBufferCreated = false;
 }
@@ -1,7 +1,7 @@
 #pragma once
 
 // STL
-#include <vector>
+#include <memory>
 
 // GLAD
 #include <glad/glad.h>
@@ -12,6 +12,16 @@
 class VertexBufferObject
 {
 public:
+    /**
+     * Statistics of the in-memory staging buffer.
+     */
+    struct StagingStats
+    {
+        size_t bytesStaged = 0; // Total number of bytes added to the staging buffer
+        size_t reallocations = 0; // How many times the staging buffer had to grow
+        size_t peakBytes = 0; // Largest amount of bytes held by the staging buffer at once
+    };
+
     /**
      * Creates a new VBO, with optional reserved buffer size.
      *
@@ -19,6 +29,21 @@ public:
      */
     void createVBO(size_t reserveSizeBytes = 0);
 
+    /**
+     * Makes sure, that in-memory buffer can hold given number of bytes in total without reallocating.
+     *
+     * @param totalSizeBytes  Total size of data that will be added (including data already added), in bytes
+     */
+    void reserveBytes(size_t totalSizeBytes);
+
+    /**
+     * Makes sure, that given number of vertices more can be added without reallocating.
+     *
+     * @param numVertices     Number of vertices that will be added
+     * @param vertexByteSize  Byte size of one vertex (all its attributes)
+     */
+    void reserveVertices(size_t numVertices, size_t vertexByteSize);
+
     /**
      * Binds this vertex buffer object (makes current).
      *
@@ -35,6 +60,15 @@ public:
      */
     void addRawData(const void* ptrData, size_t dataSizeBytes, int repeat = 1);
 
+    /**
+     * Reserves space for raw data in the in-memory buffer and returns pointer to it, so that data can be written in place.
+     *
+     * @param dataSizeBytes  Size of the space to reserve (in bytes)
+     *
+     * @return Pointer to the reserved space, valid until next data is added.
+     */
+    void* allocateRawData(size_t dataSizeBytes);
+
     /**
      * Adds arbitrary data to the in-memory buffer, before they get uploaded.
      *
@@ -59,6 +93,16 @@ public:
      */
     void uploadDataToGPU(GLenum usageHint);
 
+    /**
+     * Uploads given data straight to the GPU memory, bypassing the in-memory buffer (no copy is made).
+     * Useful when data are already laid out in memory, e.g. in a memory mapped file.
+     *
+     * @param ptrData        Pointer to the raw data
+     * @param dataSizeBytes  Size of the data (in bytes)
+     * @param usageHint      Hint for OpenGL, how is the data intended to be used (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
+     */
+    void uploadDataToGPU(const void* ptrData, size_t dataSizeBytes, GLenum usageHint);
+
     /**
      * Maps buffer data to a memory pointer.
      * 
@@ -94,6 +138,11 @@ public:
      */
     size_t getBufferSize();
 
+    /**
+     * Gets statistics of the in-memory staging buffer.
+     */
+    const StagingStats& getStagingStats() const;
+
     /**
      * Deletes VBO and frees memory and internal structures.
      */
@@ -103,8 +152,10 @@ private:
     GLuint _bufferID = 0; // OpenGL assigned buffer ID
     int _bufferType; // Buffer type (GL_ARRAY_BUFFER, GL_ELEMENT_BUFFER...)
 
-    std::vector<unsigned char> _rawData; // In-memory raw data buffer, used to gather the data for VBO.
+    std::unique_ptr<unsigned char[]> _rawData; // In-memory raw data buffer, used to gather the data for VBO.
+    size_t _capacity = 0; // Capacity of the in-memory buffer (in bytes)
     size_t _bytesAdded = 0; // Number of bytes added to the buffer so far
+    StagingStats _stagingStats; // Statistics of the in-memory buffer
     size_t _uploadedDataSize; // Holds buffer data size after uploading to GPU
 
     bool _isBufferCreated = false; // Flag telling if the buffer has been created
@@ -0,0 +1,93 @@
+// STL
+#include <algorithm>
+
+// Project
+#include "workerPool.h"
+
+WorkerPool::WorkerPool(unsigned int numThreads)
+{
+    if (numThreads == ALL_HARDWARE_THREADS) {
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (unsigned int i = 1; i < numThreads; i++) {
+        _workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isStopping = true;
+    }
+    _workCondition.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::run(size_t count, const std::function<void(size_t)>& function)
+{
+    // Waking workers isn't worth it for a single call
+    if (_workers.empty() || count <= 1)
+    {
+        for (size_t i = 0; i < count; i++) {
+            function(i);
+        }
+        return;
+    }
+
+    // Run is published under the mutex, workers read it only after they've seen the new generation
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _function = &function;
+        _count = count;
+        _nextIndex = 0;
+        _numBusyWorkers = _workers.size();
+        _generation++;
+    }
+    _workCondition.notify_all();
+
+    runCalls();
+
+    // Every worker takes part in every run, so none of them can still be reading this run, when the next one starts
+    std::unique_lock<std::mutex> lock(_mutex);
+    _doneCondition.wait(lock, [this] { return _numBusyWorkers == 0; });
+    _function = nullptr;
+}
+
+unsigned int WorkerPool::getNumThreads() const
+{
+    return static_cast<unsigned int>(_workers.size()) + 1;
+}
+
+void WorkerPool::workerLoop()
+{
+    uint64_t lastGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _workCondition.wait(lock, [&] { return _isStopping || _generation != lastGeneration; });
+            if (_isStopping) {
+                return;
+            }
+            lastGeneration = _generation;
+        }
+
+        runCalls();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_numBusyWorkers == 0) {
+            _doneCondition.notify_one();
+        }
+    }
+}
+
+void WorkerPool::runCalls()
+{
+    for (auto i = _nextIndex++; i < _count; i = _nextIndex++) {
+        (*_function)(i);
+    }
+}
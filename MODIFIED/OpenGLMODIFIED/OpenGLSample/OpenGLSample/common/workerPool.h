@@ -0,0 +1,72 @@
+#pragma once
+
+// STL
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Project
+#include "parallel.hpp"
+
+/**
+ * Threads started once and reused for every run(), for work repeated every frame, where starting threads
+ * each time (runOnThreads) would cost more than the work itself. The calling thread takes part in every run,
+ * so a pool of N threads has N - 1 workers. Only one thread may call run() at a time.
+ */
+class WorkerPool
+{
+public:
+    /**
+     * Starts the workers.
+     *
+     * @param numThreads  Number of threads including the calling one (ALL_HARDWARE_THREADS to use all)
+     */
+    explicit WorkerPool(unsigned int numThreads = ALL_HARDWARE_THREADS);
+
+    /**
+     * Stops the workers.
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Calls function(i) for every i in [0, count), indices are handed out one by one to whichever thread is free.
+     * Returns when all calls have finished.
+     */
+    void run(size_t count, const std::function<void(size_t)>& function);
+
+    /**
+     * Gets number of threads including the calling one.
+     */
+    unsigned int getNumThreads() const;
+
+private:
+    std::vector<std::thread> _workers; // Worker threads
+    std::mutex _mutex; // Guards _generation, _numBusyWorkers and _isStopping
+    std::condition_variable _workCondition; // Wakes up workers, when there's a new run or pool is stopping
+    std::condition_variable _doneCondition; // Wakes up run(), when the last worker finished
+    uint64_t _generation = 0; // Number of runs started, workers compare it to the last run they took part in
+    size_t _numBusyWorkers = 0; // Workers, that haven't finished the current run
+    bool _isStopping = false; // Tells workers to quit
+
+    const std::function<void(size_t)>* _function = nullptr; // Function of the current run
+    size_t _count = 0; // Number of calls of the current run
+    std::atomic<size_t> _nextIndex{ 0 }; // Next index of the current run to be taken
+
+    /**
+     * Takes part in every run until the pool is stopping (worker thread).
+     */
+    void workerLoop();
+
+    /**
+     * Calls the function for indices not taken yet (any thread).
+     */
+    void runCalls();
+};
@@ -7,11 +7,12 @@
 
 // Project
 #include "cylinder.h"
+#include "common/glState.h"
 
 namespace static_meshes_3D {
 
-	Cylinder::Cylinder(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals)
-		: StaticMesh3D(withPositions, withTextureCoordinates, withNormals)
+	Cylinder::Cylinder(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout::Packing packing)
+		: StaticMeshIndexed3D(withPositions, withTextureCoordinates, withNormals, packing)
 		, _radius(radius)
 		, _numSlices(numSlices)
 		, _height(height)
@@ -40,20 +41,33 @@ namespace static_meshes_3D {
 			return;
 		}
 
+		// Side needs a seam column (same position, different texture coordinate U) only when there are texture coordinates,
+		// covers never need it, because their last rim vertex would be identical to the first one
+		const auto hasSideSeam = hasTextureCoordinates();
+		const auto numSideColumns = hasSideSeam ? _numSlices + 1 : _numSlices;
+
 		// Calculate and cache numbers of vertices
-		_numVerticesSide = (_numSlices + 1) * 2;
-		_numVerticesTopBottom = _numSlices + 2;
-		_numVerticesTotal = _numVerticesSide + _numVerticesTopBottom * 2;
+		_numVerticesSide = numSideColumns * 2;
+		_numVerticesCover = _numSlices;
+		_numVertices = _numVerticesSide + _numVerticesCover * 2;
 
 		// Generate VAO and VBO for vertex attributes
 		glGenVertexArrays(1, &_vao);
-		glBindVertexArray(_vao);
-		_vbo.createVBO(getVertexByteSize() * _numVerticesTotal);
+		GLState::bindVertexArray(_vao);
+		const auto& layout = createVertexLayout(_numVertices);
+		_vbo.createVBO(layout.byteSize);
+
+		// Vertices are written directly to the VBO data in the chosen layout
+		auto vertexData = _vbo.allocateRawData(layout.byteSize);
+		const auto topCoverIndex = _numVerticesSide;
+		const auto bottomCoverIndex = _numVerticesSide + _numVerticesCover;
 
 		// Pre-calculate sines / cosines for given number of slices
 		const auto sliceAngleStep = 2.0f * glm::pi<float>() / float(_numSlices);
 		auto currentSliceAngle = 0.0f;
 		std::vector<float> sines, cosines;
+		sines.reserve(_numSlices + 1);
+		cosines.reserve(_numSlices + 1);
 		for (auto i = 0; i <= _numSlices; i++)
 		{
 			sines.push_back(sin(currentSliceAngle));
@@ -65,41 +79,22 @@ namespace static_meshes_3D {
 
 		if (hasPositions())
 		{
-			// Pre-calculate X and Z coordinates
-			std::vector<float> x;
-			std::vector<float> z;
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				x.push_back(cosines[i] * _radius);
-				z.push_back(sines[i] * _radius);
-			}
-
 			// Add cylinder side vertices
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				const auto topPosition = glm::vec3(x[i], _height / 2.0f, z[i]);
-				const auto bottomPosition = glm::vec3(x[i], -_height / 2.0f, z[i]);
-				_vbo.addRawData(&topPosition, sizeof(glm::vec3));
-				_vbo.addRawData(&bottomPosition, sizeof(glm::vec3));
-			}
-
-			// Add top cylinder cover
-			glm::vec3 topCenterPosition(0.0f, _height / 2.0f, 0.0f);
-			_vbo.addRawData(&topCenterPosition, sizeof(glm::vec3));
-			for (auto i = 0; i <= _numSlices; i++)
+			for (auto i = 0; i < numSideColumns; i++)
 			{
-				const auto topPosition = glm::vec3(x[i], _height / 2.0f, z[i]);
-				_vbo.addRawData(&topPosition, sizeof(glm::vec3));
+				const auto x = cosines[i] * _radius;
+				const auto z = sines[i] * _radius;
+				layout.writePosition(vertexData, i * 2, glm::vec3(x, _height / 2.0f, z));
+				layout.writePosition(vertexData, i * 2 + 1, glm::vec3(x, -_height / 2.0f, z));
 			}
 
-			// Add bottom cylinder cover
-			glm::vec3 bottomCenterPosition(0.0f, -_height / 2.0f, 0.0f);
-			_vbo.addRawData(&bottomCenterPosition, sizeof(glm::vec3));
-			for (auto i = 0; i <= _numSlices; i++)
+			// Add top and bottom cylinder cover rims
+			for (auto i = 0; i < _numVerticesCover; i++)
 			{
-				const auto bottomPosition = glm::vec3(x[i], -_height / 2.0f, -z[i]);
-				_vbo.addRawData(&bottomPosition, sizeof(glm::vec3));
+				layout.writePosition(vertexData, topCoverIndex + i, glm::vec3(cosines[i] * _radius, _height / 2.0f, sines[i] * _radius));
+				layout.writePosition(vertexData, bottomCoverIndex + i, glm::vec3(cosines[i] * _radius, -_height / 2.0f, -sines[i] * _radius));
 			}
+			computeBounds(vertexData);
 		}
 
 		if (hasTextureCoordinates())
@@ -109,46 +104,78 @@ namespace static_meshes_3D {
 			const auto sliceTextureStepU = 2.0f / float(_numSlices);
 
 			auto currentSliceTexCoordU = 0.0f;
-			for (auto i = 0; i <= _numSlices; i++)
+			for (auto i = 0; i < numSideColumns; i++)
 			{
-				_vbo.addData(glm::vec2(currentSliceTexCoordU, 1.0f));
-				_vbo.addData(glm::vec2(currentSliceTexCoordU, 0.0f));
+				layout.writeTextureCoordinate(vertexData, i * 2, glm::vec2(currentSliceTexCoordU, 1.0f));
+				layout.writeTextureCoordinate(vertexData, i * 2 + 1, glm::vec2(currentSliceTexCoordU, 0.0f));
 
 				// Update texture coordinate of current slice 
 				currentSliceTexCoordU += sliceTextureStepU;
 			}
 
-			// Generate circle texture coordinates for cylinder top cover
+			// Generate circle texture coordinates for cylinder top and bottom cover
 			glm::vec2 topBottomCenterTexCoord(0.5f, 0.5f);
-			_vbo.addData(topBottomCenterTexCoord);
-			for (auto i = 0; i <= _numSlices; i++) {
-				_vbo.addData(glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y + cosines[i] * 0.5f));
-			}
-
-			// Generate circle texture coordinates for cylinder bottom cover
-			_vbo.addData(topBottomCenterTexCoord);
-			for (auto i = 0; i <= _numSlices; i++) {
-				_vbo.addData(glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y - cosines[i] * 0.5f));
+			for (auto i = 0; i < _numVerticesCover; i++)
+			{
+				layout.writeTextureCoordinate(vertexData, topCoverIndex + i, glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y + cosines[i] * 0.5f));
+				layout.writeTextureCoordinate(vertexData, bottomCoverIndex + i, glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y - cosines[i] * 0.5f));
 			}
 		}
 
 		if (hasNormals())
 		{
-			for (auto i = 0; i <= _numSlices; i++) {
-				_vbo.addData(glm::vec3(cosines[i], 0.0f, sines[i]), 2);
+			for (auto i = 0; i < numSideColumns; i++)
+			{
+				const glm::vec3 normal(cosines[i], 0.0f, sines[i]);
+				layout.writeNormal(vertexData, i * 2, normal);
+				layout.writeNormal(vertexData, i * 2 + 1, normal);
 			}
 
-			// Add normal for every vertex of cylinder top cover
-			_vbo.addData(glm::vec3(0.0f, 1.0f, 0.0f), _numVerticesTopBottom);
-
-			// Add normal for every vertex of cylinder bottom cover
-			_vbo.addData(glm::vec3(0.0f, -1.0f, 0.0f), _numVerticesTopBottom);
+			// Add normal for every vertex of cylinder top and bottom cover
+			for (auto i = 0; i < _numVerticesCover; i++)
+			{
+				layout.writeNormal(vertexData, topCoverIndex + i, glm::vec3(0.0f, 1.0f, 0.0f));
+				layout.writeNormal(vertexData, bottomCoverIndex + i, glm::vec3(0.0f, -1.0f, 0.0f));
+			}
 		}
 
 		// Finally upload data to the GPU
 		_vbo.bindVBO();
 		_vbo.uploadDataToGPU(GL_STATIC_DRAW);
-		setVertexAttributesPointers(_numVerticesTotal);
+		setVertexAttributesPointers(_numVertices);
+
+		// Side is one triangle strip, closed by repeating first column if there's no seam
+		std::vector<GLuint> indices;
+		indices.reserve(_numVerticesSide + 2 + 1 + _numVerticesCover * 2 + 1);
+		for (auto i = 0; i < _numVerticesSide; i++) {
+			indices.push_back(i);
+		}
+		if (!hasSideSeam)
+		{
+			indices.push_back(0);
+			indices.push_back(1);
+		}
+
+		// Covers are convex polygons, so they are triangulated as zig-zag strips (0, 1, n-1, 2, n-2...) without center vertex,
+		// which keeps the same winding as triangle fans around the center
+		const auto addCoverIndices = [&indices, this](int firstVertexIndex)
+		{
+			indices.push_back(PRIMITIVE_RESTART_MARKER);
+			indices.push_back(firstVertexIndex);
+			auto low = 1;
+			auto high = _numVerticesCover - 1;
+			while (low <= high)
+			{
+				indices.push_back(firstVertexIndex + low++);
+				if (low <= high) {
+					indices.push_back(firstVertexIndex + high--);
+				}
+			}
+		};
+		addCoverIndices(topCoverIndex);
+		addCoverIndices(bottomCoverIndex);
+
+		uploadIndices(indices);
 
 		_isInitialized = true;
 	}
@@ -159,16 +186,8 @@ namespace static_meshes_3D {
 			return;
 		}
 
-		glBindVertexArray(_vao);
-
-		// Render cylinder side first
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVerticesSide);
-
-		// Render top cover
-		glDrawArrays(GL_TRIANGLE_FAN, _numVerticesSide, _numVerticesTopBottom);
-
-		// Render bottom cover
-		glDrawArrays(GL_TRIANGLE_FAN, _numVerticesSide + _numVerticesTopBottom, _numVerticesTopBottom);
+		// Side and both covers at once, primitive restart separates them
+		renderIndexed(GL_TRIANGLE_STRIP);
 	}
 
 	void Cylinder::renderPoints() const
@@ -178,8 +197,8 @@ namespace static_meshes_3D {
 		}
 
 		// Just render all points as they are stored in the VBO
-		glBindVertexArray(_vao);
-		glDrawArrays(GL_POINTS, 0, _numVerticesTotal);
+		GLState::bindVertexArray(_vao);
+		glDrawArrays(GL_POINTS, 0, _numVertices);
 	}
 
 } // namespace static_meshes_3D
\ No newline at end of file
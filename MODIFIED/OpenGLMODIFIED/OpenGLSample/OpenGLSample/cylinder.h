@@ -1,16 +1,18 @@
 #pragma once
-#include "common/staticMesh3D.h"
+#include "common/staticMeshIndexed3D.h"
 
 namespace static_meshes_3D {
 
 	/**
-	* Cylinder static mesh with given radius, number of slices and height.
+	* Cylinder static mesh with given radius, number of slices and height. Side and both covers
+	* are indexed triangle strips separated by primitive restart, so whole cylinder is one draw call.
 	*/
-	class Cylinder : public StaticMesh3D
+	class Cylinder : public StaticMeshIndexed3D
 	{
 	public:
 		Cylinder(float radius, int numSlices, float height,
-			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true,
+			VertexLayout::Packing packing = VertexLayout::Packing::Interleaved);
 
 		void render() const override;
 		void renderPoints() const override;
@@ -35,9 +37,8 @@ namespace static_meshes_3D {
 		int _numSlices; // Number of cylinder slices
 		float _height; // Height of the cylinder
 
-		int _numVerticesSide; // How many vertices to render side of the cylinder
-		int _numVerticesTopBottom; // How many vertices to render top / bottom of the cylinder
-		int _numVerticesTotal; // Just a sum of both numbers above
+		int _numVerticesSide; // How many vertices are there on the side of the cylinder
+		int _numVerticesCover; // How many vertices are there on top / bottom cover of the cylinder
 
 		void initializeData() override;
 	};
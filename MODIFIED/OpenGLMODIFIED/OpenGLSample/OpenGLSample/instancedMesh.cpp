@@ -0,0 +1,134 @@
+// STL
+#include <cstddef>
+#include <iostream>
+
+// Project
+#include "instancedMesh.h"
+#include "normalMatrix.h"
+#include "common/glState.h"
+
+const GLuint InstancedMesh::INSTANCE_MODEL_ATTRIBUTE_INDEX = 8;
+const GLuint InstancedMesh::INSTANCE_NORMAL_MATRIX_ATTRIBUTE_INDEX = 12;
+
+InstancedMesh::InstancedMesh(GLuint vao, const DrawRange& range, const MeshBounds& bounds)
+	: _vao(vao)
+	, _range(range)
+	, _meshBounds(bounds) {}
+
+InstancedMesh::InstancedMesh(const static_meshes_3D::StaticMeshIndexed3D& mesh, GLenum primitiveType)
+	: InstancedMesh(mesh.getVAO(), DrawRange::indexedMesh(mesh, primitiveType), mesh.getBounds()) {}
+
+void InstancedMesh::createBuffer()
+{
+	if (_bufferID != 0)
+	{
+		std::cerr << "Instance buffer is already created!" << std::endl;
+		return;
+	}
+
+	glGenBuffers(1, &_bufferID);
+	GLState::bindVertexArray(_vao);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, _bufferID);
+
+	// Matrices take one attribute per column, every column advances once per instance
+	for (GLuint column = 0; column < 4; column++)
+	{
+		const auto index = INSTANCE_MODEL_ATTRIBUTE_INDEX + column;
+		glEnableVertexAttribArray(index);
+		glVertexAttribPointer(index, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+			reinterpret_cast<void*>(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+		glVertexAttribDivisor(index, 1);
+	}
+	for (GLuint column = 0; column < 3; column++)
+	{
+		const auto index = INSTANCE_NORMAL_MATRIX_ATTRIBUTE_INDEX + column;
+		glEnableVertexAttribArray(index);
+		glVertexAttribPointer(index, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+			reinterpret_cast<void*>(offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec3)));
+		glVertexAttribDivisor(index, 1);
+	}
+
+	// Instances added before the buffer existed get uploaded with the next upload()
+	_bufferCapacity = 0;
+	_isDirty = true;
+}
+
+void InstancedMesh::clearInstances()
+{
+	_instances.clear();
+	_instancesBox = BoundingBox();
+	_isDirty = true;
+}
+
+void InstancedMesh::addInstance(const glm::mat4& model)
+{
+	_instances.push_back({ model, computeNormalMatrix(model) });
+	_instancesBox.include(_meshBounds.box.transformed(model));
+	_isDirty = true;
+}
+
+void InstancedMesh::setInstances(const std::vector<glm::mat4>& models)
+{
+	clearInstances();
+	_instances.reserve(models.size());
+	for (const auto& model : models) {
+		addInstance(model);
+	}
+	_isDirty = true;
+}
+
+void InstancedMesh::upload()
+{
+	if (!_isDirty || _bufferID == 0) {
+		return;
+	}
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, _bufferID);
+	if (_instances.size() > _bufferCapacity)
+	{
+		// Buffer is reallocated only when it grows, with some room to spare for instances added later
+		_bufferCapacity = _instances.size() + _instances.size() / 2;
+		glBufferData(GL_ARRAY_BUFFER, _bufferCapacity * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+	}
+	if (!_instances.empty()) {
+		glBufferSubData(GL_ARRAY_BUFFER, 0, _instances.size() * sizeof(InstanceData), _instances.data());
+	}
+	_isDirty = false;
+}
+
+void InstancedMesh::render()
+{
+	upload();
+	if (_instances.empty()) {
+		return;
+	}
+
+	GLState::bindVertexArray(_vao);
+	_range.draw(getNumInstances());
+}
+
+void InstancedMesh::fillPacket(DrawPacket& packet) const
+{
+	packet.vao = _vao;
+	packet.range = _range;
+	packet.instanceCount = getNumInstances();
+	// Instances are placed by their own matrices, bounds are already in world space
+	packet.model = glm::mat4(1.0f);
+	packet.bounds = MeshBounds::fromBox(_instancesBox);
+}
+
+GLsizei InstancedMesh::getNumInstances() const
+{
+	return static_cast<GLsizei>(_instances.size());
+}
+
+void InstancedMesh::deleteBuffer()
+{
+	if (_bufferID == 0) {
+		return;
+	}
+
+	GLState::deleteBuffers(1, &_bufferID);
+	_bufferID = 0;
+	_bufferCapacity = 0;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+// STL
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "renderQueue.h"
+
+/**
+ * Per-instance vertex data of an instanced mesh. Normal matrix is computed on the CPU once per instance
+ * (see computeNormalMatrix), so that vertex shader doesn't have to invert the model matrix for every vertex.
+ */
+struct InstanceData
+{
+	glm::mat4 model; // Model matrix of the instance
+	glm::mat3 normalMatrix; // Transposed inverse of the upper 3x3 of the model matrix
+};
+
+/**
+ * Draws many copies of one mesh with a single glDrawArraysInstanced / glDrawElementsInstanced call. Instance data
+ * live in their own buffer, attached to the VAO of the mesh as attributes with divisor 1 (model matrix at
+ * INSTANCE_MODEL_ATTRIBUTE_INDEX, normal matrix at INSTANCE_NORMAL_MATRIX_ATTRIBUTE_INDEX). Programs not declaring
+ * those attributes ignore them, so the mesh can still be drawn on its own, but only one InstancedMesh may use a VAO.
+ * Meant for vertex shaders compiled with INSTANCED defined (see 6.multiple_lights.vs).
+ */
+class InstancedMesh
+{
+public:
+	static const GLuint INSTANCE_MODEL_ATTRIBUTE_INDEX; // First of 4 attribute indices of the model matrix (8)
+	static const GLuint INSTANCE_NORMAL_MATRIX_ATTRIBUTE_INDEX; // First of 3 attribute indices of the normal matrix (12)
+
+	/**
+	 * Creates instanced mesh drawing given range of the VAO (works with any VAO, e.g. Mesh::VAO). Instances
+	 * of meshes without bounds are never culled.
+	 */
+	InstancedMesh(GLuint vao, const DrawRange& range, const MeshBounds& bounds = MeshBounds());
+
+	/**
+	 * Creates instanced mesh drawing all indices of an indexed static mesh, same as the mesh renders itself.
+	 */
+	InstancedMesh(const static_meshes_3D::StaticMeshIndexed3D& mesh, GLenum primitiveType);
+
+	/**
+	 * Creates the instance buffer and attaches it to the VAO.
+	 */
+	void createBuffer();
+
+	/**
+	 * Removes all instances.
+	 */
+	void clearInstances();
+
+	/**
+	 * Adds instance with given model matrix, its normal matrix is computed here.
+	 */
+	void addInstance(const glm::mat4& model);
+
+	/**
+	 * Replaces all instances with instances having given model matrices.
+	 */
+	void setInstances(const std::vector<glm::mat4>& models);
+
+	/**
+	 * Uploads instance data, if they changed since the last upload. Buffer grows as needed, otherwise it's reused.
+	 */
+	void upload();
+
+	/**
+	 * Uploads changed instance data and draws all instances (program and textures must be bound).
+	 */
+	void render();
+
+	/**
+	 * Fills VAO, range, instance count and bounds (box around all instances) of the draw packet, so that
+	 * the render queue draws (or culls) all instances. Instance data must be uploaded before the queue is executed.
+	 */
+	void fillPacket(DrawPacket& packet) const;
+
+	/**
+	 * Gets number of instances.
+	 */
+	GLsizei getNumInstances() const;
+
+	/**
+	 * Deletes the instance buffer.
+	 */
+	void deleteBuffer();
+
+private:
+	GLuint _vao; // VAO of the mesh, instance attributes are attached to it
+	DrawRange _range; // Drawn vertices of every instance
+	MeshBounds _meshBounds; // Model space bounds of the mesh
+	BoundingBox _instancesBox; // World space box around all instances
+	std::vector<InstanceData> _instances; // CPU copy of the instance data
+	GLuint _bufferID = 0; // OpenGL assigned buffer ID
+	size_t _bufferCapacity = 0; // Number of instances the buffer has room for
+	bool _isDirty = false; // True, if instances changed since the last upload
+};
@@ -0,0 +1,160 @@
+// STL
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// Project
+#include "lights.h"
+#include "clusteredLights.h"
+#include "common/glState.h"
+
+std::vector<std::string> LightPermutation::getDefines() const
+{
+	std::vector<std::string> defines = {
+		"MAX_POINT_LIGHTS " + std::to_string(MAX_POINT_LIGHTS),
+		"NR_POINT_LIGHTS " + std::to_string(numPointLights),
+		std::string("HAS_DIR_LIGHT ") + (hasDirLight ? "1" : "0"),
+		std::string("HAS_SPOT_LIGHT ") + (hasSpotLight ? "1" : "0"),
+		std::string("CLUSTERED_LIGHTS ") + (hasClusteredLights ? "1" : "0")
+	};
+	if (hasClusteredLights)
+	{
+		defines.push_back("CLUSTER_GRID_SIZE_X " + std::to_string(ClusteredLights::GRID_SIZE_X));
+		defines.push_back("CLUSTER_GRID_SIZE_Y " + std::to_string(ClusteredLights::GRID_SIZE_Y));
+		defines.push_back("CLUSTER_GRID_SIZE_Z " + std::to_string(ClusteredLights::GRID_SIZE_Z));
+	}
+	return defines;
+}
+
+bool LightPermutation::operator==(const LightPermutation& other) const
+{
+	return numPointLights == other.numPointLights && hasDirLight == other.hasDirLight && hasSpotLight == other.hasSpotLight
+		&& hasClusteredLights == other.hasClusteredLights;
+}
+
+bool LightPermutation::operator!=(const LightPermutation& other) const
+{
+	return !(*this == other);
+}
+
+const GLuint LightBlockBuffer::BINDING_POINT = 0;
+const char* LightBlockBuffer::BLOCK_NAME = "LightBlock";
+
+void LightBlockBuffer::createBuffer()
+{
+	if (_bufferID != 0)
+	{
+		std::cerr << "Light block buffer is already created!" << std::endl;
+		return;
+	}
+
+	glGenBuffers(1, &_bufferID);
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, _bufferID);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), &_data, GL_DYNAMIC_DRAW);
+	GLState::bindBufferBase(GL_UNIFORM_BUFFER, BINDING_POINT, _bufferID);
+
+	// Everything has just been uploaded
+	_dirtyBegin = _dirtyEnd = 0;
+}
+
+void LightBlockBuffer::bindToProgram(GLuint programID)
+{
+	const auto blockIndex = glGetUniformBlockIndex(programID, BLOCK_NAME);
+	if (blockIndex == GL_INVALID_INDEX) {
+		return;
+	}
+
+	glUniformBlockBinding(programID, blockIndex, BINDING_POINT);
+}
+
+void LightBlockBuffer::setDirLight(const DirLight& dirLight)
+{
+	updateRange(&_data.dirLight, &dirLight, sizeof(DirLight));
+	_permutation.hasDirLight = true;
+}
+
+void LightBlockBuffer::setPointLight(int index, const PointLight& pointLight)
+{
+	if (index < 0 || index >= MAX_POINT_LIGHTS)
+	{
+		std::cerr << "Point light index " << index << " is out of range, there are only " << MAX_POINT_LIGHTS << " point lights!" << std::endl;
+		return;
+	}
+
+	updateRange(&_data.pointLights[index], &pointLight, sizeof(PointLight));
+	_permutation.numPointLights = std::max(_permutation.numPointLights, index + 1);
+}
+
+void LightBlockBuffer::setSpotLight(const SpotLight& spotLight)
+{
+	updateRange(&_data.spotLight, &spotLight, sizeof(SpotLight));
+	_permutation.hasSpotLight = true;
+}
+
+void LightBlockBuffer::setPermutation(const LightPermutation& permutation)
+{
+	if (permutation.numPointLights < 0 || permutation.numPointLights > MAX_POINT_LIGHTS)
+	{
+		std::cerr << "Number of point lights " << permutation.numPointLights << " is out of range, there is room for only " << MAX_POINT_LIGHTS << " point lights!" << std::endl;
+		return;
+	}
+
+	_permutation = permutation;
+}
+
+const LightPermutation& LightBlockBuffer::getPermutation() const
+{
+	return _permutation;
+}
+
+const LightBlock& LightBlockBuffer::getData() const
+{
+	return _data;
+}
+
+void LightBlockBuffer::upload()
+{
+	if (_bufferID == 0 || _dirtyBegin >= _dirtyEnd) {
+		return;
+	}
+
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, _bufferID);
+	// Buffer stays bound, so that the next upload doesn't have to bind it again
+	glBufferSubData(GL_UNIFORM_BUFFER, _dirtyBegin, _dirtyEnd - _dirtyBegin, reinterpret_cast<const unsigned char*>(&_data) + _dirtyBegin);
+
+	_dirtyBegin = _dirtyEnd = 0;
+}
+
+void LightBlockBuffer::deleteBuffer()
+{
+	if (_bufferID == 0) {
+		return;
+	}
+
+	GLState::deleteBuffers(1, &_bufferID);
+	_bufferID = 0;
+	_dirtyBegin = 0;
+	_dirtyEnd = sizeof(LightBlock);
+}
+
+void LightBlockBuffer::updateRange(void* destination, const void* source, size_t size)
+{
+	if (memcmp(destination, source, size) == 0) {
+		return;
+	}
+
+	memcpy(destination, source, size);
+
+	const size_t begin = static_cast<unsigned char*>(destination) - reinterpret_cast<unsigned char*>(&_data);
+	const size_t end = begin + size;
+	if (_dirtyBegin >= _dirtyEnd)
+	{
+		_dirtyBegin = begin;
+		_dirtyEnd = end;
+	}
+	else
+	{
+		_dirtyBegin = std::min(_dirtyBegin, begin);
+		_dirtyEnd = std::max(_dirtyEnd, end);
+	}
+}
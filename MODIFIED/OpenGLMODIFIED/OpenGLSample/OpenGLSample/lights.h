@@ -0,0 +1,172 @@
+#pragma once
+
+// STL
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+/**
+ * Number of point lights the light block has room for, must match MAX_POINT_LIGHTS in 6.multiple_lights.fs.
+ */
+const int MAX_POINT_LIGHTS = 4;
+
+/**
+ * C++ mirrors of the light structures from 6.multiple_lights.fs. Members are ordered so that
+ * every vec3 is followed by a float, which makes the std140 layout identical to the tightly packed C++ one.
+ */
+struct DirLight
+{
+	glm::vec3 direction = glm::vec3(0.0f);
+	float padding0 = 0.0f;
+	glm::vec3 ambient = glm::vec3(0.0f);
+	float padding1 = 0.0f;
+	glm::vec3 diffuse = glm::vec3(0.0f);
+	float padding2 = 0.0f;
+	glm::vec3 specular = glm::vec3(0.0f);
+	float padding3 = 0.0f;
+};
+
+struct PointLight
+{
+	glm::vec3 position = glm::vec3(0.0f);
+	float constant = 1.0f;
+	glm::vec3 ambient = glm::vec3(0.0f);
+	float linear = 0.0f;
+	glm::vec3 diffuse = glm::vec3(0.0f);
+	float quadratic = 0.0f;
+	glm::vec3 specular = glm::vec3(0.0f);
+	float padding = 0.0f;
+};
+
+struct SpotLight
+{
+	glm::vec3 position = glm::vec3(0.0f);
+	float cutOff = 1.0f;
+	glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+	float outerCutOff = 0.0f;
+	glm::vec3 ambient = glm::vec3(0.0f);
+	float constant = 1.0f;
+	glm::vec3 diffuse = glm::vec3(0.0f);
+	float linear = 0.0f;
+	glm::vec3 specular = glm::vec3(0.0f);
+	float quadratic = 0.0f;
+};
+
+/**
+ * C++ mirror of the std140 LightBlock uniform block.
+ */
+struct LightBlock
+{
+	DirLight dirLight;
+	PointLight pointLights[MAX_POINT_LIGHTS];
+	SpotLight spotLight;
+};
+
+static_assert(sizeof(DirLight) == 64, "DirLight must match std140 layout");
+static_assert(sizeof(PointLight) == 64, "PointLight must match std140 layout");
+static_assert(sizeof(SpotLight) == 80, "SpotLight must match std140 layout");
+static_assert(offsetof(LightBlock, pointLights) == 64, "LightBlock must match std140 layout");
+static_assert(offsetof(LightBlock, spotLight) == 64 + 64 * MAX_POINT_LIGHTS, "LightBlock must match std140 layout");
+
+/**
+ * Lights, that are present in the light block. Lighting shaders are compiled once per permutation,
+ * so that fragments evaluate only the lights that exist (see getDefines()).
+ */
+struct LightPermutation
+{
+	int numPointLights = 0; // Point lights 0 .. numPointLights - 1 are used
+	bool hasDirLight = false; // True, if directional light is used
+	bool hasSpotLight = false; // True, if spot light is used
+	bool hasClusteredLights = false; // True, if point lights of ClusteredLights are evaluated too
+
+	/**
+	 * Gets shader defines selecting the permutation (NR_POINT_LIGHTS, HAS_DIR_LIGHT, HAS_SPOT_LIGHT and CLUSTERED_LIGHTS
+	 * with the cluster grid size).
+	 */
+	std::vector<std::string> getDefines() const;
+
+	bool operator==(const LightPermutation& other) const;
+	bool operator!=(const LightPermutation& other) const;
+};
+
+/**
+ * Holds light data in a uniform buffer object bound to a fixed binding point, so that all
+ * programs declaring LightBlock share it. Setters only mark changed byte ranges as dirty
+ * and upload() sends just that range to the GPU.
+ */
+class LightBlockBuffer
+{
+public:
+	static const GLuint BINDING_POINT; // Uniform buffer binding point of the light block (0)
+	static const char* BLOCK_NAME; // Name of the uniform block in shaders ("LightBlock")
+
+	/**
+	 * Creates the uniform buffer and binds it to BINDING_POINT.
+	 */
+	void createBuffer();
+
+	/**
+	 * Connects LightBlock of given program to BINDING_POINT. Programs without the block are ignored.
+	 *
+	 * @param programID  OpenGL ID of the linked program
+	 */
+	static void bindToProgram(GLuint programID);
+
+	/**
+	 * Sets directional light and marks it as used.
+	 */
+	void setDirLight(const DirLight& dirLight);
+
+	/**
+	 * Sets point light with given index (0 .. MAX_POINT_LIGHTS - 1), point lights up to the index become used.
+	 */
+	void setPointLight(int index, const PointLight& pointLight);
+
+	/**
+	 * Sets spot light and marks it as used.
+	 */
+	void setSpotLight(const SpotLight& spotLight);
+
+	/**
+	 * Sets, which lights are used (lights dropped from the permutation keep their data).
+	 */
+	void setPermutation(const LightPermutation& permutation);
+
+	/**
+	 * Gets lights, that are used, to select the matching shader variant.
+	 */
+	const LightPermutation& getPermutation() const;
+
+	/**
+	 * Gets light data as they will be uploaded.
+	 */
+	const LightBlock& getData() const;
+
+	/**
+	 * Uploads dirty range of the light block to the GPU (does nothing, if nothing has changed).
+	 */
+	void upload();
+
+	/**
+	 * Deletes the uniform buffer.
+	 */
+	void deleteBuffer();
+
+private:
+	LightBlock _data; // CPU copy of the light block
+	LightPermutation _permutation; // Lights, that are used
+	GLuint _bufferID = 0; // OpenGL assigned buffer ID
+	size_t _dirtyBegin = 0; // First dirty byte of the light block
+	size_t _dirtyEnd = sizeof(LightBlock); // One past last dirty byte of the light block
+
+	/**
+	 * Copies new value over part of the light block and marks it dirty if it differs.
+	 */
+	void updateRange(void* destination, const void* source, size_t size);
+};
@@ -0,0 +1,32 @@
+// STL
+#include <cmath>
+
+// Project
+#include "normalMatrix.h"
+
+namespace {
+
+	const float UNIFORM_SCALE_TOLERANCE = 1e-5f; // Relative tolerance of axis lengths and angles considered uniform scale
+
+} // namespace
+
+glm::mat3 computeNormalMatrix(const glm::mat4& model)
+{
+	const glm::mat3 linear(model);
+
+	// Axes of a rotation with uniform scale s are orthogonal and all have squared length s^2,
+	// then inverse(transpose(s * R)) = R / s = linear / s^2
+	const auto lengthSquared = glm::dot(linear[0], linear[0]);
+	const auto tolerance = UNIFORM_SCALE_TOLERANCE * lengthSquared;
+	const auto isUniform = lengthSquared > 0.0f
+		&& std::abs(glm::dot(linear[1], linear[1]) - lengthSquared) <= tolerance
+		&& std::abs(glm::dot(linear[2], linear[2]) - lengthSquared) <= tolerance
+		&& std::abs(glm::dot(linear[0], linear[1])) <= tolerance
+		&& std::abs(glm::dot(linear[0], linear[2])) <= tolerance
+		&& std::abs(glm::dot(linear[1], linear[2])) <= tolerance;
+	if (isUniform) {
+		return lengthSquared == 1.0f ? linear : linear * (1.0f / lengthSquared);
+	}
+
+	return glm::transpose(glm::inverse(linear));
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// GLM
+#include <glm/glm.hpp>
+
+/**
+ * Computes matrix transforming normals of a model with given model matrix (transposed inverse of its upper 3x3).
+ * Rotations combined with uniform scale (the usual case) skip the inverse, their normal matrix is the upper 3x3
+ * divided by the squared scale. Normals transformed by the result have the same length as with the full inverse.
+ */
+glm::mat3 computeNormalMatrix(const glm::mat4& model);
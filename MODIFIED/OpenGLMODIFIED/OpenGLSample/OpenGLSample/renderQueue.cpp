@@ -0,0 +1,307 @@
+// STL
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// Project
+#include "renderQueue.h"
+#include "normalMatrix.h"
+#include "common/glState.h"
+
+namespace {
+
+	// Quantizes non-negative depth to given number of bits keeping the order (positive floats order as their bits)
+	uint64_t quantizeDepth(float depth, int bits)
+	{
+		depth = std::max(depth, 0.0f);
+		uint32_t depthBits;
+		memcpy(&depthBits, &depth, sizeof(depthBits));
+		return depthBits >> (32 - bits);
+	}
+
+} // namespace
+
+DrawRange DrawRange::arrays(GLenum primitiveType, GLint first, GLsizei count)
+{
+	DrawRange range;
+	range.primitiveType = primitiveType;
+	range.first = first;
+	range.count = count;
+	return range;
+}
+
+DrawRange DrawRange::indexedMesh(const static_meshes_3D::StaticMeshIndexed3D& mesh, GLenum primitiveType)
+{
+	DrawRange range;
+	range.primitiveType = primitiveType;
+	range.count = mesh.getNumIndices();
+	range.indexType = mesh.getIndexType();
+	range.primitiveRestart = true;
+	range.primitiveRestartIndex = mesh.getPrimitiveRestartIndex();
+	return range;
+}
+
+void DrawRange::draw(GLsizei instanceCount) const
+{
+	if (indexType != 0)
+	{
+		// Primitive restart matters only for indexed draws, array draws leave it as it is
+		GLState::setEnabled(GL_PRIMITIVE_RESTART, primitiveRestart);
+		if (primitiveRestart) {
+			GLState::primitiveRestartIndex(primitiveRestartIndex);
+		}
+
+		const auto indexByteSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+		const auto indexOffset = reinterpret_cast<const void*>(first * indexByteSize);
+		if (instanceCount == 1) {
+			glDrawElements(primitiveType, count, indexType, indexOffset);
+		}
+		else {
+			glDrawElementsInstanced(primitiveType, count, indexType, indexOffset, instanceCount);
+		}
+	}
+	else if (instanceCount == 1) {
+		glDrawArrays(primitiveType, first, count);
+	}
+	else {
+		glDrawArraysInstanced(primitiveType, first, count, instanceCount);
+	}
+}
+
+bool RenderQueue::Statistics::operator==(const Statistics& other) const
+{
+	return numPackets == other.numPackets
+		&& numInstances == other.numInstances
+		&& numCulled == other.numCulled
+		&& programBinds == other.programBinds
+		&& textureBinds == other.textureBinds
+		&& vaoBinds == other.vaoBinds
+		&& modelUploads == other.modelUploads
+		&& normalMatrixUploads == other.normalMatrixUploads
+		&& otherStateChanges == other.otherStateChanges
+		&& avoidedStateChanges == other.avoidedStateChanges;
+}
+
+bool RenderQueue::Statistics::operator!=(const Statistics& other) const
+{
+	return !(*this == other);
+}
+
+size_t RenderQueue::TextureSetHash::operator()(const std::array<GLuint, DrawPacket::MAX_TEXTURES>& textures) const
+{
+	size_t hash = 0;
+	for (const auto texture : textures) {
+		hash = hash * 31 + texture;
+	}
+	return hash;
+}
+
+void RenderQueue::clear()
+{
+	_packets.clear();
+	_sortEntries.clear();
+	_volumes.clear();
+}
+
+void RenderQueue::setViewMatrix(const glm::mat4& view)
+{
+	_view = view;
+}
+
+void RenderQueue::setProjectionMatrix(const glm::mat4& projection)
+{
+	_projection = projection;
+	_isCullingEnabled = true;
+}
+
+void RenderQueue::submit(const DrawPacket& packet)
+{
+	if (packet.bounds.isEmpty()) {
+		_volumes.addUnbounded();
+	}
+	else {
+		_volumes.add(packet.bounds.box.transformed(packet.model), packet.bounds.sphere.transformed(packet.model));
+	}
+
+	// Camera looks down -Z in view space
+	const glm::vec4 viewPosition = _view * packet.model[3];
+	_sortEntries.push_back({ makeKey(packet, -viewPosition.z), static_cast<uint32_t>(_packets.size()) });
+	_packets.push_back(packet);
+}
+
+void RenderQueue::execute()
+{
+	// Entries are still in submission order, so entry i belongs to packet i, culled ones are dropped before sorting
+	size_t numCulled = 0;
+	if (_isCullingEnabled && !_sortEntries.empty())
+	{
+		const auto numVisible = Frustum(_projection * _view).cull(_volumes, _isVisible);
+		numCulled = _sortEntries.size() - numVisible;
+		size_t numKept = 0;
+		for (size_t i = 0; i < _sortEntries.size(); i++)
+		{
+			if (_isVisible[i]) {
+				_sortEntries[numKept++] = _sortEntries[i];
+			}
+		}
+		_sortEntries.resize(numKept);
+	}
+
+	sortEntries();
+
+	// Binds go through GLState, which skips the ones that would change nothing (also across frames),
+	// issued calls are the difference of its counters
+	const auto stateBefore = GLState::getStatistics();
+	GLuint currentProgram = 0;
+	const glm::mat4* currentModel = nullptr; // Model matrix last uploaded to the current program
+	const glm::mat4* currentNormalModel = nullptr; // Model matrix of the normal matrix last uploaded to the current program
+
+	Statistics statistics;
+	statistics.numCulled = numCulled;
+	size_t naiveStateChanges = 0;
+	for (const auto& entry : _sortEntries)
+	{
+		const auto& packet = _packets[entry.packetIndex];
+
+		// Binding all state of the packet like a hand-written draw would: program, every texture with its unit,
+		// VAO, model and normal matrix and enabling, setting and disabling primitive restart
+		const auto numTextures = std::count_if(packet.textures.begin(), packet.textures.end(), [](GLuint texture) { return texture != 0; });
+		naiveStateChanges += 2 + 2 * numTextures + (packet.modelLocation != -1 ? 1 : 0) + (packet.normalMatrixLocation != -1 ? 1 : 0)
+			+ (packet.range.primitiveRestart ? 3 : 0);
+
+		GLState::useProgram(packet.program);
+		if (packet.program != currentProgram)
+		{
+			currentProgram = packet.program;
+			currentModel = nullptr;
+			currentNormalModel = nullptr;
+		}
+
+		for (int unit = 0; unit < DrawPacket::MAX_TEXTURES; unit++)
+		{
+			if (packet.textures[unit] != 0) {
+				GLState::bindTexture(unit, GL_TEXTURE_2D, packet.textures[unit]);
+			}
+		}
+
+		GLState::bindVertexArray(packet.vao);
+
+		if (packet.modelLocation != -1 && (currentModel == nullptr || memcmp(currentModel, &packet.model, sizeof(glm::mat4)) != 0))
+		{
+			glUniformMatrix4fv(packet.modelLocation, 1, GL_FALSE, &packet.model[0][0]);
+			currentModel = &packet.model;
+			statistics.modelUploads++;
+		}
+
+		// Tracked on its own, a packet may have the normal matrix uniform even when its model matrix is already uploaded
+		if (packet.normalMatrixLocation != -1 && (currentNormalModel == nullptr || memcmp(currentNormalModel, &packet.model, sizeof(glm::mat4)) != 0))
+		{
+			// Computed once per object here instead of once per vertex in the vertex shader
+			const auto normalMatrix = computeNormalMatrix(packet.model);
+			glUniformMatrix3fv(packet.normalMatrixLocation, 1, GL_FALSE, &normalMatrix[0][0]);
+			currentNormalModel = &packet.model;
+			statistics.normalMatrixUploads++;
+		}
+
+		packet.range.draw(packet.instanceCount);
+		statistics.numPackets++;
+		statistics.numInstances += packet.instanceCount;
+	}
+
+	const auto& stateAfter = GLState::getStatistics();
+	const auto issued = [&](GLState::Call call) { return stateAfter.issued[call] - stateBefore.issued[call]; };
+	statistics.programBinds = issued(GLState::USE_PROGRAM);
+	statistics.textureBinds = issued(GLState::BIND_TEXTURE);
+	statistics.vaoBinds = issued(GLState::BIND_VERTEX_ARRAY);
+	statistics.otherStateChanges = issued(GLState::ACTIVE_TEXTURE) + issued(GLState::ENABLE_DISABLE) + issued(GLState::PRIMITIVE_RESTART_INDEX);
+
+	const auto issuedStateChanges = statistics.programBinds + statistics.textureBinds + statistics.vaoBinds
+		+ statistics.modelUploads + statistics.normalMatrixUploads + statistics.otherStateChanges;
+	statistics.avoidedStateChanges = naiveStateChanges > issuedStateChanges ? naiveStateChanges - issuedStateChanges : 0;
+	_statistics = statistics;
+}
+
+const RenderQueue::Statistics& RenderQueue::getStatistics() const
+{
+	return _statistics;
+}
+
+void RenderQueue::printStatistics() const
+{
+	std::cout << "Render queue: " << _statistics.numPackets << " draws (" << _statistics.numInstances << " instances), "
+		<< _statistics.numCulled << " culled, " << _statistics.programBinds << " program binds, "
+		<< _statistics.textureBinds << " texture binds, " << _statistics.vaoBinds << " VAO binds, "
+		<< _statistics.modelUploads << " model uploads, " << _statistics.normalMatrixUploads << " normal matrix uploads, " << _statistics.otherStateChanges << " other state changes, "
+		<< _statistics.avoidedStateChanges << " state changes avoided" << std::endl;
+}
+
+size_t RenderQueue::getSize() const
+{
+	return _packets.size();
+}
+
+uint64_t RenderQueue::makeKey(const DrawPacket& packet, float depth)
+{
+	// Indices not fitting into their bits wrap around, that only makes sorting less effective,
+	// execute() compares the real state
+	const uint64_t programIndex = getIndex(_programIndices, packet.program) & ((1u << PROGRAM_BITS) - 1);
+	const uint64_t textureSetIndex = getIndex(_textureSetIndices, packet.textures) & ((1u << TEXTURE_SET_BITS) - 1);
+	const uint64_t vaoIndex = getIndex(_vaoIndices, packet.vao) & ((1u << VAO_BITS) - 1);
+	return (programIndex << (TEXTURE_SET_BITS + VAO_BITS + DEPTH_BITS))
+		| (textureSetIndex << (VAO_BITS + DEPTH_BITS))
+		| (vaoIndex << DEPTH_BITS)
+		| quantizeDepth(depth, DEPTH_BITS);
+}
+
+void RenderQueue::sortEntries()
+{
+	const auto numEntries = _sortEntries.size();
+	if (numEntries < 2) {
+		return;
+	}
+
+	// Histograms of all bytes are built in one pass
+	size_t counts[8][256] = {};
+	for (const auto& entry : _sortEntries)
+	{
+		for (int byte = 0; byte < 8; byte++) {
+			counts[byte][(entry.key >> (byte * 8)) & 0xFF]++;
+		}
+	}
+
+	_sortScratch.resize(numEntries);
+	for (int byte = 0; byte < 8; byte++)
+	{
+		// All keys have the same byte, pass would not change the order
+		const auto shift = byte * 8;
+		if (counts[byte][(_sortEntries[0].key >> shift) & 0xFF] == numEntries) {
+			continue;
+		}
+
+		size_t offsets[256];
+		size_t offset = 0;
+		for (int value = 0; value < 256; value++)
+		{
+			offsets[value] = offset;
+			offset += counts[byte][value];
+		}
+
+		for (const auto& entry : _sortEntries) {
+			_sortScratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+		}
+		_sortEntries.swap(_sortScratch);
+	}
+}
+
+template <typename Map, typename Value>
+uint32_t RenderQueue::getIndex(Map& indices, const Value& value)
+{
+	const auto it = indices.find(value);
+	if (it != indices.end()) {
+		return it->second;
+	}
+
+	const auto index = static_cast<uint32_t>(indices.size());
+	indices.emplace(value, index);
+	return index;
+}
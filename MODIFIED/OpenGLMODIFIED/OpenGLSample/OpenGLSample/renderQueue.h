@@ -0,0 +1,184 @@
+#pragma once
+
+// STL
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "common/staticMeshIndexed3D.h"
+#include "common/frustum.h"
+
+/**
+ * Vertex range drawn by a draw packet, either with glDrawArrays or (if indexType is set) with glDrawElements
+ * from the element buffer of the VAO.
+ */
+struct DrawRange
+{
+	GLenum primitiveType = GL_TRIANGLES; // Type of rendered primitives
+	GLint first = 0; // First vertex (arrays) or first index (elements)
+	GLsizei count = 0; // Number of vertices or indices
+	GLenum indexType = 0; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT for indexed drawing, 0 for glDrawArrays
+	bool primitiveRestart = false; // True, if primitive restart has to be enabled for the draw
+	GLuint primitiveRestartIndex = 0; // Primitive restart index used when primitive restart is enabled
+
+	/**
+	 * Creates range drawing first count vertices.
+	 */
+	static DrawRange arrays(GLenum primitiveType, GLint first, GLsizei count);
+
+	/**
+	 * Creates range drawing all indices of an indexed mesh with primitive restart, same as the mesh renders itself.
+	 */
+	static DrawRange indexedMesh(const static_meshes_3D::StaticMeshIndexed3D& mesh, GLenum primitiveType);
+
+	/**
+	 * Sets primitive restart (for indexed ranges) and draws the range from the bound VAO. More than one instance
+	 * is drawn with glDrawArraysInstanced / glDrawElementsInstanced.
+	 */
+	void draw(GLsizei instanceCount = 1) const;
+};
+
+/**
+ * Everything needed to draw one object. Packets only reference OpenGL objects, they don't own them.
+ */
+struct DrawPacket
+{
+	static const int MAX_TEXTURES = 4; // Number of texture units a material can use
+
+	GLuint program = 0; // Linked program
+	GLint modelLocation = -1; // Location of the model matrix uniform in the program (-1 = program has none)
+	GLint normalMatrixLocation = -1; // Location of the mat3 normal matrix uniform computed from model (-1 = program has none)
+	std::array<GLuint, MAX_TEXTURES> textures = {}; // 2D textures of the material for units 0.., 0 = unit not used (left as it is)
+	GLuint vao = 0; // VAO with vertex attributes (and element buffer for indexed ranges)
+	glm::mat4 model = glm::mat4(1.0f); // Model matrix (of instanced packets only used for sorting by depth)
+	DrawRange range; // Drawn vertices
+	GLsizei instanceCount = 1; // Number of drawn instances, instanced packets take model matrices from the VAO (see InstancedMesh)
+	MeshBounds bounds; // Bounds of the drawn vertices transformed by model (empty = never culled)
+};
+
+/**
+ * Collects draw packets of a frame, culls those outside the view frustum, sorts the rest by 64-bit key (program,
+ * texture set, VAO, depth) so that packets sharing state end up next to each other, and executes them binding
+ * only state, that actually changes.
+ * Within the same state packets are drawn front to back. Uniforms other than the model matrix must be set
+ * on the programs before execute() (uniform values are kept by the program). State is bound through GLState.
+ */
+class RenderQueue
+{
+public:
+	/**
+	 * Bind and draw counts of the last executed frame.
+	 */
+	struct Statistics
+	{
+		size_t numPackets = 0; // Executed packets (= draw calls)
+		size_t numInstances = 0; // Drawn instances, packets drawn once count as one
+		size_t numCulled = 0; // Packets outside the view frustum, which were not drawn
+		size_t programBinds = 0; // Issued glUseProgram calls
+		size_t textureBinds = 0; // Issued glBindTexture calls
+		size_t vaoBinds = 0; // Issued glBindVertexArray calls
+		size_t modelUploads = 0; // Issued model matrix uniform uploads
+		size_t normalMatrixUploads = 0; // Issued normal matrix uniform uploads
+		size_t otherStateChanges = 0; // Issued glActiveTexture and primitive restart calls
+		size_t avoidedStateChanges = 0; // Calls a packet would need when binding all its state, which were not issued
+
+		bool operator==(const Statistics& other) const;
+		bool operator!=(const Statistics& other) const;
+	};
+
+	/**
+	 * Drops all packets (call at the start of every frame). Program, texture set and VAO key indices are kept,
+	 * so the order of equal scenes stays the same between frames.
+	 */
+	void clear();
+
+	/**
+	 * Sets view matrix used to compute depth of the submitted packets.
+	 */
+	void setViewMatrix(const glm::mat4& view);
+
+	/**
+	 * Sets projection matrix. Packets, whose bounds are outside the frustum of projection * view, are culled
+	 * by execute() (until the projection is set, nothing is culled).
+	 */
+	void setProjectionMatrix(const glm::mat4& projection);
+
+	/**
+	 * Adds packet to the queue. Depth of the packet is the view space depth of its model origin.
+	 */
+	void submit(const DrawPacket& packet);
+
+	/**
+	 * Sorts the packets and draws them. State bound by execute() is left bound afterwards.
+	 */
+	void execute();
+
+	/**
+	 * Gets statistics of the last execute().
+	 */
+	const Statistics& getStatistics() const;
+
+	/**
+	 * Prints statistics of the last execute().
+	 */
+	void printStatistics() const;
+
+	/**
+	 * Gets number of submitted packets.
+	 */
+	size_t getSize() const;
+
+private:
+	static const int PROGRAM_BITS = 10; // Bits of the sort key used for program index
+	static const int TEXTURE_SET_BITS = 16; // Bits of the sort key used for texture set index
+	static const int VAO_BITS = 14; // Bits of the sort key used for VAO index
+	static const int DEPTH_BITS = 24; // Bits of the sort key used for quantized depth
+
+	struct SortEntry
+	{
+		uint64_t key; // Sort key of the packet
+		uint32_t packetIndex; // Index of the packet in _packets
+	};
+
+	struct TextureSetHash
+	{
+		size_t operator()(const std::array<GLuint, DrawPacket::MAX_TEXTURES>& textures) const;
+	};
+
+	std::vector<DrawPacket> _packets; // Packets submitted this frame
+	std::vector<SortEntry> _sortEntries; // Keys of the packets, sorted by execute()
+	std::vector<SortEntry> _sortScratch; // Second buffer for the radix sort
+	glm::mat4 _view = glm::mat4(1.0f); // View matrix for depth computation
+	glm::mat4 _projection = glm::mat4(1.0f); // Projection matrix for frustum culling
+	bool _isCullingEnabled = false; // True, once the projection matrix is set
+	BoundingVolumeArray _volumes; // World space bounds of the packets (in submission order)
+	std::vector<uint8_t> _isVisible; // Result of the frustum test of every packet
+	std::unordered_map<GLuint, uint32_t> _programIndices; // Key index of every program seen
+	std::unordered_map<std::array<GLuint, DrawPacket::MAX_TEXTURES>, uint32_t, TextureSetHash> _textureSetIndices; // Key index of every texture set seen
+	std::unordered_map<GLuint, uint32_t> _vaoIndices; // Key index of every VAO seen
+	Statistics _statistics; // Statistics of the last execute()
+
+	/**
+	 * Builds sort key of the packet with given view space depth.
+	 */
+	uint64_t makeKey(const DrawPacket& packet, float depth);
+
+	/**
+	 * Sorts _sortEntries by key (LSD radix sort by bytes, bytes equal in all keys are skipped).
+	 */
+	void sortEntries();
+
+	/**
+	 * Gets dense index of the value, assigning the next free one to values not seen yet.
+	 */
+	template <typename Map, typename Value>
+	static uint32_t getIndex(Map& indices, const Value& value);
+};
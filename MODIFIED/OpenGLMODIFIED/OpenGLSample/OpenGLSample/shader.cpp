@@ -13,6 +13,7 @@ using namespace std;
 #include <GL/glew.h>
 
 #include "shader.hpp"
+#include "common/programBinaryCache.h"
 
 GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
 
@@ -44,6 +45,16 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 		FragmentShaderStream.close();
 	}
 
+	// Use the binary linked by the previous launch, if the sources and the driver didn't change
+	const uint64_t BinaryKey = ProgramBinaryCache::computeKey({ VertexShaderCode, FragmentShaderCode });
+	GLuint CachedProgramID = BinaryKey != 0 ? ProgramBinaryCache::load(BinaryKey) : 0;
+	if (CachedProgramID != 0) {
+		printf("Loaded cached program binary for %s and %s\n", vertex_file_path, fragment_file_path);
+		glDeleteShader(VertexShaderID);
+		glDeleteShader(FragmentShaderID);
+		return CachedProgramID;
+	}
+
 	GLint Result = GL_FALSE;
 	int InfoLogLength;
 
@@ -87,6 +98,7 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 	GLuint ProgramID = glCreateProgram();
 	glAttachShader(ProgramID, VertexShaderID);
 	glAttachShader(ProgramID, FragmentShaderID);
+	ProgramBinaryCache::prepareForLinking(ProgramID);
 	glLinkProgram(ProgramID);
 
 	// Check the program
@@ -97,6 +109,9 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 		glGetProgramInfoLog(ProgramID, InfoLogLength, NULL, &ProgramErrorMessage[0]);
 		printf("%s\n", &ProgramErrorMessage[0]);
 	}
+	if (Result == GL_TRUE && BinaryKey != 0) {
+		ProgramBinaryCache::store(ProgramID, BinaryKey);
+	}
 
 	
 	glDetachShader(ProgramID, VertexShaderID);
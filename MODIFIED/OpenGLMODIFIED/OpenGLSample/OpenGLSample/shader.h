@@ -5,18 +5,36 @@
 
 #include <glm/glm.hpp>
 
+#include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+#include "common/glState.h"
+#include "common/programBinaryCache.h"
+
+// resolved uniform location, look it up once with Shader::getUniform() and then set values by handle
+struct UniformHandle
+{
+	GLint location = -1;
+
+	bool isValid() const { return location != -1; }
+};
+
 class Shader
 {
 public:
 	unsigned int ID;
-	// constructor generates the shader on the fly
+	// number of uniform lookups by name, that did not match any active uniform of the program
+	mutable unsigned int uniformLookupMisses = 0;
+	// constructor generates the shader on the fly, or loads the program binary cached by the previous launch.
+	// defines ("NAME" or "NAME VALUE") are inserted into every stage right after its #version line
 	// ------------------------------------------------------------------------
-	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr, const std::vector<std::string>& defines = {})
 	{
 		// 1. retrieve the vertex/fragment source code from filePath
 		std::string vertexCode;
@@ -58,9 +76,24 @@ public:
 		{
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 		}
+		if (!defines.empty())
+		{
+			vertexCode = insertDefines(vertexCode, defines);
+			fragmentCode = insertDefines(fragmentCode, defines);
+			if (geometryPath != nullptr)
+				geometryCode = insertDefines(geometryCode, defines);
+		}
+		// 2. reuse the binary linked by the previous launch, if the sources and the driver didn't change
+		const uint64_t binaryKey = ProgramBinaryCache::computeKey({ vertexCode, fragmentCode, geometryCode });
+		ID = binaryKey != 0 ? ProgramBinaryCache::load(binaryKey) : 0;
+		if (ID != 0)
+		{
+			cacheUniformLocations();
+			return;
+		}
 		const char* vShaderCode = vertexCode.c_str();
 		const char * fShaderCode = fragmentCode.c_str();
-		// 2. compile shaders
+		// 3. compile shaders
 		unsigned int vertex, fragment;
 		// vertex shader
 		vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -88,81 +121,214 @@ public:
 		glAttachShader(ID, fragment);
 		if (geometryPath != nullptr)
 			glAttachShader(ID, geometry);
+		ProgramBinaryCache::prepareForLinking(ID);
 		glLinkProgram(ID);
 		checkCompileErrors(ID, "PROGRAM");
+		GLint isLinked = GL_FALSE;
+		glGetProgramiv(ID, GL_LINK_STATUS, &isLinked);
+		if (isLinked == GL_TRUE && binaryKey != 0)
+			ProgramBinaryCache::store(ID, binaryKey);
 		// delete the shaders as they're linked into our program now and no longer necessery
 		glDeleteShader(vertex);
 		glDeleteShader(fragment);
 		if (geometryPath != nullptr)
 			glDeleteShader(geometry);
-
+		// 4. reflect active uniforms once, so that setters never have to ask the driver
+		cacheUniformLocations();
 	}
 	// activate the shader
 	// ------------------------------------------------------------------------
 	void use()
 	{
-		glUseProgram(ID);
+		GLState::useProgram(ID);
+	}
+	// resolves uniform name to a handle, which can be used with the setters below
+	// ------------------------------------------------------------------------
+	UniformHandle getUniform(const std::string &name) const
+	{
+		UniformHandle handle;
+		handle.location = getUniformLocation(name);
+		return handle;
 	}
 	// utility uniform functions
 	// ------------------------------------------------------------------------
 	void setBool(const std::string &name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+		glUniform1i(getUniformLocation(name), (int)value);
 	}
 	// ------------------------------------------------------------------------
 	void setInt(const std::string &name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		glUniform1i(getUniformLocation(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setFloat(const std::string &name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		glUniform1f(getUniformLocation(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setVec2(const std::string &name, const glm::vec2 &value) const
 	{
-		glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform2fv(getUniformLocation(name), 1, &value[0]);
 	}
 	void setVec2(const std::string &name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+		glUniform2f(getUniformLocation(name), x, y);
 	}
 	// ------------------------------------------------------------------------
 	void setVec3(const std::string &name, const glm::vec3 &value) const
 	{
-		glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform3fv(getUniformLocation(name), 1, &value[0]);
 	}
 	void setVec3(const std::string &name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+		glUniform3f(getUniformLocation(name), x, y, z);
 	}
 	// ------------------------------------------------------------------------
 	void setVec4(const std::string &name, const glm::vec4 &value) const
 	{
-		glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform4fv(getUniformLocation(name), 1, &value[0]);
 	}
 	void setVec4(const std::string &name, float x, float y, float z, float w)
 	{
-		glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+		glUniform4f(getUniformLocation(name), x, y, z, w);
 	}
 	// ------------------------------------------------------------------------
 	void setMat2(const std::string &name, const glm::mat2 &mat) const
 	{
-		glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat3(const std::string &name, const glm::mat3 &mat) const
 	{
-		glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat4(const std::string &name, const glm::mat4 &mat) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
+	}
+	// setters by handle (no lookup at all)
+	// ------------------------------------------------------------------------
+	void setBool(UniformHandle handle, bool value) const
+	{
+		glUniform1i(handle.location, (int)value);
+	}
+	void setInt(UniformHandle handle, int value) const
+	{
+		glUniform1i(handle.location, value);
+	}
+	void setFloat(UniformHandle handle, float value) const
+	{
+		glUniform1f(handle.location, value);
+	}
+	void setVec2(UniformHandle handle, const glm::vec2 &value) const
+	{
+		glUniform2fv(handle.location, 1, &value[0]);
+	}
+	void setVec3(UniformHandle handle, const glm::vec3 &value) const
+	{
+		glUniform3fv(handle.location, 1, &value[0]);
+	}
+	void setVec3(UniformHandle handle, float x, float y, float z) const
+	{
+		glUniform3f(handle.location, x, y, z);
+	}
+	void setVec4(UniformHandle handle, const glm::vec4 &value) const
+	{
+		glUniform4fv(handle.location, 1, &value[0]);
+	}
+	void setMat2(UniformHandle handle, const glm::mat2 &mat) const
+	{
+		glUniformMatrix2fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+	}
+	void setMat3(UniformHandle handle, const glm::mat3 &mat) const
+	{
+		glUniformMatrix3fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+	}
+	void setMat4(UniformHandle handle, const glm::mat4 &mat) const
+	{
+		glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]);
 	}
 
 private:
+	// active uniform name -> location, filled once after linking
+	std::unordered_map<std::string, GLint> uniformLocations;
+
+	// reads all active uniforms of the linked program. Arrays are registered with every element
+	// ("lights[1].position"), and also under the base name without "[0]", same as GL accepts them
+	// ------------------------------------------------------------------------
+	void cacheUniformLocations()
+	{
+		GLint numUniforms = 0;
+		GLint maxNameLength = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &numUniforms);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+		std::string nameBuffer(maxNameLength > 0 ? maxNameLength : 1, '\0');
+		for (GLint i = 0; i < numUniforms; i++)
+		{
+			GLsizei nameLength = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(ID, (GLuint)i, maxNameLength, &nameLength, &size, &type, &nameBuffer[0]);
+			std::string name(nameBuffer.c_str(), nameLength);
+
+			const GLint location = glGetUniformLocation(ID, name.c_str());
+			if (location == -1)
+				continue; // uniform from a uniform block, no location
+
+			uniformLocations[name] = location;
+			if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			{
+				const std::string baseName = name.substr(0, name.size() - 3);
+				uniformLocations[baseName] = location;
+				// array elements have consecutive locations, but ask GL to be safe
+				for (GLint element = 1; element < size; element++)
+				{
+					const std::string elementName = baseName + "[" + std::to_string(element) + "]";
+					uniformLocations[elementName] = glGetUniformLocation(ID, elementName.c_str());
+				}
+			}
+		}
+	}
+	// returns cached location of the uniform, or -1 (ignored by glUniform*) if there's no such active uniform
+	// ------------------------------------------------------------------------
+	GLint getUniformLocation(const std::string &name) const
+	{
+		const auto it = uniformLocations.find(name);
+		if (it == uniformLocations.end())
+		{
+			uniformLookupMisses++;
+			return -1;
+		}
+		return it->second;
+	}
+	// inserts the defines after the #version line (which must stay first), #line keeps compiler messages
+	// pointing at the lines of the original file
+	// ------------------------------------------------------------------------
+	static std::string insertDefines(const std::string& code, const std::vector<std::string>& defines)
+	{
+		size_t insertAt = 0;
+		int nextLine = 1;
+		const size_t versionBegin = code.find("#version");
+		if (versionBegin != std::string::npos && code.find_first_not_of(" \t\r\n", 0) == versionBegin)
+		{
+			const size_t versionEnd = code.find('\n', versionBegin);
+			insertAt = versionEnd == std::string::npos ? code.size() : versionEnd + 1;
+			for (size_t i = 0; i < insertAt; i++)
+			{
+				if (code[i] == '\n')
+					nextLine++;
+			}
+		}
+
+		std::string block = insertAt > 0 && code[insertAt - 1] != '\n' ? "\n" : "";
+		for (const auto& define : defines)
+			block += "#define " + define + "\n";
+		block += "#line " + std::to_string(nextLine) + "\n";
+		return code.substr(0, insertAt) + block + code.substr(insertAt);
+	}
 	// utility function for checking shader compilation/linking errors.
 	// ------------------------------------------------------------------------
 	void checkCompileErrors(GLuint shader, std::string type)
@@ -189,6 +355,56 @@ private:
 		}
 	}
 };
+
+// compiles the same shader files with different sets of defines (e.g. one per light permutation), every
+// variant is built on its first use and kept, so switching between them per draw costs only a lookup
+class ShaderVariants
+{
+public:
+	// onCreated is called with every new variant, e.g. to bind its uniform blocks and samplers
+	// ------------------------------------------------------------------------
+	ShaderVariants(const char* vertexPath, const char* fragmentPath, std::function<void(Shader&)> onCreated = nullptr)
+		: vertexPath(vertexPath)
+		, fragmentPath(fragmentPath)
+		, onCreated(onCreated)
+	{
+	}
+	// returns the program compiled with given defines ("NAME" or "NAME VALUE"), compiling it on first use
+	// ------------------------------------------------------------------------
+	Shader& get(const std::vector<std::string>& defines)
+	{
+		std::string key;
+		for (const auto& define : defines)
+		{
+			key += define;
+			key += '\n';
+		}
+
+		const auto it = variants.find(key);
+		if (it != variants.end())
+			return *it->second;
+
+		std::unique_ptr<Shader> shader(new Shader(vertexPath.c_str(), fragmentPath.c_str(), nullptr, defines));
+		if (onCreated)
+			onCreated(*shader);
+		Shader& variant = *shader;
+		variants.emplace(key, std::move(shader));
+		return variant;
+	}
+	// number of variants compiled so far
+	// ------------------------------------------------------------------------
+	size_t size() const
+	{
+		return variants.size();
+	}
+
+private:
+	std::string vertexPath;
+	std::string fragmentPath;
+	std::function<void(Shader&)> onCreated;
+	// defines joined by new lines -> compiled program
+	std::unordered_map<std::string, std::unique_ptr<Shader>> variants;
+};
 #endif
 //#ifndef SHADER_H
 //#define SHADER_H
@@ -204,7 +420,7 @@ private:
 //{
 //public:
 //	unsigned int ID;
-//	// constructor generates the shader on the fly
+//	// constructor generates the shader on the fly, or loads the program binary cached by the previous launch
 //	// ------------------------------------------------------------------------
 //	Shader(const char* vertexPath, const char* fragmentPath)
 //	{
@@ -7,57 +7,92 @@ struct Material {
     float shininess;
 }; 
 
+// light structures live in the LightBlock uniform buffer (std140), mirrored in lights.h
+// every vec3 is followed by a float, so that the C++ structs need no hidden padding
 struct DirLight {
     vec3 direction;
-	
+    float padding0;
     vec3 ambient;
+    float padding1;
     vec3 diffuse;
+    float padding2;
     vec3 specular;
+    float padding3;
 };
 
 struct PointLight {
     vec3 position;
-    
     float constant;
-    float linear;
-    float quadratic;
-	
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
+    float padding;
 };
 
 struct SpotLight {
     vec3 position;
-    vec3 direction;
     float cutOff;
+    vec3 direction;
     float outerCutOff;
-  
+    vec3 ambient;
     float constant;
+    vec3 diffuse;
     float linear;
+    vec3 specular;
     float quadratic;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;       
 };
 
-#define NR_POINT_LIGHTS 4
+// light permutation, injected from C++ by ShaderVariants (see LightPermutation in lights.h).
+// the block always has room for MAX_POINT_LIGHTS, so that its layout is the same for every variant,
+// only the first NR_POINT_LIGHTS are evaluated. without defines all lights are evaluated
+#ifndef MAX_POINT_LIGHTS
+#define MAX_POINT_LIGHTS 4
+#endif
+#ifndef NR_POINT_LIGHTS
+#define NR_POINT_LIGHTS MAX_POINT_LIGHTS
+#endif
+#ifndef HAS_DIR_LIGHT
+#define HAS_DIR_LIGHT 1
+#endif
+#ifndef HAS_SPOT_LIGHT
+#define HAS_SPOT_LIGHT 1
+#endif
+#ifndef CLUSTERED_LIGHTS
+#define CLUSTERED_LIGHTS 0
+#endif
 
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
+layout (std140) uniform LightBlock {
+    DirLight dirLight;
+    PointLight pointLights[MAX_POINT_LIGHTS];
+    SpotLight spotLight;
+};
+
 uniform vec3 viewPos;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight spotLight;
 uniform Material material;
 
+#if CLUSTERED_LIGHTS
+// many point lights, assigned on the CPU to froxels (screen tile x depth slice) of the view, see ClusteredLights
+// in clusteredLights.h. fragments evaluate only the lights of their froxel
+uniform samplerBuffer clusterLights;   // 4 texels per light laid out as PointLight, padding holds range of the light
+uniform usamplerBuffer clusterGrid;    // offset and count of the lights of every froxel
+uniform usamplerBuffer clusterIndices; // light indices of all froxels
+uniform vec2 clusterTileScale;         // froxel tiles per pixel
+uniform vec4 clusterDepthParams;       // view depth = 1 / (x + y * window depth), slice = log(view depth) * z + w
+#endif
+
 // function prototypes
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+#if CLUSTERED_LIGHTS
+vec3 CalcClusteredPointLights(vec3 normal, vec3 fragPos, vec3 viewDir);
+#endif
 
 void main()
 {    
@@ -71,13 +106,24 @@ void main()
     // per lamp. In the main() function we take all the calculated colors and sum them up for
     // this fragment's final color.
     // == =====================================================
+    // phases of lights missing from this permutation are compiled out
+    vec3 result = vec3(0.0);
     // phase 1: directional lighting
-    vec3 result = CalcDirLight(dirLight, norm, viewDir);
+#if HAS_DIR_LIGHT
+    result += CalcDirLight(dirLight, norm, viewDir);
+#endif
     // phase 2: point lights
+#if NR_POINT_LIGHTS > 0
     for(int i = 0; i < NR_POINT_LIGHTS; i++)
         result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+#endif
+#if CLUSTERED_LIGHTS
+    result += CalcClusteredPointLights(norm, FragPos, viewDir);
+#endif
     // phase 3: spot light
+#if HAS_SPOT_LIGHT
     result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
+#endif
     
     FragColor = vec4(result, 1.0);
 }
@@ -144,4 +190,33 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
     return (ambient + diffuse + specular);
-}
\ No newline at end of file
+}
+
+#if CLUSTERED_LIGHTS
+// calculates the color of the clustered point lights reaching the froxel of the fragment.
+vec3 CalcClusteredPointLights(vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    // froxel of the fragment, its depth slice is found from the linearized window depth
+    float depth = 1.0 / (clusterDepthParams.x + clusterDepthParams.y * gl_FragCoord.z);
+    ivec2 tile = min(ivec2(gl_FragCoord.xy * clusterTileScale), ivec2(CLUSTER_GRID_SIZE_X - 1, CLUSTER_GRID_SIZE_Y - 1));
+    int slice = clamp(int(floor(log(depth) * clusterDepthParams.z + clusterDepthParams.w)), 0, CLUSTER_GRID_SIZE_Z - 1);
+    uvec2 cluster = texelFetch(clusterGrid, tile.x + CLUSTER_GRID_SIZE_X * (tile.y + CLUSTER_GRID_SIZE_Y * slice)).xy;
+
+    vec3 result = vec3(0.0);
+    for(uint i = 0u; i < cluster.y; i++)
+    {
+        int texel = int(texelFetch(clusterIndices, int(cluster.x + i)).r) * 4;
+        vec4 positionConstant = texelFetch(clusterLights, texel);
+        vec4 ambientLinear = texelFetch(clusterLights, texel + 1);
+        vec4 diffuseQuadratic = texelFetch(clusterLights, texel + 2);
+        vec4 specularRange = texelFetch(clusterLights, texel + 3);
+        // beyond its range the light is dropped, so that it's the same in every froxel it reaches
+        if (distance(positionConstant.xyz, fragPos) > specularRange.w)
+            continue;
+        PointLight light = PointLight(positionConstant.xyz, positionConstant.w, ambientLinear.xyz, ambientLinear.w,
+            diffuseQuadratic.xyz, diffuseQuadratic.w, specularRange.xyz, specularRange.w);
+        result += CalcPointLight(light, normal, fragPos, viewDir);
+    }
+    return result;
+}
+#endif
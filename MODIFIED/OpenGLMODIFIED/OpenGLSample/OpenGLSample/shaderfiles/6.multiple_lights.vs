@@ -3,18 +3,31 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+// normal matrix (transposed inverse of the model matrix) is computed on the CPU, see computeNormalMatrix
+// INSTANCED takes model and normal matrix per instance (see InstancedMesh) instead of the uniforms
+#ifdef INSTANCED
+layout (location = 8) in mat4 instanceModel;
+layout (location = 12) in mat3 instanceNormalMatrix;
+#endif
+
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
 uniform mat4 model;
+uniform mat3 normalMatrix;
 uniform mat4 view;
 uniform mat4 projection;
 
 void main()
 {
+#ifdef INSTANCED
+    FragPos = vec3(instanceModel * vec4(aPos, 1.0));
+    Normal = instanceNormalMatrix * aNormal;
+#else
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    Normal = normalMatrix * aNormal;
+#endif
     TexCoords = aTexCoords;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
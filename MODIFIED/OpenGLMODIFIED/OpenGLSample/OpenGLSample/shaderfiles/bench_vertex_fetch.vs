@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoords;
+layout (location = 2) in vec3 aNormal;
+
+out vec4 Color;
+
+// every attribute contributes to the output, so that none of them can be skipped by the driver
+void main()
+{
+    gl_Position = vec4(aPos * 0.001, 1.0);
+    Color = vec4(aNormal * 0.5 + 0.5, aTexCoords.x);
+}
@@ -0,0 +1,113 @@
+// STL
+#include <iostream>
+#include <cstring>
+
+// Project
+#include "staticMeshCache.h"
+
+namespace static_meshes_3D {
+
+	namespace {
+
+		// Combines hash of the value into seed (same mixing as boost::hash_combine)
+		void hashCombine(size_t& seed, size_t value)
+		{
+			seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		}
+
+		size_t hashFloat(float value)
+		{
+			// Adding zero turns -0.0f into 0.0f, so that equal keys always hash the same
+			value += 0.0f;
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			return std::hash<uint32_t>()(bits);
+		}
+
+	} // namespace
+
+	bool StaticMeshCache::Key::operator==(const Key& other) const
+	{
+		return type == other.type
+			&& radius == other.radius
+			&& numSlices == other.numSlices
+			&& height == other.height
+			&& attributeMask == other.attributeMask
+			&& packing == other.packing;
+	}
+
+	size_t StaticMeshCache::KeyHash::operator()(const Key& key) const
+	{
+		size_t seed = std::hash<uint8_t>()(static_cast<uint8_t>(key.type));
+		hashCombine(seed, hashFloat(key.radius));
+		hashCombine(seed, std::hash<int>()(key.numSlices));
+		hashCombine(seed, hashFloat(key.height));
+		hashCombine(seed, std::hash<uint8_t>()(key.attributeMask));
+		hashCombine(seed, std::hash<int>()(static_cast<int>(key.packing)));
+		return seed;
+	}
+
+	uint8_t StaticMeshCache::getAttributeMask(bool withPositions, bool withTextureCoordinates, bool withNormals)
+	{
+		return (withPositions ? 1 : 0) | (withTextureCoordinates ? 2 : 0) | (withNormals ? 4 : 0);
+	}
+
+	std::shared_ptr<const Cylinder> StaticMeshCache::getCylinder(float radius, int numSlices, float height,
+		bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout::Packing packing)
+	{
+		const Key key{ MeshType::Cylinder, radius, numSlices, height, getAttributeMask(withPositions, withTextureCoordinates, withNormals), packing };
+
+		const auto it = _meshes.find(key);
+		if (it != _meshes.end())
+		{
+			_hits++;
+			return std::static_pointer_cast<const Cylinder>(it->second);
+		}
+
+		_misses++;
+		std::cout << "Building cylinder mesh with radius " << radius << ", " << numSlices << " slices and height " << height << std::endl;
+		auto cylinder = std::make_shared<Cylinder>(radius, numSlices, height, withPositions, withTextureCoordinates, withNormals, packing);
+		_meshes.emplace(key, cylinder);
+		return cylinder;
+	}
+
+	size_t StaticMeshCache::releaseUnused()
+	{
+		size_t released = 0;
+		for (auto it = _meshes.begin(); it != _meshes.end();)
+		{
+			// Only reference left is the one held by the cache
+			if (it->second.use_count() == 1)
+			{
+				it = _meshes.erase(it);
+				released++;
+			}
+			else {
+				++it;
+			}
+		}
+
+		return released;
+	}
+
+	void StaticMeshCache::clear()
+	{
+		_meshes.clear();
+	}
+
+	size_t StaticMeshCache::getHits() const
+	{
+		return _hits;
+	}
+
+	size_t StaticMeshCache::getMisses() const
+	{
+		return _misses;
+	}
+
+	size_t StaticMeshCache::getSize() const
+	{
+		return _meshes.size();
+	}
+
+} // namespace static_meshes_3D
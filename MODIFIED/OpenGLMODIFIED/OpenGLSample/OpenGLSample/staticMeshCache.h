@@ -0,0 +1,86 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+// Project
+#include "cylinder.h"
+
+namespace static_meshes_3D {
+
+	/**
+	 * Registry of shared static meshes. Meshes are keyed on their type and build parameters,
+	 * so asking for the same geometry twice hands back the same (immutable) GPU mesh instead
+	 * of generating and uploading it again. Meshes are reference counted, cache itself holds
+	 * one reference until releaseUnused() or clear() is called.
+	 */
+	class StaticMeshCache
+	{
+	public:
+		/**
+		 * Gets cylinder with given parameters. Geometry is built and uploaded on the first request only.
+		 */
+		std::shared_ptr<const Cylinder> getCylinder(float radius, int numSlices, float height,
+			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true,
+			VertexLayout::Packing packing = VertexLayout::Packing::Interleaved);
+
+		/**
+		 * Releases all meshes, that are not referenced from outside of the cache anymore.
+		 *
+		 * @return Number of released meshes
+		 */
+		size_t releaseUnused();
+
+		/**
+		 * Drops all cached meshes (must be called while OpenGL context is still alive).
+		 */
+		void clear();
+
+		/**
+		 * Gets number of requests, that were served from the cache.
+		 */
+		size_t getHits() const;
+
+		/**
+		 * Gets number of requests, that had to build a new mesh.
+		 */
+		size_t getMisses() const;
+
+		/**
+		 * Gets number of meshes currently held by the cache.
+		 */
+		size_t getSize() const;
+
+	private:
+		enum class MeshType : uint8_t
+		{
+			Cylinder
+		};
+
+		struct Key
+		{
+			MeshType type;
+			float radius;
+			int numSlices;
+			float height;
+			uint8_t attributeMask;
+			VertexLayout::Packing packing;
+
+			bool operator==(const Key& other) const;
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const;
+		};
+
+		std::unordered_map<Key, std::shared_ptr<StaticMesh3D>, KeyHash> _meshes; // Cached meshes
+		size_t _hits = 0; // How many requests were served from the cache
+		size_t _misses = 0; // How many requests had to build a new mesh
+
+		static uint8_t getAttributeMask(bool withPositions, bool withTextureCoordinates, bool withNormals);
+	};
+
+} // namespace static_meshes_3D
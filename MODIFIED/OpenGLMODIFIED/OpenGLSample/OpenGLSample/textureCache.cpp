@@ -0,0 +1,325 @@
+// STL
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+// Project
+#include "textureCache.h"
+#include "common/glState.h"
+#include "common/hash.h"
+#include "common/mappedFile.h"
+
+Texture::Texture(GLuint textureID, const std::string& path, uint64_t contentHash, bool isSRGB)
+	: _textureID(textureID)
+	, _path(path)
+	, _contentHash(contentHash)
+	, _isSRGB(isSRGB)
+{
+}
+
+Texture::~Texture()
+{
+	GLState::deleteTextures(1, &_textureID);
+}
+
+GLuint Texture::getID() const
+{
+	return _textureID;
+}
+
+const std::string& Texture::getPath() const
+{
+	return _path;
+}
+
+uint64_t Texture::getContentHash() const
+{
+	return _contentHash;
+}
+
+bool Texture::isSRGB() const
+{
+	return _isSRGB;
+}
+
+bool Texture::isLoaded() const
+{
+	return _isLoaded;
+}
+
+int Texture::getWidth() const
+{
+	return _width;
+}
+
+int Texture::getHeight() const
+{
+	return _height;
+}
+
+int Texture::getNumComponents() const
+{
+	return _numComponents;
+}
+
+size_t Texture::getMemorySize() const
+{
+	return _memorySize;
+}
+
+bool TextureCache::ContentKey::operator==(const ContentKey& other) const
+{
+	return hash == other.hash && size == other.size && isSRGB == other.isSRGB;
+}
+
+size_t TextureCache::ContentKeyHash::operator()(const ContentKey& key) const
+{
+	return static_cast<size_t>(key.hash ^ (key.size * 0x9E3779B97F4A7C15ULL)) ^ size_t(key.isSRGB);
+}
+
+TextureCache::TextureCache(AsyncTextureLoader& loader)
+	: _loader(loader)
+{
+}
+
+TextureCache::~TextureCache()
+{
+	// Textures can't be deleted without OpenGL context, clear() should have been called already
+	if (!_textures.empty() || _missingTexture) {
+		std::cerr << "Texture cache destroyed with " << _textures.size() << " textures, clear() was not called!" << std::endl;
+	}
+}
+
+std::shared_ptr<const Texture> TextureCache::get(const std::string& path, bool isSRGB)
+{
+	const auto normalizedPath = normalizePath(path);
+	auto& pathTextures = _pathTextures[isSRGB];
+	const auto pathIt = pathTextures.find(normalizedPath);
+	if (pathIt != pathTextures.end())
+	{
+		_hits++;
+		return _textures.at(pathIt->second);
+	}
+
+	// Image is hashed before anything is decoded, so that copies of one file are uploaded only once
+	MappedFile file;
+	if (!file.open(normalizedPath.c_str()))
+	{
+		_numMissingFiles++;
+		std::cerr << "!!! TEXTURE FILE NOT FOUND: " << path << " (using checkerboard texture instead) !!!" << std::endl;
+		return getMissingTexture();
+	}
+
+	const ContentKey contentKey{ hashData(file.getData(), file.getSize()), file.getSize(), isSRGB };
+	file.close();
+	const auto contentIt = _contentTextures.find(contentKey);
+	if (contentIt != _contentTextures.end())
+	{
+		_hits++;
+		const auto& texture = _textures.at(contentIt->second);
+		std::cout << "Texture " << path << " has the same contents as " << texture->getPath() << ", sharing it" << std::endl;
+		pathTextures.emplace(normalizedPath, contentIt->second);
+		return texture;
+	}
+
+	_misses++;
+	std::cout << "Texture cache miss, loading " << path << std::endl;
+	const auto textureID = _loader.load(normalizedPath, isSRGB);
+	std::shared_ptr<Texture> texture(new Texture(textureID, normalizedPath, contentKey.hash, isSRGB));
+	_textures.emplace(textureID, texture);
+	pathTextures.emplace(normalizedPath, textureID);
+	_contentTextures.emplace(contentKey, textureID);
+	return texture;
+}
+
+size_t TextureCache::update(size_t maxUploadBytes)
+{
+	_loadedTextures.clear();
+	const auto numReady = _loader.update(maxUploadBytes, &_loadedTextures);
+	for (const auto& loadedTexture : _loadedTextures)
+	{
+		const auto it = _textures.find(loadedTexture.textureID);
+		if (it == _textures.end()) {
+			continue;
+		}
+
+		auto& texture = *it->second;
+		texture._isPending = false;
+		texture._isLoaded = loadedTexture.isLoaded;
+		texture._width = loadedTexture.width;
+		texture._height = loadedTexture.height;
+		texture._numComponents = loadedTexture.numComponents;
+		texture._memorySize = loadedTexture.memorySize;
+	}
+
+	return numReady;
+}
+
+size_t TextureCache::releaseUnused()
+{
+	size_t released = 0;
+	for (auto it = _textures.begin(); it != _textures.end();)
+	{
+		// Only reference left is the one held by the cache, textures still loading are kept,
+		// otherwise the loader would upload into a deleted texture
+		const auto& texture = it->second;
+		if (texture.use_count() > 1 || texture->_isPending)
+		{
+			++it;
+			continue;
+		}
+
+		const auto textureID = it->first;
+		auto& pathTextures = _pathTextures[texture->_isSRGB];
+		for (auto pathIt = pathTextures.begin(); pathIt != pathTextures.end();)
+		{
+			if (pathIt->second == textureID) {
+				pathIt = pathTextures.erase(pathIt);
+			}
+			else {
+				++pathIt;
+			}
+		}
+		for (auto contentIt = _contentTextures.begin(); contentIt != _contentTextures.end();)
+		{
+			if (contentIt->second == textureID) {
+				contentIt = _contentTextures.erase(contentIt);
+			}
+			else {
+				++contentIt;
+			}
+		}
+
+		it = _textures.erase(it);
+		released++;
+	}
+
+	return released;
+}
+
+void TextureCache::clear()
+{
+	for (auto& pathTextures : _pathTextures) {
+		pathTextures.clear();
+	}
+	_contentTextures.clear();
+	_textures.clear();
+	_missingTexture.reset();
+}
+
+size_t TextureCache::getHits() const
+{
+	return _hits;
+}
+
+size_t TextureCache::getMisses() const
+{
+	return _misses;
+}
+
+size_t TextureCache::getNumMissingFiles() const
+{
+	return _numMissingFiles;
+}
+
+size_t TextureCache::getSize() const
+{
+	return _textures.size();
+}
+
+size_t TextureCache::getMemorySize() const
+{
+	size_t memorySize = 0;
+	for (const auto& entry : _textures) {
+		memorySize += entry.second->getMemorySize();
+	}
+	return memorySize;
+}
+
+void TextureCache::printMemoryUsage() const
+{
+	// Sorted by path, so that the report is stable between runs
+	std::vector<const Texture*> textures;
+	for (const auto& entry : _textures) {
+		textures.push_back(entry.second.get());
+	}
+	std::sort(textures.begin(), textures.end(), [](const Texture* a, const Texture* b) { return a->getPath() < b->getPath(); });
+
+	std::cout << "Texture memory usage (" << textures.size() << " textures, " << _hits << " hits, " << _misses << " misses, "
+		<< _numMissingFiles << " missing files):" << std::endl;
+	for (const auto texture : textures)
+	{
+		const auto& entry = *_textures.find(texture->getID());
+		std::cout << "  " << texture->getPath() << ": ";
+		if (texture->isLoaded()) {
+			std::cout << texture->getWidth() << "x" << texture->getHeight() << "x" << texture->getNumComponents() << ", "
+				<< std::fixed << std::setprecision(1) << texture->getMemorySize() / 1024.0 << " KiB";
+		}
+		else {
+			std::cout << (texture->_isPending ? "loading" : "failed to load");
+		}
+		std::cout << ", " << entry.second.use_count() - 1 << " references" << std::endl;
+	}
+	std::cout << "  total: " << std::fixed << std::setprecision(1) << getMemorySize() / (1024.0 * 1024.0) << " MiB" << std::endl;
+	std::cout.unsetf(std::ios_base::floatfield);
+}
+
+std::shared_ptr<Texture> TextureCache::getMissingTexture()
+{
+	if (_missingTexture) {
+		return _missingTexture;
+	}
+
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	const unsigned char checkerboard[16] = {
+		255, 0, 255, 255,  0, 0, 0, 255,
+		0, 0, 0, 255,  255, 0, 255, 255
+	};
+	GLState::bindTexture(GL_TEXTURE_2D, textureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, checkerboard);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	_missingTexture.reset(new Texture(textureID, "<missing>", 0, true));
+	_missingTexture->_isPending = false;
+	return _missingTexture;
+}
+
+std::string TextureCache::normalizePath(const std::string& path)
+{
+	std::string unified = path;
+	std::replace(unified.begin(), unified.end(), '\\', '/');
+
+	// Split into parts, dropping "." and resolving "dir/.." (leading ".." parts are kept)
+	std::vector<std::string> parts;
+	size_t begin = 0;
+	while (begin <= unified.size())
+	{
+		auto end = unified.find('/', begin);
+		if (end == std::string::npos) {
+			end = unified.size();
+		}
+
+		const auto part = unified.substr(begin, end - begin);
+		if (part == ".." && !parts.empty() && parts.back() != ".." && !parts.back().empty()) {
+			parts.pop_back();
+		}
+		else if (part != "." && !(part.empty() && !parts.empty())) {
+			parts.push_back(part);
+		}
+		begin = end + 1;
+	}
+
+	std::string normalized;
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		if (i > 0) {
+			normalized += '/';
+		}
+		normalized += parts[i];
+	}
+	return normalized;
+}
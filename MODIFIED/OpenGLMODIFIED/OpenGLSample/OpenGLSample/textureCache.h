@@ -0,0 +1,197 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// Project
+#include "textureLoader.h"
+
+/**
+ * 2D texture shared through TextureCache. Texture object is deleted together with the last reference,
+ * so all references must be dropped while OpenGL context is still alive.
+ */
+class Texture
+{
+public:
+	~Texture();
+
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+
+	/**
+	 * Gets OpenGL texture ID (valid right away, placeholder image is shown until the real one is uploaded).
+	 */
+	GLuint getID() const;
+
+	/**
+	 * Gets path, under which the texture was requested first.
+	 */
+	const std::string& getPath() const;
+
+	/**
+	 * Gets hash of the image file contents.
+	 */
+	uint64_t getContentHash() const;
+
+	/**
+	 * Checks, if color channels of the image are sRGB encoded (false for data like specular maps).
+	 */
+	bool isSRGB() const;
+
+	/**
+	 * Checks, if the real image has been uploaded (false while loading or if decoding failed).
+	 */
+	bool isLoaded() const;
+
+	int getWidth() const;
+	int getHeight() const;
+	int getNumComponents() const;
+
+	/**
+	 * Gets video memory taken by the texture including mipmaps (in bytes, 0 until it's loaded). Exact for
+	 * cooked textures, estimated for the decoded ones.
+	 */
+	size_t getMemorySize() const;
+
+private:
+	friend class TextureCache;
+
+	Texture(GLuint textureID, const std::string& path, uint64_t contentHash, bool isSRGB);
+
+	GLuint _textureID; // OpenGL texture ID
+	std::string _path; // Path, under which the texture was requested first
+	uint64_t _contentHash; // Hash of the image file contents
+	bool _isSRGB; // Whether color channels are sRGB encoded
+	bool _isPending = true; // True until the loader reports the image as processed
+	bool _isLoaded = false; // True, if the real image has been uploaded
+	int _width = 0; // Image width
+	int _height = 0; // Image height
+	int _numComponents = 0; // Number of color components (1-4)
+	size_t _memorySize = 0; // Video memory taken by all levels
+};
+
+/**
+ * Registry of shared textures. Textures are keyed on their normalized path and on the contents of the
+ * image file, so asking for the same image twice (even through another path or from a copied file)
+ * hands back the same texture instead of decoding and uploading it again. Image used both as sRGB
+ * and as linear data gets a texture for each. Textures are reference
+ * counted, cache itself holds one reference until releaseUnused() or clear() is called.
+ * Missing image files are reported on stderr and get a shared magenta/black checkerboard texture.
+ */
+class TextureCache
+{
+public:
+	/**
+	 * @param loader  Loader used to decode and upload new textures (must outlive the cache)
+	 */
+	explicit TextureCache(AsyncTextureLoader& loader);
+
+	~TextureCache();
+
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator=(const TextureCache&) = delete;
+
+	/**
+	 * Gets texture with given image file. File is decoded and uploaded on the first request only.
+	 *
+	 * @param path    Path to the image file
+	 * @param isSRGB  Whether color channels are sRGB encoded (false for data like specular or normal maps)
+	 *
+	 * @return Shared texture, never nullptr (missing files get the checkerboard texture).
+	 */
+	std::shared_ptr<const Texture> get(const std::string& path, bool isSRGB = true);
+
+	/**
+	 * Uploads decoded images through the loader and records their sizes (OpenGL thread only, once per frame).
+	 *
+	 * @param maxUploadBytes  Upload budget, see AsyncTextureLoader::update()
+	 *
+	 * @return Number of textures, that became ready.
+	 */
+	size_t update(size_t maxUploadBytes = 0);
+
+	/**
+	 * Releases all textures, that are not referenced from outside of the cache anymore
+	 * (textures still being loaded are kept).
+	 *
+	 * @return Number of released textures
+	 */
+	size_t releaseUnused();
+
+	/**
+	 * Drops all cached textures (must be called while OpenGL context is still alive).
+	 */
+	void clear();
+
+	/**
+	 * Gets number of requests, that were served from the cache (by path or by contents).
+	 */
+	size_t getHits() const;
+
+	/**
+	 * Gets number of requests, that had to load a new texture.
+	 */
+	size_t getMisses() const;
+
+	/**
+	 * Gets number of requests for image files, that could not be opened.
+	 */
+	size_t getNumMissingFiles() const;
+
+	/**
+	 * Gets number of textures currently held by the cache.
+	 */
+	size_t getSize() const;
+
+	/**
+	 * Gets video memory taken by all cached textures (in bytes, see Texture::getMemorySize).
+	 */
+	size_t getMemorySize() const;
+
+	/**
+	 * Prints memory taken by every cached texture and in total.
+	 */
+	void printMemoryUsage() const;
+
+private:
+	struct ContentKey
+	{
+		uint64_t hash; // Hash of the image file contents
+		uint64_t size; // Size of the image file
+		bool isSRGB; // Whether the image is used as sRGB
+
+		bool operator==(const ContentKey& other) const;
+	};
+
+	struct ContentKeyHash
+	{
+		size_t operator()(const ContentKey& key) const;
+	};
+
+	AsyncTextureLoader& _loader; // Loader used for new textures
+	std::unordered_map<GLuint, std::shared_ptr<Texture>> _textures; // Cached textures by their IDs
+	std::unordered_map<std::string, GLuint> _pathTextures[2]; // Texture ID for every requested (normalized) path, linear ones first
+	std::unordered_map<ContentKey, GLuint, ContentKeyHash> _contentTextures; // Texture ID for every loaded file contents
+	std::shared_ptr<Texture> _missingTexture; // Checkerboard texture for missing files (created on first use)
+	std::vector<AsyncTextureLoader::LoadedTexture> _loadedTextures; // Textures reported by the last update (kept to reuse memory)
+	size_t _hits = 0; // How many requests were served from the cache
+	size_t _misses = 0; // How many requests had to load a new texture
+	size_t _numMissingFiles = 0; // How many requests were for files, that could not be opened
+
+	/**
+	 * Gets checkerboard texture used for missing files.
+	 */
+	std::shared_ptr<Texture> getMissingTexture();
+
+	/**
+	 * Unifies path separators and removes "." and "dir/.." parts, so that equal paths give equal keys.
+	 */
+	static std::string normalizePath(const std::string& path);
+};
@@ -0,0 +1,276 @@
+// STL
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURECOOKER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// STB
+#include "stb_image.h"
+
+// Project
+#include "textureCooker.h"
+#include "common/fileUtils.h"
+#include "common/textureFile.h"
+
+namespace {
+
+	/**
+	 * Conversion tables between 8-bit sRGB values and linear intensities.
+	 */
+	struct SRGBTables
+	{
+		float toLinear[256]; // Linear intensity of every sRGB value
+		float thresholds[255]; // Linear intensity halfway between neighbouring sRGB values
+
+		SRGBTables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				const auto value = i / 255.0f;
+				toLinear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+			}
+			for (int i = 0; i < 255; i++) {
+				thresholds[i] = (toLinear[i] + toLinear[i + 1]) * 0.5f;
+			}
+		}
+	};
+
+	const SRGBTables& getSRGBTables()
+	{
+		static const SRGBTables tables;
+		return tables;
+	}
+
+	/**
+	 * Source pixels and weights of one output pixel along one axis.
+	 */
+	struct FilterTaps
+	{
+		int count; // Number of used taps (1-3)
+		int indices[3]; // Source pixel indices
+		float weights[3]; // Weights of the source pixels (sum to 1)
+	};
+
+	/**
+	 * Builds box filter taps halving given size. Odd sizes get 3 taps per output pixel, so that
+	 * every source pixel contributes by the same total weight.
+	 */
+	std::vector<FilterTaps> buildBoxFilterTaps(int sourceSize)
+	{
+		const auto size = std::max(sourceSize / 2, 1);
+		std::vector<FilterTaps> taps(size);
+		for (int i = 0; i < size; i++)
+		{
+			auto& tap = taps[i];
+			if (sourceSize == 1) {
+				tap = FilterTaps{ 1, { 0, 0, 0 }, { 1.0f, 0.0f, 0.0f } };
+			}
+			else if (sourceSize % 2 == 0) {
+				tap = FilterTaps{ 2, { 2 * i, 2 * i + 1, 0 }, { 0.5f, 0.5f, 0.0f } };
+			}
+			else
+			{
+				const auto inverseSourceSize = 1.0f / sourceSize;
+				tap = FilterTaps{ 3, { 2 * i, 2 * i + 1, 2 * i + 2 },
+					{ (size - i) * inverseSourceSize, size * inverseSourceSize, (i + 1) * inverseSourceSize } };
+			}
+		}
+		return taps;
+	}
+
+	/**
+	 * Halves image of linear RGBA pixels (4 floats per pixel, one SSE register).
+	 */
+	void downsample(const std::vector<float>& source, int sourceWidth, int sourceHeight, std::vector<float>& destination)
+	{
+		const auto tapsX = buildBoxFilterTaps(sourceWidth);
+		const auto tapsY = buildBoxFilterTaps(sourceHeight);
+		const auto width = int(tapsX.size());
+		const auto height = int(tapsY.size());
+		destination.resize(size_t(width) * height * 4);
+
+		for (int y = 0; y < height; y++)
+		{
+			const auto& tapY = tapsY[y];
+			for (int x = 0; x < width; x++)
+			{
+				const auto& tapX = tapsX[x];
+				auto output = &destination[(size_t(y) * width + x) * 4];
+#ifdef TEXTURECOOKER_USE_SSE2
+				auto sum = _mm_setzero_ps();
+				for (int ty = 0; ty < tapY.count; ty++)
+				{
+					const auto row = &source[size_t(tapY.indices[ty]) * sourceWidth * 4];
+					for (int tx = 0; tx < tapX.count; tx++)
+					{
+						const auto weight = _mm_set1_ps(tapY.weights[ty] * tapX.weights[tx]);
+						sum = _mm_add_ps(sum, _mm_mul_ps(weight, _mm_loadu_ps(row + tapX.indices[tx] * 4)));
+					}
+				}
+				_mm_storeu_ps(output, sum);
+#else
+				std::fill(output, output + 4, 0.0f);
+				for (int ty = 0; ty < tapY.count; ty++)
+				{
+					const auto row = &source[size_t(tapY.indices[ty]) * sourceWidth * 4];
+					for (int tx = 0; tx < tapX.count; tx++)
+					{
+						const auto weight = tapY.weights[ty] * tapX.weights[tx];
+						const auto input = row + tapX.indices[tx] * 4;
+						for (int c = 0; c < 4; c++) {
+							output[c] += weight * input[c];
+						}
+					}
+				}
+#endif
+			}
+		}
+	}
+
+	/**
+	 * Gets number of color channels (that are sRGB encoded in sRGB images), the rest is alpha.
+	 */
+	int getNumColorChannels(int numComponents)
+	{
+		return numComponents == 2 || numComponents == 4 ? numComponents - 1 : numComponents;
+	}
+
+	/**
+	 * Converts 8-bit pixels to linear RGBA floats.
+	 */
+	void toLinearImage(const unsigned char* pixels, size_t numPixels, int numComponents, bool isSRGB, std::vector<float>& image)
+	{
+		const auto& tables = getSRGBTables();
+		const auto numSRGBChannels = isSRGB ? getNumColorChannels(numComponents) : 0;
+		image.assign(numPixels * 4, 0.0f);
+		for (size_t i = 0; i < numPixels; i++)
+		{
+			for (int c = 0; c < numComponents; c++)
+			{
+				const auto value = pixels[i * numComponents + c];
+				image[i * 4 + c] = c < numSRGBChannels ? tables.toLinear[value] : value / 255.0f;
+			}
+		}
+	}
+
+	/**
+	 * Converts linear RGBA floats back to 8-bit pixels.
+	 */
+	void toPixels(const std::vector<float>& image, int numComponents, bool isSRGB, std::vector<unsigned char>& pixels)
+	{
+		const auto& tables = getSRGBTables();
+		const auto numSRGBChannels = isSRGB ? getNumColorChannels(numComponents) : 0;
+		const auto numPixels = image.size() / 4;
+		pixels.resize(numPixels * numComponents);
+		for (size_t i = 0; i < numPixels; i++)
+		{
+			for (int c = 0; c < numComponents; c++)
+			{
+				const auto value = image[i * 4 + c];
+				if (c < numSRGBChannels) {
+					pixels[i * numComponents + c] = static_cast<unsigned char>(std::upper_bound(tables.thresholds, tables.thresholds + 255, value) - tables.thresholds);
+				}
+				else {
+					pixels[i * numComponents + c] = static_cast<unsigned char>(std::min(std::max(value * 255.0f + 0.5f, 0.0f), 255.0f));
+				}
+			}
+		}
+	}
+
+} // namespace
+
+std::string getCookedTexturePath(const std::string& directory, const std::string& sourcePath, bool isSRGB)
+{
+	auto fileName = sourcePath;
+	std::replace(fileName.begin(), fileName.end(), '/', '_');
+	std::replace(fileName.begin(), fileName.end(), '\\', '_');
+	std::replace(fileName.begin(), fileName.end(), ':', '_');
+	return directory + "/" + fileName + (isSRGB ? ".srgb" : ".linear") + COOKED_TEXTURE_EXTENSION;
+}
+
+bool isCookedTextureUpToDate(const std::string& texturePath, const std::string& sourcePath, bool compress)
+{
+	if (!TextureFile::isUpToDate(texturePath.c_str(), sourcePath.c_str())) {
+		return false;
+	}
+
+	TextureFile textureFile;
+	return textureFile.open(texturePath.c_str()) && (textureFile.getHeader().glFormat == 0) == compress;
+}
+
+bool cookTexture(const std::string& sourcePath, const std::string& texturePath, bool isSRGB, bool compress, CompressionQuality quality)
+{
+	FileInfo sourceInfo;
+	if (!getFileInfo(sourcePath.c_str(), true, sourceInfo))
+	{
+		std::cerr << "Could not read image " << sourcePath << " for cooking!" << std::endl;
+		return false;
+	}
+
+	int width, height, numComponents;
+	const auto sourcePixels = stbi_load(sourcePath.c_str(), &width, &height, &numComponents, 0);
+	if (sourcePixels == nullptr)
+	{
+		std::cerr << "Could not decode image " << sourcePath << " for cooking (" << stbi_failure_reason() << ")!" << std::endl;
+		return false;
+	}
+
+	TextureFileHeader header = {};
+	header.sourceHash = sourceInfo.hash;
+	header.sourceModificationTime = sourceInfo.modificationTime;
+	header.sourceSize = sourceInfo.size;
+	header.width = uint32_t(width);
+	header.height = uint32_t(height);
+	header.numComponents = uint32_t(numComponents);
+	header.glFormat = numComponents == 1 ? GL_RED : numComponents == 2 ? GL_RG : numComponents == 3 ? GL_RGB : GL_RGBA;
+	header.glInternalFormat = header.glFormat;
+	header.glType = GL_UNSIGNED_BYTE;
+	header.flags = isSRGB ? TextureFileHeader::SRGB_FILTERED : 0;
+
+	// Base level is the source image as it is, every further level is filtered from the previous
+	// one in linear floats (so that rounding errors don't accumulate down the chain)
+	std::vector<std::vector<unsigned char>> levels;
+	levels.emplace_back(sourcePixels, sourcePixels + size_t(width) * height * numComponents);
+	stbi_image_free(sourcePixels);
+
+	std::vector<float> image, smallerImage;
+	toLinearImage(levels[0].data(), size_t(width) * height, numComponents, isSRGB, image);
+	auto levelWidth = width, levelHeight = height;
+	while ((levelWidth > 1 || levelHeight > 1) && levels.size() < TextureFileHeader::MAX_LEVELS)
+	{
+		downsample(image, levelWidth, levelHeight, smallerImage);
+		image.swap(smallerImage);
+		levelWidth = std::max(levelWidth / 2, 1);
+		levelHeight = std::max(levelHeight / 2, 1);
+		levels.emplace_back();
+		toPixels(image, numComponents, isSRGB, levels.back());
+	}
+
+	std::vector<const void*> levelData;
+	header.numLevels = uint32_t(levels.size());
+	for (uint32_t i = 0; i < header.numLevels; i++)
+	{
+		header.levels[i].width = std::max(header.width >> i, 1u);
+		header.levels[i].height = std::max(header.height >> i, 1u);
+		if (compress)
+		{
+			// Single thread per image, images are cooked in parallel by the texture loader's worker threads
+			const auto blockFormat = getBlockFormatForComponents(numComponents);
+			std::vector<unsigned char> blocks(getCompressedImageSize(header.levels[i].width, header.levels[i].height, blockFormat));
+			compressImage(levels[i].data(), header.levels[i].width, header.levels[i].height, numComponents, blockFormat, quality, blocks.data());
+			levels[i].swap(blocks);
+			header.glInternalFormat = getBlockFormatGLFormat(blockFormat);
+			header.glFormat = 0;
+			header.glType = 0;
+		}
+		header.levels[i].dataSize = levels[i].size();
+		levelData.push_back(levels[i].data());
+	}
+
+	return TextureFile::write(texturePath.c_str(), header, levelData.data());
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// STL
+#include <string>
+
+// Project
+#include "common/textureCompressor.hpp"
+
+/**
+ * Extension of cooked texture files.
+ */
+const char* const COOKED_TEXTURE_EXTENSION = ".tex";
+
+/**
+ * Gets path of the cooked texture file belonging to given source image. Directories of the source path
+ * become part of the file name and the color space is part of it too, so that every image has its own
+ * file in the flat cache directory for every color space it's used in.
+ *
+ * @param directory   Directory with cooked texture files
+ * @param sourcePath  Path to the source image
+ * @param isSRGB      Whether the image is cooked as sRGB
+ */
+std::string getCookedTexturePath(const std::string& directory, const std::string& sourcePath, bool isSRGB);
+
+/**
+ * Checks, if texture file is up to date with the source image (see TextureFile::isUpToDate) and stored
+ * with requested compression.
+ */
+bool isCookedTextureUpToDate(const std::string& texturePath, const std::string& sourcePath, bool compress);
+
+/**
+ * Cooks image into texture file (see AsyncTextureLoader::setCooking). Image is decoded once and stored with all its mipmap
+ * levels, so that loading it later is just mapping the file and uploading the levels. Mipmaps are
+ * box filtered (with 3 taps along odd dimensions), color channels of sRGB images in linear space.
+ *
+ * @param sourcePath   Path to the source image (any format stb_image can decode)
+ * @param texturePath  Path to the written texture file
+ * @param isSRGB       Whether color channels are sRGB encoded (false for data like specular or normal maps)
+ * @param compress     Whether to store levels block compressed (format by number of components, see getBlockFormatForComponents)
+ * @param quality      Compression quality (used only when compressing)
+ *
+ * @return True, if the image has been cooked successfully.
+ */
+bool cookTexture(const std::string& sourcePath, const std::string& texturePath, bool isSRGB = true,
+	bool compress = false, CompressionQuality quality = CompressionQuality::Normal);
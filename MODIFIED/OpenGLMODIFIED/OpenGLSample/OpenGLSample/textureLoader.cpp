@@ -0,0 +1,279 @@
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// STB
+#include "stb_image.h"
+
+// Project
+#include "textureLoader.h"
+#include "textureCooker.h"
+#include "common/fileUtils.h"
+#include "common/glState.h"
+#include "common/textureFile.h"
+
+AsyncTextureLoader::AsyncTextureLoader(unsigned int numThreads)
+{
+	if (numThreads == 0) {
+		numThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	}
+
+	for (unsigned int i = 0; i < numThreads; i++) {
+		_workers.emplace_back(&AsyncTextureLoader::workerLoop, this);
+	}
+}
+
+AsyncTextureLoader::~AsyncTextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(_jobsMutex);
+		_isStopping = true;
+	}
+	_jobsCondition.notify_all();
+	for (auto& worker : _workers) {
+		worker.join();
+	}
+
+	// Images, that were never uploaded
+	collectDecoded();
+	for (auto image : _uploadQueue) {
+		freeImage(image);
+	}
+	_uploadQueue.clear();
+}
+
+void AsyncTextureLoader::setCooking(const std::string& directory, bool compress, CompressionQuality quality)
+{
+	if (!directory.empty()) {
+		createDirectory(directory);
+	}
+	const auto isCompressionSupported = TextureFile::isFormatSupported(getBlockFormatGLFormat(BlockFormat::BC1))
+		&& TextureFile::isFormatSupported(getBlockFormatGLFormat(BlockFormat::BC3));
+	if (compress && !isCompressionSupported) {
+		std::cout << "EXT_texture_compression_s3tc is not supported, textures are cooked uncompressed" << std::endl;
+	}
+
+	std::lock_guard<std::mutex> lock(_jobsMutex);
+	_cooking.directory = directory;
+	_cooking.compress = compress && isCompressionSupported;
+	_cooking.quality = quality;
+}
+
+GLuint AsyncTextureLoader::load(const std::string& path, bool isSRGB)
+{
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+
+	// Neutral grey placeholder, it has no mipmaps so mipmapped filtering is turned on only with the real image
+	const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+	GLState::bindTexture(GL_TEXTURE_2D, textureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	_numPending++;
+	{
+		std::lock_guard<std::mutex> lock(_jobsMutex);
+		_jobs.push_back(DecodeJob{ textureID, path, isSRGB });
+	}
+	_jobsCondition.notify_one();
+
+	return textureID;
+}
+
+size_t AsyncTextureLoader::update(size_t maxUploadBytes, std::vector<LoadedTexture>* loadedTextures)
+{
+	collectDecoded();
+
+	size_t uploadedBytes = 0;
+	size_t numReady = 0;
+	while (!_uploadQueue.empty())
+	{
+		const auto image = _uploadQueue.front();
+		if (image->cookedFile && !image->cookedFile->isSupported())
+		{
+			// Compressed in a format the driver can't sample, the image is decoded and uploaded uncompressed instead
+			delete image->cookedFile;
+			image->cookedFile = nullptr;
+			image->pixels = stbi_load(image->path.c_str(), &image->width, &image->height, &image->numComponents, 0);
+		}
+
+		// At least one image is uploaded every update, even if it's over the budget
+		const auto imageBytes = image->cookedFile ? image->cookedFile->getDataSize() : size_t(image->width) * image->height * image->numComponents;
+		if (maxUploadBytes > 0 && uploadedBytes > 0 && uploadedBytes + imageBytes > maxUploadBytes) {
+			break;
+		}
+
+		_uploadQueue.pop_front();
+		if (image->cookedFile)
+		{
+			GLState::bindTexture(GL_TEXTURE_2D, image->textureID);
+			image->cookedFile->upload();
+			uploadedBytes += imageBytes;
+		}
+		else if (image->pixels)
+		{
+			upload(*image);
+			uploadedBytes += imageBytes;
+		}
+		else {
+			std::cout << "Texture failed to load at path: " << image->path << std::endl;
+		}
+		if (loadedTextures)
+		{
+			// Drivers store RGB textures padded to RGBA, full mipmap chain adds another third
+			const auto bytesPerPixel = size_t(image->numComponents == 3 ? 4 : image->numComponents);
+			const auto baseLevelSize = size_t(image->width) * image->height * bytesPerPixel;
+			const auto memorySize = image->cookedFile ? image->cookedFile->getDataSize() : image->pixels ? baseLevelSize + baseLevelSize / 3 : 0;
+			loadedTextures->push_back(LoadedTexture{ image->textureID, image->cookedFile || image->pixels, image->width, image->height, image->numComponents, memorySize });
+		}
+
+		freeImage(image);
+		_numPending--;
+		numReady++;
+	}
+
+	return numReady;
+}
+
+void AsyncTextureLoader::finishAll()
+{
+	update();
+	while (getNumPending() > 0)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		update();
+	}
+}
+
+size_t AsyncTextureLoader::getNumPending() const
+{
+	return _numPending;
+}
+
+void AsyncTextureLoader::deleteBuffers()
+{
+	if (_pixelBuffers[0] != 0)
+	{
+		GLState::deleteBuffers(NUM_PIXEL_BUFFERS, _pixelBuffers);
+		std::fill(_pixelBuffers, _pixelBuffers + NUM_PIXEL_BUFFERS, 0);
+	}
+}
+
+void AsyncTextureLoader::workerLoop()
+{
+	for (;;)
+	{
+		DecodeJob job;
+		CookingSettings cooking;
+		{
+			std::unique_lock<std::mutex> lock(_jobsMutex);
+			_jobsCondition.wait(lock, [this] { return _isStopping || !_jobs.empty(); });
+			if (_isStopping) {
+				return;
+			}
+
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+			cooking = _cooking;
+		}
+
+		auto image = new DecodedImage;
+		image->textureID = job.textureID;
+		image->path = std::move(job.path);
+		decode(*image, job.isSRGB, cooking);
+		pushDecoded(image);
+	}
+}
+
+void AsyncTextureLoader::decode(DecodedImage& image, bool isSRGB, const CookingSettings& cooking)
+{
+	// First load of an image cooks it, later loads (also in later launches) just map the cooked file
+	const auto cookedPath = cooking.directory.empty() ? std::string() : getCookedTexturePath(cooking.directory, image.path, isSRGB);
+	if (!cookedPath.empty() && (isCookedTextureUpToDate(cookedPath, image.path, cooking.compress)
+		|| cookTexture(image.path, cookedPath, isSRGB, cooking.compress, cooking.quality)))
+	{
+		auto cookedFile = new TextureFile;
+		if (cookedFile->open(cookedPath.c_str()))
+		{
+			const auto& header = cookedFile->getHeader();
+			image.cookedFile = cookedFile;
+			image.width = int(header.width);
+			image.height = int(header.height);
+			image.numComponents = int(header.numComponents);
+			return;
+		}
+		delete cookedFile;
+	}
+
+	image.pixels = stbi_load(image.path.c_str(), &image.width, &image.height, &image.numComponents, 0);
+}
+
+void AsyncTextureLoader::pushDecoded(DecodedImage* image)
+{
+	image->next = _decodedHead.load(std::memory_order_relaxed);
+	while (!_decodedHead.compare_exchange_weak(image->next, image, std::memory_order_release, std::memory_order_relaxed)) {}
+}
+
+void AsyncTextureLoader::collectDecoded()
+{
+	// Whole stack is taken at once, it holds the newest image first, so it's reversed to keep decoding order
+	std::vector<DecodedImage*> newestFirst;
+	for (auto image = _decodedHead.exchange(nullptr, std::memory_order_acquire); image != nullptr; image = image->next) {
+		newestFirst.push_back(image);
+	}
+	_uploadQueue.insert(_uploadQueue.end(), newestFirst.rbegin(), newestFirst.rend());
+}
+
+void AsyncTextureLoader::upload(const DecodedImage& image)
+{
+	if (_pixelBuffers[0] == 0) {
+		glGenBuffers(NUM_PIXEL_BUFFERS, _pixelBuffers);
+	}
+
+	GLenum format = GL_RGBA;
+	if (image.numComponents == 1)
+		format = GL_RED;
+	else if (image.numComponents == 2)
+		format = GL_RG;
+	else if (image.numComponents == 3)
+		format = GL_RGB;
+
+	// Buffer storage is orphaned first, so that writing doesn't wait for the GPU to finish previous upload from it
+	const auto imageBytes = size_t(image.width) * image.height * image.numComponents;
+	GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, _pixelBuffers[_nextPixelBuffer]);
+	_nextPixelBuffer = (_nextPixelBuffer + 1) % NUM_PIXEL_BUFFERS;
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, imageBytes, nullptr, GL_STREAM_DRAW);
+	const void* pixelSource = nullptr; // Offset 0 in the bound pixel buffer
+	auto mappedBuffer = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, imageBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mappedBuffer != nullptr) {
+		memcpy(mappedBuffer, image.pixels, imageBytes);
+	}
+	if (mappedBuffer == nullptr || glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+	{
+		// Mapping failed, upload straight from the decoded image instead
+		GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		pixelSource = image.pixels;
+	}
+
+	// Rows of decoded images are tightly packed
+	GLState::bindTexture(GL_TEXTURE_2D, image.textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, pixelSource);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+}
+
+void AsyncTextureLoader::freeImage(DecodedImage* image)
+{
+	stbi_image_free(image->pixels);
+	delete image->cookedFile;
+	delete image;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+// STL
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// Project
+#include "common/textureCompressor.hpp"
+
+class TextureFile;
+
+/**
+ * Loads 2D textures asynchronously. load() creates the texture with a 1x1 placeholder image and
+ * returns its ID immediately, image files are decoded by a pool of worker threads and decoded images
+ * are handed back to the OpenGL thread through a lock-free queue. update() (called every frame on the
+ * OpenGL thread) uploads them through pixel buffer objects into the same texture, so the returned
+ * ID stays valid and shows the real image once it's ready.
+ * With cooking enabled, images without an up to date cooked texture file are cooked (see cookTexture)
+ * by the worker threads the first time they are loaded. Images with one are not decoded at all,
+ * the file is mapped and its mipmap levels are uploaded as they are.
+ */
+class AsyncTextureLoader
+{
+public:
+	/**
+	 * Texture, that has been processed by update().
+	 */
+	struct LoadedTexture
+	{
+		GLuint textureID; // OpenGL texture ID returned by load()
+		bool isLoaded; // False, if the image could not be decoded (texture keeps the placeholder)
+		int width; // Image width
+		int height; // Image height
+		int numComponents; // Number of color components (1-4)
+		size_t memorySize; // Video memory taken by all levels (exact for cooked textures, estimated otherwise)
+	};
+
+	/**
+	 * Starts the decoding threads.
+	 *
+	 * @param numThreads  Number of decoding threads (0 = one less than hardware threads, at least one)
+	 */
+	explicit AsyncTextureLoader(unsigned int numThreads = 0);
+
+	/**
+	 * Stops the decoding threads. Textures themselves are not deleted, deleteBuffers() must be called
+	 * while OpenGL context is still alive.
+	 */
+	~AsyncTextureLoader();
+
+	AsyncTextureLoader(const AsyncTextureLoader&) = delete;
+	AsyncTextureLoader& operator=(const AsyncTextureLoader&) = delete;
+
+	/**
+	 * Enables cooking of loaded images into texture files in given directory (created if missing), so that
+	 * later launches just map them. Cooking is disabled by default, images are then always decoded.
+	 * Compression is turned off, if the driver can't sample BC1/BC3 textures (OpenGL thread only).
+	 *
+	 * @param directory  Directory of the cooked texture files ("" = cooking disabled)
+	 * @param compress   Whether to store levels block compressed
+	 * @param quality    Compression quality (used only when compressing)
+	 */
+	void setCooking(const std::string& directory, bool compress, CompressionQuality quality = CompressionQuality::Normal);
+
+	/**
+	 * Creates texture with placeholder image and queues the image file for decoding (OpenGL thread only).
+	 *
+	 * @param path    Path to the image file
+	 * @param isSRGB  Whether color channels are sRGB encoded (false for data like specular or normal maps),
+	 *                mipmaps of cooked sRGB textures are filtered in linear space
+	 *
+	 * @return OpenGL texture ID, usable right away.
+	 */
+	GLuint load(const std::string& path, bool isSRGB = true);
+
+	/**
+	 * Uploads decoded images to their textures (OpenGL thread only, once per frame).
+	 *
+	 * @param maxUploadBytes  Upload budget, once exceeded the rest waits for the next update (0 = no limit)
+	 * @param loadedTextures  If not nullptr, textures processed by this update are appended to it
+	 *
+	 * @return Number of textures, that became ready.
+	 */
+	size_t update(size_t maxUploadBytes = 0, std::vector<LoadedTexture>* loadedTextures = nullptr);
+
+	/**
+	 * Blocks until all queued images are decoded and uploaded (OpenGL thread only).
+	 */
+	void finishAll();
+
+	/**
+	 * Gets number of textures, that are still showing the placeholder.
+	 */
+	size_t getNumPending() const;
+
+	/**
+	 * Deletes pixel buffer objects used for uploading (textures are owned by the caller).
+	 */
+	void deleteBuffers();
+
+private:
+	/**
+	 * Image decoded on a worker thread, waiting for upload (node of the lock-free queue).
+	 */
+	struct DecodedImage
+	{
+		GLuint textureID = 0; // Texture the image belongs to
+		std::string path; // Path to the image file (for error messages)
+		unsigned char* pixels = nullptr; // Decoded pixels (nullptr if decoding failed), freed with stbi_image_free
+		int width = 0; // Image width
+		int height = 0; // Image height
+		int numComponents = 0; // Number of color components (1-4)
+		TextureFile* cookedFile = nullptr; // Mapped cooked texture file (used instead of pixels, if present)
+		DecodedImage* next = nullptr; // Next image in the queue
+	};
+
+	/**
+	 * Request to decode image file.
+	 */
+	struct DecodeJob
+	{
+		GLuint textureID; // Texture the image belongs to
+		std::string path; // Path to the image file
+		bool isSRGB; // Whether color channels are sRGB encoded
+	};
+
+	/**
+	 * Where and how images are cooked.
+	 */
+	struct CookingSettings
+	{
+		std::string directory; // Directory of the cooked texture files ("" = cooking disabled)
+		bool compress = false; // Whether to store levels block compressed
+		CompressionQuality quality = CompressionQuality::Normal; // Compression quality
+	};
+
+	static const int NUM_PIXEL_BUFFERS = 2; // Pixel buffer objects used in turns
+
+	std::vector<std::thread> _workers; // Decoding threads
+	std::deque<DecodeJob> _jobs; // Files waiting for decoding
+	CookingSettings _cooking; // Cooking of loaded images (guarded by _jobsMutex)
+	std::mutex _jobsMutex; // Guards _jobs, _cooking and _isStopping
+	std::condition_variable _jobsCondition; // Wakes up workers, when there's a job or loader is stopping
+	bool _isStopping = false; // Tells workers to quit
+
+	std::atomic<DecodedImage*> _decodedHead{ nullptr }; // Lock-free stack of decoded images (newest first)
+	std::deque<DecodedImage*> _uploadQueue; // Decoded images in decoding order, waiting for upload (OpenGL thread only)
+	std::atomic<size_t> _numPending{ 0 }; // Number of textures waiting for decoding or upload
+
+	GLuint _pixelBuffers[NUM_PIXEL_BUFFERS] = {}; // Pixel buffer objects for uploading
+	int _nextPixelBuffer = 0; // Pixel buffer object used for the next upload
+
+	/**
+	 * Decodes queued files until the loader is stopping (worker thread).
+	 */
+	void workerLoop();
+
+	/**
+	 * Pushes decoded image to the lock-free queue (any thread).
+	 */
+	void pushDecoded(DecodedImage* image);
+
+	/**
+	 * Moves all decoded images from the lock-free queue to the upload queue (OpenGL thread).
+	 */
+	void collectDecoded();
+
+	/**
+	 * Maps cooked texture file of the image (cooking it first, if it's not up to date), or decodes
+	 * the image file if cooking is disabled or fails (worker thread).
+	 */
+	static void decode(DecodedImage& image, bool isSRGB, const CookingSettings& cooking);
+
+	/**
+	 * Uploads decoded image into its texture through a pixel buffer object (OpenGL thread).
+	 */
+	void upload(const DecodedImage& image);
+
+	/**
+	 * Frees image and everything it holds.
+	 */
+	static void freeImage(DecodedImage* image);
+};